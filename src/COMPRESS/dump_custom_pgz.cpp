@@ -0,0 +1,372 @@
+/* ----------------------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   http://lammps.sandia.gov, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#include "dump_custom_pgz.h"
+#include "comm.h"
+#include "domain.h"
+#include "error.h"
+#include "force.h"
+#include "memory.h"
+#include "update.h"
+
+#include <cstring>
+#include <pthread.h>
+#include <zlib.h>
+
+using namespace LAMMPS_NS;
+
+#define BLOCKSIZE 1048576
+#define MINBLOCK 4096
+
+struct PGZThread {
+  DumpCustomPGZ *dump;
+  int tid;
+};
+
+/* ----------------------------------------------------------------------
+   binary dump custom output compressed in-process by several threads,
+   the byte stream is cut into blocks that are deflated independently
+   and written as consecutive gzip members, so the file is a regular
+   gzip file holding the same records as a dump custom *.bin file
+------------------------------------------------------------------------- */
+
+DumpCustomPGZ::DumpCustomPGZ(LAMMPS *lmp, int narg, char **arg) :
+  DumpCustom(lmp, narg, arg)
+{
+  if (!compressed)
+    error->all(FLERR,"Dump custom/pgz only writes compressed files");
+
+  // records are always written in the binary layout
+
+  binary = 1;
+
+  zfp = NULL;
+  nthreads = comm->nthreads;
+  level = Z_DEFAULT_COMPRESSION;
+  blocksize = BLOCKSIZE;
+
+  raw = NULL;
+  nraw = 0;
+  zbuf = NULL;
+  zmax = NULL;
+  zsize = NULL;
+  nblock = 0;
+  zerror = 0;
+}
+
+/* ---------------------------------------------------------------------- */
+
+DumpCustomPGZ::~DumpCustomPGZ()
+{
+  if (zfp) {
+    compress_blocks();
+    fclose(zfp);
+  }
+  zfp = NULL;
+  fp = NULL;
+  deallocate();
+}
+
+/* ----------------------------------------------------------------------
+   open the file of a snapshot, as in Dump::openfile(),
+   fp is left NULL so Dump::write() does not close the file before the
+   last blocks are compressed
+------------------------------------------------------------------------- */
+
+void DumpCustomPGZ::openfile()
+{
+  // single file, already opened, so just return
+
+  if (singlefile_opened) return;
+  if (multifile == 0) singlefile_opened = 1;
+
+  // if one file per timestep, replace '*' with current timestep
+
+  char *filecurrent = filename;
+  if (multiproc) filecurrent = multiname;
+
+  if (multifile) {
+    char *filestar = filecurrent;
+    filecurrent = new char[strlen(filestar) + 16];
+    char *ptr = strchr(filestar,'*');
+    *ptr = '\0';
+    if (padflag == 0)
+      sprintf(filecurrent,"%s" BIGINT_FORMAT "%s",
+              filestar,update->ntimestep,ptr+1);
+    else {
+      char bif[8],pad[16];
+      strcpy(bif,BIGINT_FORMAT);
+      sprintf(pad,"%%s%%0%d%s%%s",padflag,&bif[1]);
+      sprintf(filecurrent,pad,filestar,update->ntimestep,ptr+1);
+    }
+    *ptr = '*';
+    if (maxfiles > 0) {
+      if (numfiles < maxfiles) {
+        nameslist[numfiles] = new char[strlen(filecurrent)+1];
+        strcpy(nameslist[numfiles],filecurrent);
+        ++numfiles;
+      } else {
+        remove(nameslist[fileidx]);
+        delete[] nameslist[fileidx];
+        nameslist[fileidx] = new char[strlen(filecurrent)+1];
+        strcpy(nameslist[fileidx],filecurrent);
+        fileidx = (fileidx + 1) % maxfiles;
+      }
+    }
+  }
+
+  // each proc with filewriter = 1 opens a file
+  // appended gzip members still form a valid gzip file
+
+  if (filewriter) {
+    if (append_flag) zfp = fopen(filecurrent,"ab");
+    else zfp = fopen(filecurrent,"wb");
+
+    if (zfp == NULL) error->one(FLERR,"Cannot open dump file");
+  } else zfp = NULL;
+
+  // delete string with timestep replaced
+
+  if (multifile) delete [] filecurrent;
+}
+
+/* ----------------------------------------------------------------------
+   same header as DumpCustom::header_binary() and header_binary_triclinic()
+------------------------------------------------------------------------- */
+
+void DumpCustomPGZ::write_header(bigint ndump)
+{
+  append(&update->ntimestep,sizeof(bigint));
+  append(&ndump,sizeof(bigint));
+  append(&domain->triclinic,sizeof(int));
+  append(&domain->boundary[0][0],6*sizeof(int));
+  append(&boxxlo,sizeof(double));
+  append(&boxxhi,sizeof(double));
+  append(&boxylo,sizeof(double));
+  append(&boxyhi,sizeof(double));
+  append(&boxzlo,sizeof(double));
+  append(&boxzhi,sizeof(double));
+  if (domain->triclinic) {
+    append(&boxxy,sizeof(double));
+    append(&boxxz,sizeof(double));
+    append(&boxyz,sizeof(double));
+  }
+  append(&size_one,sizeof(int));
+  if (multiproc) append(&nclusterprocs,sizeof(int));
+  else append(&nprocs,sizeof(int));
+}
+
+/* ----------------------------------------------------------------------
+   same chunk as DumpCustom::write_binary()
+------------------------------------------------------------------------- */
+
+void DumpCustomPGZ::write_data(int n, double *mybuf)
+{
+  n *= size_one;
+  append(&n,sizeof(int));
+  append(mybuf,(bigint) n*sizeof(double));
+}
+
+/* ---------------------------------------------------------------------- */
+
+void DumpCustomPGZ::write()
+{
+  DumpCustom::write();
+  if (filewriter && zfp) {
+    compress_blocks();
+    if (multifile) {
+      fclose(zfp);
+      zfp = NULL;
+    } else if (flush_flag) fflush(zfp);
+  }
+}
+
+/* ---------------------------------------------------------------------- */
+
+int DumpCustomPGZ::modify_param(int narg, char **arg)
+{
+  if (strcmp(arg[0],"threads") == 0) {
+    if (narg < 2) error->all(FLERR,"Illegal dump_modify command");
+    int n = force->inumeric(FLERR,arg[1]);
+    if (n < 1) error->all(FLERR,"Illegal dump_modify command");
+    deallocate();
+    nthreads = n;
+    return 2;
+  } else if (strcmp(arg[0],"blocksize") == 0) {
+    if (narg < 2) error->all(FLERR,"Illegal dump_modify command");
+    bigint n = force->bnumeric(FLERR,arg[1]);
+    if (n < MINBLOCK || n > MAXSMALLINT)
+      error->all(FLERR,"Illegal dump_modify command");
+    deallocate();
+    blocksize = n;
+    return 2;
+  } else if (strcmp(arg[0],"compression_level") == 0) {
+    if (narg < 2) error->all(FLERR,"Illegal dump_modify command");
+    int n = force->inumeric(FLERR,arg[1]);
+    if (n < 0 || n > 9) error->all(FLERR,"Illegal dump_modify command");
+    level = n;
+    return 2;
+  }
+
+  return DumpCustom::modify_param(narg,arg);
+}
+
+/* ----------------------------------------------------------------------
+   copy bytes into the raw buffer, compressing it whenever it holds
+   one full block for each thread
+------------------------------------------------------------------------- */
+
+void DumpCustomPGZ::append(const void *data, bigint n)
+{
+  if (raw == NULL) allocate();
+
+  const char *ptr = (const char *) data;
+  bigint maxraw = nthreads * blocksize;
+  while (n > 0) {
+    bigint m = MIN(n,maxraw-nraw);
+    memcpy(&raw[nraw],ptr,m);
+    nraw += m;
+    ptr += m;
+    n -= m;
+    if (nraw == maxraw) compress_blocks();
+  }
+}
+
+/* ----------------------------------------------------------------------
+   deflate the blocks of raw on nthreads threads, this thread included,
+   and write the gzip members in order
+------------------------------------------------------------------------- */
+
+void DumpCustomPGZ::compress_blocks()
+{
+  if (nraw == 0) return;
+
+  nblock = (nraw + blocksize - 1) / blocksize;
+  zerror = 0;
+
+  int nextra = MIN(nthreads,nblock) - 1;
+  pthread_t *threads = new pthread_t[nextra];
+  PGZThread *args = new PGZThread[nextra+1];
+  for (int t = 0; t <= nextra; t++) {
+    args[t].dump = this;
+    args[t].tid = t;
+  }
+  for (int t = 0; t < nextra; t++)
+    pthread_create(&threads[t],NULL,&DumpCustomPGZ::compress_loop,&args[t+1]);
+  compress_loop(&args[0]);
+  for (int t = 0; t < nextra; t++)
+    pthread_join(threads[t],NULL);
+  delete [] threads;
+  delete [] args;
+
+  if (zerror) error->one(FLERR,"Dump custom/pgz compression failed");
+
+  for (int b = 0; b < nblock; b++)
+    if (fwrite(zbuf[b],1,zsize[b],zfp) != (size_t) zsize[b])
+      error->one(FLERR,"Dump custom/pgz cannot write to file");
+
+  nraw = 0;
+  nblock = 0;
+}
+
+/* ---------------------------------------------------------------------- */
+
+void *DumpCustomPGZ::compress_loop(void *ptr)
+{
+  PGZThread *arg = (PGZThread *) ptr;
+  DumpCustomPGZ *dump = arg->dump;
+
+  for (int b = arg->tid; b < dump->nblock; b += dump->nthreads)
+    dump->compress_block(b);
+
+  return NULL;
+}
+
+/* ----------------------------------------------------------------------
+   deflate block b as a complete gzip member into zbuf[b],
+   zbuf[b] is sized by deflateBound() so a single Z_FINISH call suffices
+------------------------------------------------------------------------- */
+
+void DumpCustomPGZ::compress_block(int b)
+{
+  bigint offset = b * blocksize;
+  uLong n = MIN(blocksize,nraw-offset);
+
+  z_stream strm;
+  strm.zalloc = Z_NULL;
+  strm.zfree = Z_NULL;
+  strm.opaque = Z_NULL;
+  if (deflateInit2(&strm,level,Z_DEFLATED,15+16,8,Z_DEFAULT_STRATEGY) != Z_OK) {
+    zerror = 1;
+    return;
+  }
+
+  // gzip header and trailer are not included in deflateBound()
+
+  bigint bound = deflateBound(&strm,n) + 32;
+  if (bound > zmax[b]) {
+    zmax[b] = bound;
+    memory->sfree(zbuf[b]);
+    zbuf[b] = (char *) memory->smalloc(zmax[b],"dump:zbuf");
+  }
+
+  strm.next_in = (Bytef *) &raw[offset];
+  strm.avail_in = n;
+  strm.next_out = (Bytef *) zbuf[b];
+  strm.avail_out = zmax[b];
+  if (deflate(&strm,Z_FINISH) != Z_STREAM_END) zerror = 1;
+  zsize[b] = zmax[b] - strm.avail_out;
+  deflateEnd(&strm);
+}
+
+/* ---------------------------------------------------------------------- */
+
+void DumpCustomPGZ::allocate()
+{
+  raw = (char *) memory->smalloc(nthreads*blocksize,"dump:raw");
+  nraw = 0;
+  zbuf = new char*[nthreads];
+  zmax = new bigint[nthreads];
+  zsize = new bigint[nthreads];
+  for (int t = 0; t < nthreads; t++) {
+    zbuf[t] = NULL;
+    zmax[t] = zsize[t] = 0;
+  }
+}
+
+/* ---------------------------------------------------------------------- */
+
+void DumpCustomPGZ::deallocate()
+{
+  if (raw == NULL) return;
+  memory->sfree(raw);
+  for (int t = 0; t < nthreads; t++) memory->sfree(zbuf[t]);
+  delete [] zbuf;
+  delete [] zmax;
+  delete [] zsize;
+  raw = NULL;
+  zbuf = NULL;
+  zmax = zsize = NULL;
+}
+
+/* ---------------------------------------------------------------------- */
+
+bigint DumpCustomPGZ::memory_usage()
+{
+  bigint bytes = DumpCustom::memory_usage();
+  if (raw) {
+    bytes += nthreads * blocksize;
+    for (int t = 0; t < nthreads; t++) bytes += zmax[t];
+  }
+  return bytes;
+}
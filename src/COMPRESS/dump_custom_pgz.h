@@ -0,0 +1,90 @@
+/* -*- c++ -*- ----------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   http://lammps.sandia.gov, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#ifdef DUMP_CLASS
+
+DumpStyle(custom/pgz,DumpCustomPGZ)
+
+#else
+
+#ifndef LMP_DUMP_CUSTOM_PGZ_H
+#define LMP_DUMP_CUSTOM_PGZ_H
+
+#include "dump_custom.h"
+#include <cstdio>
+
+namespace LAMMPS_NS {
+
+class DumpCustomPGZ : public DumpCustom {
+ public:
+  DumpCustomPGZ(class LAMMPS *, int, char **);
+  virtual ~DumpCustomPGZ();
+  virtual bigint memory_usage();
+
+ protected:
+  FILE *zfp;            // file pointer for the compressed output stream
+  int nthreads;         // # of compression threads
+  int level;            // zlib compression level
+  bigint blocksize;     // uncompressed bytes per gzip member
+
+  char *raw;            // uncompressed bytes of up to nthreads blocks
+  bigint nraw;          // # of bytes in raw
+  char **zbuf;          // compressed member of each block
+  bigint *zmax;         // allocated bytes of each zbuf
+  bigint *zsize;        // # of bytes in each zbuf
+  int nblock;           // # of blocks being compressed
+  int zerror;           // set by a thread if deflate fails
+
+  virtual void openfile();
+  virtual void write_header(bigint);
+  virtual void write_data(int, double *);
+  virtual void write();
+  virtual int modify_param(int, char **);
+
+  void append(const void *, bigint);
+  void compress_blocks();
+  void compress_block(int);
+  void allocate();
+  void deallocate();
+  static void *compress_loop(void *);
+};
+
+}
+
+#endif
+#endif
+
+/* ERROR/WARNING messages:
+
+E: Dump custom/pgz only writes compressed files
+
+The dump custom/pgz output file name must have a .gz suffix.
+
+E: Cannot open dump file
+
+Self-explanatory.
+
+E: Illegal dump_modify command
+
+Self-explanatory.
+
+E: Dump custom/pgz compression failed
+
+Zlib could not compress a block of the dump, most likely because it ran
+out of memory.
+
+E: Dump custom/pgz cannot write to file
+
+The file system is full or the file was removed while it was open.
+
+*/
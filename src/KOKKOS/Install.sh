@@ -105,6 +105,8 @@ action domain_kokkos.cpp
 action domain_kokkos.h
 action fix_deform_kokkos.cpp
 action fix_deform_kokkos.h
+action fix_adhesion_kokkos.cpp fix_adhesion.cpp
+action fix_adhesion_kokkos.h fix_adhesion.h
 action fix_density_kokkos.cpp fix_density.cpp
 action fix_density_kokkos.h fix_density.h
 action fix_diffusion_reaction_kokkos.cpp
@@ -175,6 +177,8 @@ action fix_rx_kokkos.cpp fix_rx.cpp
 action fix_rx_kokkos.h fix_rx.h
 action fix_wall_gran_kokkos.cpp fix_wall_gran.cpp
 action fix_wall_gran_kokkos.h fix_wall_gran.h
+action fix_wall_adhesion_kokkos.cpp fix_wall_adhesion.cpp
+action fix_wall_adhesion_kokkos.h fix_wall_adhesion.h
 action gridcomm_kokkos.cpp gridcomm.cpp
 action gridcomm_kokkos.h gridcomm.h
 action grid_kokkos.cpp grid.cpp
@@ -0,0 +1,253 @@
+/* ----------------------------------------------------------------------
+ LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+ http://lammps.sandia.gov, Sandia National Laboratories
+ Steve Plimpton, sjplimp@sandia.gov
+
+ Copyright (2003) Sandia Corporation.  Under the terms of Contract
+ DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+ certain rights in this software.  This software is distributed under
+ the GNU General Public License.
+
+ See the README file in the top-level LAMMPS directory.
+ ------------------------------------------------------------------------- */
+
+#include <math.h>
+#include <string.h>
+#include "fix_adhesion_kokkos.h"
+#include "atom_kokkos.h"
+#include "atom_vec_kokkos.h"
+#include "neigh_list_kokkos.h"
+#include "pair_kokkos.h"
+#include "force.h"
+#include "pair.h"
+#include "error.h"
+#include "lammps.h"
+#include "kokkos.h"
+#include "atom_masks.h"
+
+using namespace LAMMPS_NS;
+using namespace FixConst;
+
+/* ---------------------------------------------------------------------- */
+
+template <class DeviceType>
+FixAdhesionKokkos<DeviceType>::FixAdhesionKokkos(LAMMPS *lmp, int narg, char **arg) :
+  FixAdhesion(lmp, narg, arg)
+{
+  kokkosable = 1;
+  execution_space = ExecutionSpaceFromDevice<DeviceType>::space;
+
+  datamask_read = X_MASK | F_MASK | TYPE_MASK | RADIUS_MASK;
+  datamask_modify = F_MASK;
+}
+
+/* ---------------------------------------------------------------------- */
+
+template <class DeviceType>
+void FixAdhesionKokkos<DeviceType>::init()
+{
+  FixAdhesion::init();
+
+  // copy Hamaker constants to device, they are only set by fix_modify
+  int n = atom->ntypes;
+  k_ah = typename AT::tdual_ffloat_2d("nufeb/adhesion:ah", n+1, n+1);
+  for (int i = 1; i <= n; i++)
+    for (int j = 1; j <= n; j++)
+      k_ah.h_view(i,j) = ah[i][j];
+  k_ah.template modify<LMPHostType>();
+  k_ah.template sync<DeviceType>();
+  d_ah = k_ah.template view<DeviceType>();
+}
+
+/* ---------------------------------------------------------------------- */
+
+template <class DeviceType>
+void FixAdhesionKokkos<DeviceType>::post_force(int vflag)
+{
+  // energy and virial setup
+  if (vflag) v_setup(vflag);
+  else evflag = 0;
+
+  if (vflag_atom)
+    error->all(FLERR,"Per-atom virial not supported by fix nufeb/adhesion/kk");
+
+  for (int i = 0; i < 6; i++)
+    virial[i] = 0.0;
+
+  NeighListKokkos<DeviceType>* k_list = static_cast<NeighListKokkos<DeviceType>*>(force->pair->list);
+  d_numneigh = k_list->d_numneigh;
+  d_neighbors = k_list->d_neighbors;
+  d_ilist = k_list->d_ilist;
+
+  d_x = atomKK->k_x.view<DeviceType>();
+  d_f = atomKK->k_f.view<DeviceType>();
+  d_type = atomKK->k_type.view<DeviceType>();
+  d_radius = atomKK->k_radius.view<DeviceType>();
+
+  nlocal = atom->nlocal;
+
+  atomKK->sync(execution_space,datamask_read);
+  atomKK->modified(execution_space,datamask_modify);
+
+  // the f array is duplicated for OpenMP with half/thread lists,
+  //   atomic for CUDA and neither for serial
+  need_dup = lmp->kokkos->need_dup<DeviceType>();
+  if (need_dup)
+    dup_f = Kokkos::Experimental::create_scatter_view<Kokkos::Experimental::ScatterSum, Kokkos::Experimental::ScatterDuplicated>(d_f);
+  else
+    ndup_f = Kokkos::Experimental::create_scatter_view<Kokkos::Experimental::ScatterSum, Kokkos::Experimental::ScatterNonDuplicated>(d_f);
+
+  copymode = 1;
+  int neighflag = lmp->kokkos->neighflag;
+  if (neighflag == HALF) {
+    if (force->newton_pair) compute_kokkos<HALF, 1>(evflag);
+    else compute_kokkos<HALF, 0>(evflag);
+  } else if (neighflag == HALFTHREAD) {
+    if (force->newton_pair) compute_kokkos<HALFTHREAD, 1>(evflag);
+    else compute_kokkos<HALFTHREAD, 0>(evflag);
+  } else {
+    if (force->newton_pair) compute_kokkos<FULL, 1>(evflag);
+    else compute_kokkos<FULL, 0>(evflag);
+  }
+  copymode = 0;
+
+  if (need_dup) {
+    Kokkos::Experimental::contribute(d_f, dup_f);
+    // free duplicated memory
+    dup_f = decltype(dup_f)();
+  }
+}
+
+/* ---------------------------------------------------------------------- */
+
+template <class DeviceType>
+template <int NEIGHFLAG, int NEWTON_PAIR>
+void FixAdhesionKokkos<DeviceType>::compute_kokkos(int vflag)
+{
+  int inum = force->pair->list->inum;
+  Functor f(this);
+
+  if (vflag) {
+    EV_FLOAT ev;
+    Kokkos::parallel_reduce(Kokkos::RangePolicy<DeviceType, FixAdhesionTag<NEIGHFLAG, NEWTON_PAIR, 1> >(0, inum), f, ev);
+    for (int i = 0; i < 6; i++)
+      virial[i] += ev.v[i];
+  } else {
+    Kokkos::parallel_for(Kokkos::RangePolicy<DeviceType, FixAdhesionTag<NEIGHFLAG, NEWTON_PAIR, 0> >(0, inum), f);
+  }
+}
+
+/* ---------------------------------------------------------------------- */
+
+template <class DeviceType>
+FixAdhesionKokkos<DeviceType>::Functor::Functor(FixAdhesionKokkos<DeviceType> *ptr):
+  nlocal(ptr->nlocal), smin(ptr->smin), smax(ptr->smax),
+  d_neighbors(ptr->d_neighbors), d_ilist(ptr->d_ilist), d_numneigh(ptr->d_numneigh),
+  d_x(ptr->d_x), d_type(ptr->d_type), d_radius(ptr->d_radius), d_ah(ptr->d_ah),
+  dup_f(ptr->dup_f), ndup_f(ptr->ndup_f) {}
+
+/* ---------------------------------------------------------------------- */
+
+template <class DeviceType>
+template <int NEIGHFLAG, int NEWTON_PAIR, int EVFLAG>
+KOKKOS_INLINE_FUNCTION
+void FixAdhesionKokkos<DeviceType>::Functor::operator()(FixAdhesionTag<NEIGHFLAG, NEWTON_PAIR, EVFLAG>, int ii, EV_FLOAT &ev) const
+{
+  auto v_f = ScatterViewHelper<NeedDup<NEIGHFLAG,DeviceType>::value,decltype(dup_f),decltype(ndup_f)>::get(dup_f,ndup_f);
+  auto a_f = v_f.template access<AtomicDup<NEIGHFLAG,DeviceType>::value>();
+
+  const int i = d_ilist[ii];
+  const int jnum = d_numneigh[i];
+
+  double xtmp = d_x(i,0);
+  double ytmp = d_x(i,1);
+  double ztmp = d_x(i,2);
+
+  int itype = d_type[i];
+  double radi = d_radius[i];
+
+  double fx = 0.0;
+  double fy = 0.0;
+  double fz = 0.0;
+  for (int jj = 0; jj < jnum; jj++) {
+    int j = d_neighbors(i,jj);
+    j &= NEIGHMASK;
+
+    double delx = xtmp - d_x(j,0);
+    double dely = ytmp - d_x(j,1);
+    double delz = ztmp - d_x(j,2);
+    double rsq = delx * delx + dely * dely + delz * delz;
+
+    int jtype = d_type[j];
+    double radj = d_radius[j];
+    double radsum = radi + radj;
+
+    if (rsq < (radsum + smax)*(radsum + smax)) {
+      double r = sqrt(rsq);
+      double del = r - radsum;
+      double ccel = 0;
+      if (del > smin) {
+	double first = del*del+2*radi*del+2*radj*del;
+	double second = del*del+2*radi*del+2*radj*del+4*radi*radj;
+	ccel = -(d_ah(itype,jtype)*64*radi*radi*radi*radj*radj*radj*(del+radsum)) / (6.0*first*first*second*second);
+      } else if (del >= 0 && del <= smin) {
+	double first = smin*smin+2*radi*smin+2*radj*smin;
+	double second = smin*smin+2*radi*smin+2*radj*smin+4*radi*radj;
+	ccel = -(d_ah(itype,jtype)*64*radi*radi*radi*radj*radj*radj*(del+radsum)) / (6.0*first*first*second*second);
+      }
+
+      double rinv = 1/r;
+
+      double ccelx = delx*ccel*rinv;
+      double ccely = dely*ccel*rinv;
+      double ccelz = delz*ccel*rinv;
+
+      fx += ccelx;
+      fy += ccely;
+      fz += ccelz;
+
+      if ((NEIGHFLAG==HALF || NEIGHFLAG==HALFTHREAD) && (NEWTON_PAIR || j < nlocal)) {
+	a_f(j,0) -= ccelx;
+	a_f(j,1) -= ccely;
+	a_f(j,2) -= ccelz;
+      }
+
+      if (EVFLAG) {
+	// pairs are visited twice by full lists and by both procs
+	//   when j is a ghost with newton off
+	double factor = 1.0;
+	if (NEIGHFLAG == FULL || (!NEWTON_PAIR && j >= nlocal)) factor = 0.5;
+	ev.v[0] += factor*delx*ccelx;
+	ev.v[1] += factor*dely*ccely;
+	ev.v[2] += factor*delz*ccelz;
+	ev.v[3] += factor*delx*ccely;
+	ev.v[4] += factor*delx*ccelz;
+	ev.v[5] += factor*dely*ccelz;
+      }
+    }
+  }
+
+  a_f(i,0) += fx;
+  a_f(i,1) += fy;
+  a_f(i,2) += fz;
+}
+
+/* ---------------------------------------------------------------------- */
+
+template <class DeviceType>
+template <int NEIGHFLAG, int NEWTON_PAIR, int EVFLAG>
+KOKKOS_INLINE_FUNCTION
+void FixAdhesionKokkos<DeviceType>::Functor::operator()(FixAdhesionTag<NEIGHFLAG, NEWTON_PAIR, EVFLAG>, int ii) const
+{
+  EV_FLOAT ev;
+  this->template operator()<NEIGHFLAG, NEWTON_PAIR, EVFLAG>(FixAdhesionTag<NEIGHFLAG, NEWTON_PAIR, EVFLAG>(), ii, ev);
+}
+
+/* ---------------------------------------------------------------------- */
+
+namespace LAMMPS_NS {
+template class FixAdhesionKokkos<LMPDeviceType>;
+#ifdef KOKKOS_ENABLE_CUDA
+template class FixAdhesionKokkos<LMPHostType>;
+#endif
+}
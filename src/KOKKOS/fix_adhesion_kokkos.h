@@ -0,0 +1,107 @@
+/* ----------------------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   http://lammps.sandia.gov, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#ifdef FIX_CLASS
+
+FixStyle(nufeb/adhesion/kk,FixAdhesionKokkos<LMPDeviceType>)
+FixStyle(nufeb/adhesion/kk/device,FixAdhesionKokkos<LMPDeviceType>)
+FixStyle(nufeb/adhesion/kk/host,FixAdhesionKokkos<LMPHostType>)
+
+#else
+
+#ifndef LMP_FIX_ADHESION_KOKKOS_H
+#define LMP_FIX_ADHESION_KOKKOS_H
+
+#include "fix_adhesion.h"
+#include "kokkos_type.h"
+
+namespace LAMMPS_NS {
+
+template <int, int, int>
+struct FixAdhesionTag {};
+
+template <class DeviceType>
+class FixAdhesionKokkos : public FixAdhesion {
+ public:
+  FixAdhesionKokkos(class LAMMPS *, int, char **);
+  ~FixAdhesionKokkos() {}
+  void init();
+  virtual void post_force(int);
+
+  struct Functor
+  {
+    int nlocal;
+    double smin;
+    double smax;
+
+    typedef ArrayTypes<DeviceType> AT;
+    typename AT::t_neighbors_2d d_neighbors;
+    typename AT::t_int_1d_randomread d_ilist;
+    typename AT::t_int_1d_randomread d_numneigh;
+    typename AT::t_x_array d_x;
+    typename AT::t_int_1d d_type;
+    typename AT::t_float_1d d_radius;
+    typename AT::t_ffloat_2d d_ah;
+
+    Kokkos::Experimental::ScatterView<F_FLOAT*[3], typename DAT::t_f_array::array_layout,DeviceType,Kokkos::Experimental::ScatterSum,Kokkos::Experimental::ScatterDuplicated> dup_f;
+    Kokkos::Experimental::ScatterView<F_FLOAT*[3], typename DAT::t_f_array::array_layout,DeviceType,Kokkos::Experimental::ScatterSum,Kokkos::Experimental::ScatterNonDuplicated> ndup_f;
+
+    Functor(FixAdhesionKokkos *ptr);
+
+    template <int NEIGHFLAG, int NEWTON_PAIR, int EVFLAG>
+    KOKKOS_INLINE_FUNCTION
+    void operator()(FixAdhesionTag<NEIGHFLAG, NEWTON_PAIR, EVFLAG>, int, EV_FLOAT &) const;
+
+    template <int NEIGHFLAG, int NEWTON_PAIR, int EVFLAG>
+    KOKKOS_INLINE_FUNCTION
+    void operator()(FixAdhesionTag<NEIGHFLAG, NEWTON_PAIR, EVFLAG>, int) const;
+  };
+
+ private:
+  int nlocal;
+  int need_dup;
+
+  typedef ArrayTypes<DeviceType> AT;
+
+  // for neighbor list lookup
+  typename AT::t_neighbors_2d d_neighbors;
+  typename AT::t_int_1d_randomread d_ilist;
+  typename AT::t_int_1d_randomread d_numneigh;
+
+  typename AT::t_x_array d_x;
+  typename AT::t_f_array d_f;
+  typename AT::t_int_1d d_type;
+  typename AT::t_float_1d d_radius;
+
+  typename AT::tdual_ffloat_2d k_ah;
+  typename AT::t_ffloat_2d d_ah;
+
+  Kokkos::Experimental::ScatterView<F_FLOAT*[3], typename DAT::t_f_array::array_layout,DeviceType,Kokkos::Experimental::ScatterSum,Kokkos::Experimental::ScatterDuplicated> dup_f;
+  Kokkos::Experimental::ScatterView<F_FLOAT*[3], typename DAT::t_f_array::array_layout,DeviceType,Kokkos::Experimental::ScatterSum,Kokkos::Experimental::ScatterNonDuplicated> ndup_f;
+
+  template <int NEIGHFLAG, int NEWTON_PAIR>
+  void compute_kokkos(int);
+};
+
+}
+
+#endif
+#endif
+
+/* ERROR/WARNING messages:
+
+E: Per-atom virial not supported by fix nufeb/adhesion/kk
+
+Only the global virial is accumulated on the device.
+
+*/
@@ -34,6 +34,9 @@ FixDiffusionReactionKokkos<DeviceType>::FixDiffusionReactionKokkos(LAMMPS *lmp,
   kokkosable = 1;
   execution_space = ExecutionSpaceFromDevice<DeviceType>::space;
   closed_system = FixDiffusionReaction::closed_system;
+  if (diff_style)
+    error->all(FLERR, "Biomass dependent diffusivity not yet supported by "
+	       "fix nufeb/diffusion_reaction/kk");
 }
 
 /* ---------------------------------------------------------------------- */
@@ -188,7 +191,7 @@ void FixDiffusionReactionKokkos<DeviceType>::closed_system_init()
 
   MPI_Allreduce(MPI_IN_PLACE, &result, 1, MPI_DOUBLE, MPI_SUM, world);
 
-  result /= (grid->box[0] * grid->box[1] * grid->box[2]);
+  result /= grid->ntotal;
 
   Kokkos::parallel_for(
     grid->ncells, LAMMPS_LAMBDA(int i) {
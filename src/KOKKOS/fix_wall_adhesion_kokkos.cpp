@@ -0,0 +1,131 @@
+/* ----------------------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   http://lammps.sandia.gov, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#include <cmath>
+#include <cstring>
+#include "fix_wall_adhesion_kokkos.h"
+#include "atom_kokkos.h"
+#include "atom_masks.h"
+
+using namespace LAMMPS_NS;
+using namespace FixConst;
+
+enum{XPLANE=0,YPLANE=1,ZPLANE=2,ZCYLINDER};
+
+/* ---------------------------------------------------------------------- */
+
+template <class DeviceType>
+FixWallAdhesionKokkos<DeviceType>::FixWallAdhesionKokkos(LAMMPS *lmp, int narg, char **arg) :
+  FixWallAdhesion(lmp, narg, arg)
+{
+  kokkosable = 1;
+  atomKK = (AtomKokkos *) atom;
+  execution_space = ExecutionSpaceFromDevice<DeviceType>::space;
+
+  datamask_read = X_MASK | F_MASK | MASK_MASK | RMASS_MASK | OUTER_MASS_MASK | OUTER_RADIUS_MASK;
+  datamask_modify = F_MASK;
+}
+
+/* ---------------------------------------------------------------------- */
+
+template <class DeviceType>
+void FixWallAdhesionKokkos<DeviceType>::post_force(int /*vflag*/)
+{
+  d_x = atomKK->k_x.view<DeviceType>();
+  d_f = atomKK->k_f.view<DeviceType>();
+  d_mask = atomKK->k_mask.view<DeviceType>();
+  d_rmass = atomKK->k_rmass.view<DeviceType>();
+  d_outer_mass = atomKK->k_outer_mass.view<DeviceType>();
+  d_outer_radius = atomKK->k_outer_radius.view<DeviceType>();
+
+  atomKK->sync(execution_space,datamask_read);
+  atomKK->modified(execution_space,datamask_modify);
+
+  copymode = 1;
+  Functor f(this);
+  Kokkos::parallel_for(Kokkos::RangePolicy<DeviceType>(0, atom->nlocal), f);
+  copymode = 0;
+}
+
+/* ---------------------------------------------------------------------- */
+
+template <class DeviceType>
+FixWallAdhesionKokkos<DeviceType>::Functor::Functor(FixWallAdhesionKokkos<DeviceType> *ptr):
+  groupbit(ptr->groupbit), eps_mask(ptr->eps_mask), wallstyle(ptr->wallstyle),
+  kn(ptr->kn), lo(ptr->lo), hi(ptr->hi), cylradius(ptr->cylradius),
+  d_x(ptr->d_x), d_f(ptr->d_f), d_mask(ptr->d_mask), d_rmass(ptr->d_rmass),
+  d_outer_mass(ptr->d_outer_mass), d_outer_radius(ptr->d_outer_radius) {}
+
+/* ---------------------------------------------------------------------- */
+
+template <class DeviceType>
+KOKKOS_INLINE_FUNCTION
+void FixWallAdhesionKokkos<DeviceType>::Functor::operator()(int i) const
+{
+  double eps_mass;
+  if (d_mask[i] & eps_mask)
+    eps_mass = d_rmass[i];
+  else
+    eps_mass = d_outer_mass[i];
+
+  if ((d_mask[i] & groupbit) && eps_mass > 0) {
+    double dx = 0.0;
+    double dy = 0.0;
+    double dz = 0.0;
+
+    if (wallstyle == XPLANE) {
+      double del1 = d_x(i,0) - lo;
+      double del2 = hi - d_x(i,0);
+      if (del1 < del2) dx = del1;
+      else dx = -del2;
+    } else if (wallstyle == YPLANE) {
+      double del1 = d_x(i,1) - lo;
+      double del2 = hi - d_x(i,1);
+      if (del1 < del2) dy = del1;
+      else dy = -del2;
+    } else if (wallstyle == ZPLANE) {
+      double del1 = d_x(i,2) - lo;
+      double del2 = hi - d_x(i,2);
+      if (del1 < del2) dz = del1;
+      else dz = -del2;
+    } else if (wallstyle == ZCYLINDER) {
+      double delxy = sqrt(d_x(i,0)*d_x(i,0) + d_x(i,1)*d_x(i,1));
+      double delr = cylradius - delxy;
+      if (delr > d_outer_radius[i]) dz = cylradius;
+      else {
+	dx = -delr/delxy * d_x(i,0);
+	dy = -delr/delxy * d_x(i,1);
+      }
+    }
+
+    double rsq = dx*dx + dy*dy + dz*dz;
+    if (rsq <= 2*d_outer_radius[i]*d_outer_radius[i]) {
+      double r = sqrt(rsq);
+      double rinv = 1.0/r;
+      double delta = d_outer_radius[i] - r;
+      double ccel = delta*kn*eps_mass;
+      d_f(i,0) += dx*ccel*rinv;
+      d_f(i,1) += dy*ccel*rinv;
+      d_f(i,2) += dz*ccel*rinv;
+    }
+  }
+}
+
+/* ---------------------------------------------------------------------- */
+
+namespace LAMMPS_NS {
+template class FixWallAdhesionKokkos<LMPDeviceType>;
+#ifdef KOKKOS_ENABLE_CUDA
+template class FixWallAdhesionKokkos<LMPHostType>;
+#endif
+}
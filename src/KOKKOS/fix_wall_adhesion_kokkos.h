@@ -0,0 +1,75 @@
+/* ----------------------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   http://lammps.sandia.gov, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#ifdef FIX_CLASS
+
+FixStyle(nufeb/wall_adhesion/kk,FixWallAdhesionKokkos<LMPDeviceType>)
+FixStyle(nufeb/wall_adhesion/kk/device,FixWallAdhesionKokkos<LMPDeviceType>)
+FixStyle(nufeb/wall_adhesion/kk/host,FixWallAdhesionKokkos<LMPHostType>)
+
+#else
+
+#ifndef LMP_FIX_WALL_ADHESION_KOKKOS_H
+#define LMP_FIX_WALL_ADHESION_KOKKOS_H
+
+#include "fix_wall_adhesion.h"
+#include "kokkos_type.h"
+
+namespace LAMMPS_NS {
+
+template <class DeviceType>
+class FixWallAdhesionKokkos : public FixWallAdhesion {
+ public:
+  FixWallAdhesionKokkos(class LAMMPS *, int, char **);
+  virtual ~FixWallAdhesionKokkos() {}
+  virtual void post_force(int);
+
+  struct Functor
+  {
+    int groupbit;
+    int eps_mask;
+    int wallstyle;
+    double kn;
+    double lo, hi, cylradius;
+
+    typedef ArrayTypes<DeviceType> AT;
+    typename AT::t_x_array d_x;
+    typename AT::t_f_array d_f;
+    typename AT::t_int_1d d_mask;
+    typename AT::t_float_1d d_rmass;
+    typename AT::t_float_1d d_outer_mass;
+    typename AT::t_float_1d d_outer_radius;
+
+    Functor(FixWallAdhesionKokkos *ptr);
+
+    KOKKOS_INLINE_FUNCTION
+    void operator()(int) const;
+  };
+
+ protected:
+  typedef ArrayTypes<DeviceType> AT;
+  typename AT::t_x_array d_x;
+  typename AT::t_f_array d_f;
+  typename AT::t_int_1d d_mask;
+  typename AT::t_float_1d d_rmass;
+  typename AT::t_float_1d d_outer_mass;
+  typename AT::t_float_1d d_outer_radius;
+};
+
+}
+
+#endif
+#endif
+
+/* ERROR/WARNING messages:
+*/
@@ -95,6 +95,19 @@ NufebRunKokkos::NufebRunKokkos(LAMMPS *lmp, int narg, char **arg) :
 
 void NufebRunKokkos::init()
 {
+  if (sor_flag)
+    error->all(FLERR, "Diffsolver sor is not supported by run_style nufeb/kk");
+  if (split_flag)
+    error->all(FLERR, "Diffreac strang is not supported by run_style nufeb/kk");
+  if (lazy_check)
+    error->all(FLERR, "Diffcheck lazy is not supported by run_style nufeb/kk");
+  if (perf)
+    error->all(FLERR, "Perf yes is not supported by run_style nufeb/kk");
+  if (memory_flag)
+    error->all(FLERR, "Memory yes is not supported by run_style nufeb/kk");
+  if (autotune_flag)
+    error->all(FLERR, "Autotune yes is not supported by run_style nufeb/kk");
+
   // this is required because many places check for verlet style
   delete [] update->integrate_style;
   update->integrate_style = new char[13];
@@ -140,6 +153,12 @@ void NufebRunKokkos::init()
     }
   }
 
+  // growth is updated every biological step
+  for (int i = 0; i < nfix_monod; i++) {
+    if (fix_monod[i]->growth_every > 1)
+      error->all(FLERR, "Fix nufeb/monod subcycle is not supported by run_style nufeb/kk");
+  }
+
   // create compute volume
   char **volarg = new char*[3];
   volarg[0] = (char *)"nufeb_volume";
@@ -0,0 +1,368 @@
+/* ----------------------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   http://lammps.sandia.gov, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#include "dump_grid_adios.h"
+#include "domain.h"
+#include "error.h"
+#include "grid.h"
+#include "group.h"
+#include "memory.h"
+#include "universe.h"
+#include "update.h"
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "adios2.h"
+
+using namespace LAMMPS_NS;
+
+enum { CONC, REAC, DENS, GROWTH };
+
+namespace LAMMPS_NS
+{
+class DumpGridADIOSInternal
+{
+
+public:
+    DumpGridADIOSInternal(){};
+    ~DumpGridADIOSInternal() = default;
+
+    // name of adios group, referrable in adios2_config.xml
+    const std::string ioName = "grid";
+    adios2::ADIOS *ad = nullptr; // adios object
+    adios2::IO io;     // adios group of variables and attributes in this dump
+    adios2::Engine fh; // adios file/stream handle object
+    bool defined = false;
+    // one global 3-D variable per field and substrate/group
+    std::vector<adios2::Variable<double>> vars;
+    // optional compression operator (dump_modify compress)
+    std::string opType;
+    adios2::Params opParams;
+};
+}
+
+/* ---------------------------------------------------------------------- */
+
+DumpGridADIOS::DumpGridADIOS(LAMMPS *lmp, int narg, char **arg)
+: Dump(lmp, narg, arg)
+{
+    if (narg < 6)
+        error->all(FLERR, "Illegal dump grid/adios command");
+
+    nfields = 0;
+    fields = new int[narg - 5];
+    for (int iarg = 5; iarg < narg; iarg++) {
+        if (strcmp(arg[iarg], "con") == 0)
+            fields[nfields++] = CONC;
+        else if (strcmp(arg[iarg], "rea") == 0)
+            fields[nfields++] = REAC;
+        else if (strcmp(arg[iarg], "den") == 0)
+            fields[nfields++] = DENS;
+        else if (strcmp(arg[iarg], "gro") == 0)
+            fields[nfields++] = GROWTH;
+        else
+            error->all(FLERR, "Illegal dump grid/adios command");
+    }
+
+    gbuf = NULL;
+    maxgbuf = 0;
+
+    internal = new DumpGridADIOSInternal();
+    internal->ad =
+        new adios2::ADIOS("adios2_config.xml", world, adios2::DebugON);
+}
+
+/* ---------------------------------------------------------------------- */
+
+DumpGridADIOS::~DumpGridADIOS()
+{
+    if (internal->fh) {
+        internal->fh.Close();
+    }
+    delete internal->ad;
+    delete internal;
+    delete[] fields;
+    memory->destroy(gbuf);
+}
+
+/* ---------------------------------------------------------------------- */
+
+void DumpGridADIOS::openfile()
+{
+    if (multifile) {
+        // if one file per timestep, replace '*' with current timestep
+        char *filestar = strdup(filename);
+        char *filecurrent = new char[strlen(filestar) + 16];
+        char *ptr = strchr(filestar, '*');
+        *ptr = '\0';
+        if (padflag == 0)
+            sprintf(filecurrent, "%s" BIGINT_FORMAT "%s", filestar,
+                    update->ntimestep, ptr + 1);
+        else {
+            char bif[8], pad[16];
+            strcpy(bif, BIGINT_FORMAT);
+            sprintf(pad, "%%s%%0%d%s%%s", padflag, &bif[1]);
+            sprintf(filecurrent, pad, filestar, update->ntimestep, ptr + 1);
+        }
+        internal->fh =
+            internal->io.Open(filecurrent, adios2::Mode::Write, world);
+        if (!internal->fh) {
+            char str[128];
+            sprintf(str, "Cannot open dump file %s", filecurrent);
+            error->one(FLERR, str);
+        }
+        free(filestar);
+        delete[] filecurrent;
+    } else {
+        if (!singlefile_opened) {
+            internal->fh =
+                internal->io.Open(filename, adios2::Mode::Write, world);
+            if (!internal->fh) {
+                char str[128];
+                sprintf(str, "Cannot open dump file %s", filename);
+                error->one(FLERR, str);
+            }
+            singlefile_opened = 1;
+        }
+    }
+}
+
+/* ---------------------------------------------------------------------- */
+
+void DumpGridADIOS::write()
+{
+    // selection of the owned cells, ghost cells are excluded
+    // ADIOS uses row-major order, so z is the slowest dimension
+
+    size_t start[3], count[3];
+    for (int i = 0; i < 3; i++) {
+        start[2 - i] = static_cast<size_t>(grid->sublo[i] + grid->ghost);
+        count[2 - i] = static_cast<size_t>(grid->subbox[i] - 2 * grid->ghost);
+    }
+    int nme = count[0] * count[1] * count[2];
+    if (2 * nme > maxgbuf) {
+        maxgbuf = 2 * nme;
+        memory->destroy(gbuf);
+        memory->create(gbuf, maxgbuf, "dump:gbuf");
+    }
+
+    openfile();
+    internal->fh.BeginStep();
+    if (me == 0) {
+        internal->fh.Put<uint64_t>("ntimestep", update->ntimestep);
+        internal->fh.Put<int>("nprocs", nprocs);
+    }
+
+    // data are copied by ADIOS in sync mode, which allows reusing gbuf
+
+    int v = 0;
+    for (int f = 0; f < nfields; f++) {
+        int n = (fields[f] == CONC || fields[f] == REAC) ? grid->nsubs
+                                                          : group->ngroup;
+        for (int j = 0; j < n; j++) {
+            adios2::Variable<double> &var = internal->vars[v++];
+            if (fields[f] == GROWTH) {
+                var.SetSelection({{start[0], start[1], start[2], 0},
+                                  {count[0], count[1], count[2], 2}});
+                pack_growth(grid->growth[j]);
+            } else {
+                var.SetSelection({{start[0], start[1], start[2]},
+                                  {count[0], count[1], count[2]}});
+                if (fields[f] == CONC)
+                    pack_scalar(grid->conc[j]);
+                else if (fields[f] == REAC)
+                    pack_scalar(grid->reac[j]);
+                else
+                    pack_scalar(grid->dens[j]);
+            }
+            internal->fh.Put<double>(var, gbuf, adios2::Mode::Sync);
+        }
+    }
+    internal->fh.EndStep(); // I/O will happen now...
+
+    if (multifile) {
+        internal->fh.Close();
+    }
+}
+
+/* ---------------------------------------------------------------------- */
+
+void DumpGridADIOS::pack_scalar(double *data)
+{
+    int m = 0;
+    int nx = grid->subbox[0];
+    int nxy = grid->subbox[0] * grid->subbox[1];
+    int g = grid->ghost;
+    for (int z = g; z < grid->subbox[2] - g; z++)
+        for (int y = g; y < grid->subbox[1] - g; y++)
+            for (int x = g; x < grid->subbox[0] - g; x++)
+                gbuf[m++] = data[x + y * nx + z * nxy];
+}
+
+/* ---------------------------------------------------------------------- */
+
+void DumpGridADIOS::pack_growth(double **data)
+{
+    int m = 0;
+    int nx = grid->subbox[0];
+    int nxy = grid->subbox[0] * grid->subbox[1];
+    int g = grid->ghost;
+    for (int z = g; z < grid->subbox[2] - g; z++)
+        for (int y = g; y < grid->subbox[1] - g; y++)
+            for (int x = g; x < grid->subbox[0] - g; x++) {
+                gbuf[m++] = data[x + y * nx + z * nxy][0];
+                gbuf[m++] = data[x + y * nx + z * nxy][1];
+            }
+}
+
+/* ---------------------------------------------------------------------- */
+
+void DumpGridADIOS::init_style()
+{
+    if (!grid || !grid->grid_exist)
+        error->all(FLERR, "No grid defined for dump grid/adios");
+
+    // remove % from filename since ADIOS always writes a global file with
+    // data/metadata
+    int len = strlen(filename);
+    char *ptr = strchr(filename, '%');
+    if (ptr) {
+        *ptr = '\0';
+        char *s = new char[len - 1];
+        sprintf(s, "%s%s", filename, ptr + 1);
+        strncpy(filename, s, len);
+        delete[] s;
+    }
+
+    // IO and variables can only be declared once, even for multiple runs
+    if (internal->defined)
+        return;
+
+    internal->io = internal->ad->DeclareIO(internal->ioName);
+    if (!internal->io.InConfigFile()) {
+        // if not defined by user, we can change the default settings
+        // BPFile is the default writer
+        internal->io.SetEngine("BPFile");
+        int num_aggregators = multiproc;
+        if (num_aggregators == 0)
+            num_aggregators = 1;
+        char nstreams[128];
+        sprintf(nstreams, "%d", num_aggregators);
+        internal->io.SetParameters({{"substreams", nstreams}});
+        if (me == 0 && screen)
+            fprintf(
+                screen,
+                "ADIOS method for %s is n-to-m (aggregation with %s writers)\n",
+                filename, nstreams);
+    }
+
+    define_variables();
+    internal->defined = true;
+}
+
+/* ---------------------------------------------------------------------- */
+
+void DumpGridADIOS::define_variables()
+{
+    internal->io.DefineVariable<uint64_t>("ntimestep");
+    internal->io.DefineVariable<int>("nprocs");
+
+    internal->io.DefineAttribute<double>("cell_size", grid->cell_size);
+    internal->io.DefineAttribute<double>("boxlo", domain->boxlo, 3);
+    internal->io.DefineAttribute<int>("box", grid->box, 3);
+
+    std::vector<std::string> subs(grid->sub_names,
+                                  grid->sub_names + grid->nsubs);
+    std::vector<std::string> groups(group->names,
+                                    group->names + group->ngroup);
+    internal->io.DefineAttribute<std::string>("substrates", subs.data(),
+                                              subs.size());
+    internal->io.DefineAttribute<std::string>("groups", groups.data(),
+                                              groups.size());
+    internal->io.DefineAttribute<std::string>("LAMMPS/dump_style", "grid");
+    internal->io.DefineAttribute<std::string>("LAMMPS/version",
+                                              universe->version);
+    internal->io.DefineAttribute<std::string>("LAMMPS/num_ver",
+                                              universe->num_ver);
+
+    adios2::Operator op;
+    bool compress = !internal->opType.empty();
+    if (compress)
+        op = internal->ad->DefineOperator("grid_compressor",
+                                          internal->opType);
+
+    // global cell counts, row-major (z, y, x)
+    size_t nz = static_cast<size_t>(grid->box[2]);
+    size_t ny = static_cast<size_t>(grid->box[1]);
+    size_t nx = static_cast<size_t>(grid->box[0]);
+
+    for (int f = 0; f < nfields; f++) {
+        const char *prefix;
+        char **names;
+        int n;
+        if (fields[f] == CONC || fields[f] == REAC) {
+            prefix = (fields[f] == CONC) ? "conc/" : "reac/";
+            names = grid->sub_names;
+            n = grid->nsubs;
+        } else {
+            prefix = (fields[f] == DENS) ? "dens/" : "growth/";
+            names = group->names;
+            n = group->ngroup;
+        }
+        for (int j = 0; j < n; j++) {
+            std::string name = std::string(prefix) + names[j];
+            adios2::Variable<double> var;
+            if (fields[f] == GROWTH)
+                var = internal->io.DefineVariable<double>(
+                    name, {nz, ny, nx, 2}, {0, 0, 0, 0}, {nz, ny, nx, 2});
+            else
+                var = internal->io.DefineVariable<double>(
+                    name, {nz, ny, nx}, {0, 0, 0}, {nz, ny, nx});
+            if (compress)
+                var.AddOperation(op, internal->opParams);
+            internal->vars.push_back(var);
+        }
+    }
+}
+
+/* ---------------------------------------------------------------------- */
+
+int DumpGridADIOS::modify_param(int narg, char **arg)
+{
+    if (strcmp(arg[0], "compress") == 0) {
+        if (narg < 2)
+            error->all(FLERR, "Illegal dump_modify command");
+        if (internal->defined)
+            error->all(FLERR,
+                       "Dump_modify compress must be set before the first run");
+        internal->opParams.clear();
+        if (strcmp(arg[1], "none") == 0) {
+            internal->opType.clear();
+            return 2;
+        }
+        // compress <operator> [<key>=<value> ...]
+        internal->opType = arg[1];
+        int iarg = 2;
+        while (iarg < narg) {
+            char *eq = strchr(arg[iarg], '=');
+            if (eq == NULL)
+                break;
+            internal->opParams[std::string(arg[iarg], eq - arg[iarg])] =
+                std::string(eq + 1);
+            iarg++;
+        }
+        return iarg;
+    }
+    return 0;
+}
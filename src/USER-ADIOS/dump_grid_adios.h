@@ -0,0 +1,78 @@
+/* -*- c++ -*- ----------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   http://lammps.sandia.gov, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#ifdef DUMP_CLASS
+// clang-format off
+DumpStyle(grid/adios, DumpGridADIOS)
+// clang-format on
+#else
+
+#ifndef LMP_DUMP_GRID_ADIOS_H
+#define LMP_DUMP_GRID_ADIOS_H
+
+#include "dump.h"
+
+namespace LAMMPS_NS
+{
+
+class DumpGridADIOSInternal;
+
+class DumpGridADIOS : public Dump
+{
+public:
+    DumpGridADIOS(class LAMMPS *, int, char **);
+    virtual ~DumpGridADIOS();
+
+protected:
+    virtual void openfile();
+    virtual void write();
+    virtual void init_style();
+    virtual int modify_param(int, char **);
+
+    void write_header(bigint) {}
+    void pack(tagint *) {}
+    void write_data(int, double *) {}
+
+private:
+    DumpGridADIOSInternal *internal;
+
+    int nfields;
+    int *fields;       // CONC, REAC, DENS or GROWTH
+    double *gbuf;      // owned cells of one variable, ghosts excluded
+    int maxgbuf;
+
+    void define_variables();
+    void pack_scalar(double *);
+    void pack_growth(double **);
+};
+}
+
+#endif
+#endif
+
+    /* ERROR/WARNING messages:
+
+    E: Cannot open dump file %s
+
+    The output file for the dump command cannot be opened.  Check that the
+    path and name are correct.
+
+    E: No grid defined for dump grid/adios
+
+    The dump requires a grid_style to be defined.
+
+    E: Illegal dump grid/adios command
+
+    Self-explanatory.  Valid fields are con, rea, den and gro.
+
+    */
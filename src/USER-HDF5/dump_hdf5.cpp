@@ -18,6 +18,7 @@
 #include "update.h"
 #include "grid.h"
 #include "grid_masks.h"
+#include "fix.h"
 
 #include <regex>
 #include <sstream>
@@ -25,6 +26,7 @@
 using namespace LAMMPS_NS;
 
 DumpHDF5::DumpHDF5(LAMMPS *lmp, int narg, char **arg) : Dump(lmp, narg, arg) {
+  fix_ave = NULL;
   parse_fields(narg, arg);
   setup();
 
@@ -34,12 +36,24 @@ DumpHDF5::DumpHDF5(LAMMPS *lmp, int narg, char **arg) : Dump(lmp, narg, arg) {
 
 DumpHDF5::~DumpHDF5() {}
 
+void DumpHDF5::init_style()
+{
+  fix_ave = NULL;
+  if (ave_id.empty()) return;
+  int ifix = modify->find_fix(ave_id.c_str());
+  if (ifix < 0)
+    error->all(FLERR, "Could not find dump nufeb/hdf5 fix ID");
+  if (strcmp(modify->fix[ifix]->style, "nufeb/ave/grid") != 0)
+    error->all(FLERR, "Dump nufeb/hdf5 ave requires fix nufeb/ave/grid");
+  fix_ave = modify->fix[ifix];
+}
+
 
 void DumpHDF5::setup()
 {
   for (int i = 0; i < 3; i++) {
-    subdims[i] = grid->subbox[i] - 2;
-    substart[i] = grid->sublo[i] + 1;
+    subdims[i] = grid->subbox[i] - 2 * grid->ghost;
+    substart[i] = grid->sublo[i] + grid->ghost;
     dims[i] = grid->box[i];
   }
   ncells = subdims[0] * subdims[1] * subdims[2];
@@ -281,11 +295,62 @@ void DumpHDF5::write() {
 	delete grow;
       }
       H5Gclose(group);
+    } else if (*it == "ave") {
+      write_average(file, oneperproc);
     }
   }
   H5Fclose(file);
 }
 
+/* ----------------------------------------------------------------------
+   statistics of fix nufeb/ave/grid as average/<component>_<stat>, the
+   components are only known once the fix is initialized so groups of
+   single file dumps are created on first use
+------------------------------------------------------------------------- */
+
+void DumpHDF5::write_average(hid_t file, bool oneperproc) {
+  int dim;
+  int ncomp = *(int *)fix_ave->extract("ncomp", dim);
+  int nsample = *(int *)fix_ave->extract("nsample", dim);
+  char **cname = (char **)fix_ave->extract("cname", dim);
+  const char *stats[4] = {"mean", "m2", "min", "max"};
+  const char *labels[4] = {"mean", "variance", "min", "max"};
+
+  hid_t group;
+  if (H5Lexists(file, "average", H5P_DEFAULT) > 0)
+    group = H5Gopen(file, "average", H5P_DEFAULT);
+  else
+    group = H5Gcreate(file, "average", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+
+  double *buf = new double[ncells];
+  for (int s = 0; s < 4; s++) {
+    double **data = (double **)fix_ave->extract(stats[s], dim);
+    if (!data) continue;
+    for (int k = 0; k < ncomp; k++) {
+      std::ostringstream oss;
+      oss << "average/" << cname[k] << "_" << labels[s];
+      trim_grids(data[k], buf);
+      if (s == 1)
+	for (int i = 0; i < ncells; i++)
+	  buf[i] = nsample ? buf[i] / nsample : 0.0;
+      if (multifile) {
+	write_grid(file, oss.str().c_str(), H5T_NATIVE_DOUBLE, buf, oneperproc);
+      } else {
+	hid_t subgroup;
+	if (H5Lexists(file, oss.str().c_str(), H5P_DEFAULT) > 0)
+	  subgroup = H5Gopen(file, oss.str().c_str(), H5P_DEFAULT);
+	else
+	  subgroup = H5Gcreate(file, oss.str().c_str(), H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+	oss << "/" << std::to_string(update->ntimestep);
+	write_grid(file, oss.str().c_str(), H5T_NATIVE_DOUBLE, buf, oneperproc);
+	H5Gclose(subgroup);
+      }
+    }
+  }
+  delete [] buf;
+  H5Gclose(group);
+}
+
 void DumpHDF5::create_one_file() {
   std::string str(filename);
   hid_t proplist = H5P_DEFAULT;
@@ -410,6 +475,11 @@ int DumpHDF5::parse_fields(int narg, char **arg) {
       fields.push_back(arg[iarg]);
     } else if (strcmp(arg[iarg], "grow") == 0) {
       fields.push_back(arg[iarg]);
+    } else if (strcmp(arg[iarg], "ave") == 0) {
+      if (iarg+1 >= narg)
+	error->all(FLERR, "Illegal dump nufeb/hdf5 command");
+      fields.push_back(arg[iarg]);
+      ave_id = arg[++iarg];
     }
   }
   return i;
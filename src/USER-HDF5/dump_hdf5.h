@@ -33,13 +33,14 @@ class DumpHDF5 : public Dump {
 
 protected:
   void write();
-  void init_style() {};
+  void init_style();
   void setup();
   void write_header(bigint) {}
   void pack(tagint *) {}
   void write_data(int, double *) {}
   int parse_fields(int narg, char **arg);
   void create_one_file();
+  void write_average(hid_t file, bool oneperproc);
 
   hid_t create_filespace_atom(bool oneperproc);
   hid_t create_filespace_grid(bool oneperproc);
@@ -56,6 +57,8 @@ protected:
   herr_t write_grid(hid_t file, const char *name, hid_t type, T *buf, bool oneperproc, int n, int index);
 
   std::vector<std::string> fields;
+  std::string ave_id;                   // id of fix nufeb/ave/grid
+  class Fix *fix_ave;
 
   int ncells;
   int subdims[3], substart[3], dims[3];
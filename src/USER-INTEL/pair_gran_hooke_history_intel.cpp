@@ -0,0 +1,447 @@
+/* ----------------------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   http://lammps.sandia.gov, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#include <cmath>
+#include <cstring>
+#include "pair_gran_hooke_history_intel.h"
+#include "atom.h"
+#include "comm.h"
+#include "error.h"
+#include "fix_neigh_history.h"
+#include "force.h"
+#include "memory.h"
+#include "modify.h"
+#include "neighbor.h"
+#include "neigh_list.h"
+#include "update.h"
+#include "suffix.h"
+using namespace LAMMPS_NS;
+
+/* ---------------------------------------------------------------------- */
+
+PairGranHookeHistoryIntel::PairGranHookeHistoryIntel(LAMMPS *lmp) :
+  PairGranHookeHistory(lmp)
+{
+  suffix_flag |= Suffix::INTEL;
+  respa_enable = 0;
+  fthr = NULL;
+  fthr_size = 0;
+}
+
+/* ---------------------------------------------------------------------- */
+
+PairGranHookeHistoryIntel::~PairGranHookeHistoryIntel()
+{
+  memory->destroy(fthr);
+}
+
+/* ---------------------------------------------------------------------- */
+
+void PairGranHookeHistoryIntel::compute(int eflag, int vflag)
+{
+  // rigid body masses are only handled by the reference kernel
+  if (fix_rigid) {
+    PairGranHookeHistory::compute(eflag, vflag);
+    return;
+  }
+
+  if (fix->precision() == FixIntel::PREC_MODE_DOUBLE)
+    compute<double>(eflag, vflag, pack_double);
+  else
+    compute<float>(eflag, vflag, pack_single);
+
+  fix->balance_stamp();
+}
+
+/* ---------------------------------------------------------------------- */
+
+template <class flt_t>
+void PairGranHookeHistoryIntel::compute(int eflag, int vflag,
+                                        AtomPack<flt_t> &pack)
+{
+  ev_init(eflag, vflag);
+  if (vflag_atom)
+    error->all(FLERR,"USER-INTEL package does not support per-atom stress");
+
+  const int nlocal = atom->nlocal;
+  const int nall = nlocal + atom->nghost;
+  const int nthreads = comm->nthreads;
+
+  if (nall > pack.nmax()) pack.grow(atom->nmax, memory);
+  if (nthreads * 8 * atom->nmax > fthr_size) {
+    fthr_size = nthreads * 8 * atom->nmax;
+    memory->destroy(fthr);
+    memory->create(fthr, fthr_size, "pair:fthr");
+  }
+
+  // pack positions, radii, velocities, spins and inverse masses,
+  //   frozen atoms get a zero inverse mass
+
+  double **x = atom->x;
+  double **v = atom->v;
+  double **omega = atom->omega;
+  double *radius = atom->radius;
+  double *rmass = atom->rmass;
+  int *mask = atom->mask;
+  typename AtomPack<flt_t>::pos_t * _noalias const px = pack.x;
+  typename AtomPack<flt_t>::vel_t * _noalias const pv = pack.v;
+  typename AtomPack<flt_t>::omega_t * _noalias const pw = pack.omega;
+
+  #if defined(_OPENMP)
+  #pragma omp parallel for schedule(static)
+  #endif
+  for (int i = 0; i < nall; i++) {
+    px[i].x = x[i][0];
+    px[i].y = x[i][1];
+    px[i].z = x[i][2];
+    px[i].radius = radius[i];
+    pv[i].x = v[i][0];
+    pv[i].y = v[i][1];
+    pv[i].z = v[i][2];
+    pv[i].rmassinv = (mask[i] & freeze_group_bit) ? 0.0 : 1.0 / rmass[i];
+    pw[i].x = omega[i][0];
+    pw[i].y = omega[i][1];
+    pw[i].z = omega[i][2];
+    pw[i].pad = 0.0;
+  }
+
+  // the global virial is tallied in the kernel unless f dot r is used
+  const int tally = (vflag_global && !vflag_fdotr);
+  const int shearupdate = (update->setupflag == 0);
+
+  if (force->newton_pair) {
+    if (tally) {
+      if (shearupdate) eval<1,1,1,flt_t,double>(pack);
+      else eval<1,1,0,flt_t,double>(pack);
+    } else {
+      if (shearupdate) eval<1,0,1,flt_t,double>(pack);
+      else eval<1,0,0,flt_t,double>(pack);
+    }
+  } else {
+    if (tally) {
+      if (shearupdate) eval<0,1,1,flt_t,double>(pack);
+      else eval<0,1,0,flt_t,double>(pack);
+    } else {
+      if (shearupdate) eval<0,0,1,flt_t,double>(pack);
+      else eval<0,0,0,flt_t,double>(pack);
+    }
+  }
+
+  if (vflag_fdotr) virial_fdotr_compute();
+}
+
+/* ----------------------------------------------------------------------
+   contact kernel, the pair math is done in flt_t and accumulated in
+   acc_t, shear displacements stay in the double precision history
+   arrays which are laid out in neighbor list order
+------------------------------------------------------------------------- */
+
+template <int NEWTON_PAIR, int VFLAG, int SHEARUPDATE, class flt_t,
+          class acc_t>
+void PairGranHookeHistoryIntel::eval(AtomPack<flt_t> &pack)
+{
+  const int inum = list->inum;
+  const int nlocal = atom->nlocal;
+  const int nall = nlocal + atom->nghost;
+  const int nthreads = comm->nthreads;
+  const int nf = NEWTON_PAIR ? nall : nlocal;
+
+  const int * _noalias const ilist = list->ilist;
+  const int * _noalias const numneigh = list->numneigh;
+  int ** _noalias const firstneigh = list->firstneigh;
+  int ** _noalias const firsttouch = fix_history->firstflag;
+  double ** _noalias const firstshear = fix_history->firstvalue;
+
+  const typename AtomPack<flt_t>::pos_t * _noalias const x = pack.x;
+  const typename AtomPack<flt_t>::vel_t * _noalias const v = pack.v;
+  const typename AtomPack<flt_t>::omega_t * _noalias const omega = pack.omega;
+
+  const flt_t fkn = kn;
+  const flt_t fkt = kt;
+  const flt_t fgamman = gamman;
+  const flt_t fgammat = gammat;
+  const flt_t fxmu = xmu;
+  const double ddt = dt;
+
+  acc_t ov0, ov1, ov2, ov3, ov4, ov5;
+  ov0 = ov1 = ov2 = ov3 = ov4 = ov5 = (acc_t)0;
+
+  #if defined(_OPENMP)
+  #pragma omp parallel reduction(+:ov0,ov1,ov2,ov3,ov4,ov5)
+  #endif
+  {
+    int iifrom, iip, iito, tid;
+    IP_PRE_omp_stride_id(iifrom, iip, iito, tid, inum, nthreads);
+
+    double * _noalias const f = fthr + (bigint) tid * 8 * nall;
+    memset(f, 0, 8 * nf * sizeof(double));
+
+    for (int ii = iifrom; ii < iito; ii += iip) {
+      const int i = ilist[ii];
+      const int * _noalias const jlist = firstneigh[i];
+      const int jnum = numneigh[i];
+      int * _noalias const touch = firsttouch[i];
+      double * _noalias const allshear = firstshear[i];
+
+      const flt_t xtmp = x[i].x;
+      const flt_t ytmp = x[i].y;
+      const flt_t ztmp = x[i].z;
+      const flt_t radi = x[i].radius;
+      const flt_t vxtmp = v[i].x;
+      const flt_t vytmp = v[i].y;
+      const flt_t vztmp = v[i].z;
+      const flt_t minvi = v[i].rmassinv;
+      const flt_t wxtmp = omega[i].x;
+      const flt_t wytmp = omega[i].y;
+      const flt_t wztmp = omega[i].z;
+
+      acc_t fxtmp, fytmp, fztmp, txtmp, tytmp, tztmp;
+      fxtmp = fytmp = fztmp = txtmp = tytmp = tztmp = (acc_t)0;
+      acc_t sv0, sv1, sv2, sv3, sv4, sv5;
+      sv0 = sv1 = sv2 = sv3 = sv4 = sv5 = (acc_t)0;
+
+      #if defined(LMP_SIMD_COMPILER)
+      #pragma simd reduction(+:fxtmp, fytmp, fztmp, txtmp, tytmp, tztmp, \
+                               sv0, sv1, sv2, sv3, sv4, sv5)
+      #endif
+      for (int jj = 0; jj < jnum; jj++) {
+        const int j = jlist[jj] & NEIGHMASK;
+        double * _noalias const shear = allshear + 3 * jj;
+
+        const flt_t delx = xtmp - x[j].x;
+        const flt_t dely = ytmp - x[j].y;
+        const flt_t delz = ztmp - x[j].z;
+        const flt_t rsq = delx * delx + dely * dely + delz * delz;
+        const flt_t radj = x[j].radius;
+        const flt_t radsum = radi + radj;
+
+        if (rsq >= radsum * radsum) {
+          // unset non-touching neighbors
+          touch[jj] = 0;
+          shear[0] = 0.0;
+          shear[1] = 0.0;
+          shear[2] = 0.0;
+        } else {
+          const flt_t r = sqrt(rsq);
+          const flt_t rinv = (flt_t)1.0 / r;
+          const flt_t rsqinv = (flt_t)1.0 / rsq;
+
+          // relative translational velocity and its normal component
+          const flt_t vr1 = vxtmp - v[j].x;
+          const flt_t vr2 = vytmp - v[j].y;
+          const flt_t vr3 = vztmp - v[j].z;
+          const flt_t vnnr = vr1 * delx + vr2 * dely + vr3 * delz;
+          const flt_t vt1 = vr1 - delx * vnnr * rsqinv;
+          const flt_t vt2 = vr2 - dely * vnnr * rsqinv;
+          const flt_t vt3 = vr3 - delz * vnnr * rsqinv;
+
+          // relative rotational velocity
+          const flt_t wr1 = (radi * wxtmp + radj * omega[j].x) * rinv;
+          const flt_t wr2 = (radi * wytmp + radj * omega[j].y) * rinv;
+          const flt_t wr3 = (radi * wztmp + radj * omega[j].z) * rinv;
+
+          // effective mass, the other particle if one of them is frozen
+          const flt_t minvsum = minvi + v[j].rmassinv;
+          const flt_t meff = (minvsum > (flt_t)0.0) ?
+            (flt_t)1.0 / minvsum : (flt_t)0.0;
+
+          // normal forces = Hookian contact + normal velocity damping
+          const flt_t damp = meff * fgamman * vnnr * rsqinv;
+          const flt_t ccel = fkn * (radsum - r) * rinv - damp;
+
+          // relative tangential velocities
+          const flt_t vtr1 = vt1 - (delz * wr2 - dely * wr3);
+          const flt_t vtr2 = vt2 - (delx * wr3 - delz * wr1);
+          const flt_t vtr3 = vt3 - (dely * wr1 - delx * wr2);
+
+          // shear history effects
+          touch[jj] = 1;
+          double sh0 = shear[0];
+          double sh1 = shear[1];
+          double sh2 = shear[2];
+          if (SHEARUPDATE) {
+            sh0 += vtr1 * ddt;
+            sh1 += vtr2 * ddt;
+            sh2 += vtr3 * ddt;
+          }
+          const double shrmag = sqrt(sh0 * sh0 + sh1 * sh1 + sh2 * sh2);
+
+          // rotate shear displacements
+          if (SHEARUPDATE) {
+            const double rsht = (sh0 * delx + sh1 * dely + sh2 * delz) * rsqinv;
+            sh0 -= rsht * delx;
+            sh1 -= rsht * dely;
+            sh2 -= rsht * delz;
+          }
+
+          // tangential forces = shear + tangential velocity damping
+          const flt_t mgt = meff * fgammat;
+          flt_t fs1 = -(fkt * (flt_t)sh0 + mgt * vtr1);
+          flt_t fs2 = -(fkt * (flt_t)sh1 + mgt * vtr2);
+          flt_t fs3 = -(fkt * (flt_t)sh2 + mgt * vtr3);
+
+          // rescale frictional displacements and forces if needed
+          const flt_t fs = sqrt(fs1 * fs1 + fs2 * fs2 + fs3 * fs3);
+          const flt_t fn = fxmu * fabs(ccel * r);
+          if (fs > fn) {
+            if (shrmag != 0.0) {
+              const flt_t scale = fn / fs;
+              const flt_t mgtkt = mgt / fkt;
+              sh0 = scale * (sh0 + mgtkt * vtr1) - mgtkt * vtr1;
+              sh1 = scale * (sh1 + mgtkt * vtr2) - mgtkt * vtr2;
+              sh2 = scale * (sh2 + mgtkt * vtr3) - mgtkt * vtr3;
+              fs1 *= scale;
+              fs2 *= scale;
+              fs3 *= scale;
+            } else fs1 = fs2 = fs3 = (flt_t)0.0;
+          }
+          shear[0] = sh0;
+          shear[1] = sh1;
+          shear[2] = sh2;
+
+          // forces & torques
+          const flt_t fx = delx * ccel + fs1;
+          const flt_t fy = dely * ccel + fs2;
+          const flt_t fz = delz * ccel + fs3;
+          fxtmp += fx;
+          fytmp += fy;
+          fztmp += fz;
+
+          const flt_t tor1 = rinv * (dely * fs3 - delz * fs2);
+          const flt_t tor2 = rinv * (delz * fs1 - delx * fs3);
+          const flt_t tor3 = rinv * (delx * fs2 - dely * fs1);
+          txtmp -= radi * tor1;
+          tytmp -= radi * tor2;
+          tztmp -= radi * tor3;
+
+          flt_t vfactor = (flt_t)1.0;
+          if (NEWTON_PAIR || j < nlocal) {
+            double * _noalias const fj = f + 8 * j;
+            fj[0] -= fx;
+            fj[1] -= fy;
+            fj[2] -= fz;
+            fj[4] -= radj * tor1;
+            fj[5] -= radj * tor2;
+            fj[6] -= radj * tor3;
+          } else vfactor = (flt_t)0.5;
+
+          if (VFLAG) {
+            sv0 += vfactor * delx * fx;
+            sv1 += vfactor * dely * fy;
+            sv2 += vfactor * delz * fz;
+            sv3 += vfactor * delx * fy;
+            sv4 += vfactor * delx * fz;
+            sv5 += vfactor * dely * fz;
+          }
+        }
+      } // for jj
+
+      double * _noalias const fi = f + 8 * i;
+      fi[0] += fxtmp;
+      fi[1] += fytmp;
+      fi[2] += fztmp;
+      fi[4] += txtmp;
+      fi[5] += tytmp;
+      fi[6] += tztmp;
+      if (VFLAG) {
+        ov0 += sv0;
+        ov1 += sv1;
+        ov2 += sv2;
+        ov3 += sv3;
+        ov4 += sv4;
+        ov5 += sv5;
+      }
+    } // for ii
+
+    // reduce the thread accumulators into the atom arrays
+    #if defined(_OPENMP)
+    #pragma omp barrier
+    #endif
+    int ifrom, ito;
+    IP_PRE_omp_range(ifrom, ito, tid, nf, nthreads);
+    double **atom_f = atom->f;
+    double **atom_torque = atom->torque;
+    for (int t = 0; t < nthreads; t++) {
+      const double * _noalias const ft = fthr + (bigint) t * 8 * nall;
+      for (int n = ifrom; n < ito; n++) {
+        atom_f[n][0] += ft[8*n];
+        atom_f[n][1] += ft[8*n+1];
+        atom_f[n][2] += ft[8*n+2];
+        atom_torque[n][0] += ft[8*n+4];
+        atom_torque[n][1] += ft[8*n+5];
+        atom_torque[n][2] += ft[8*n+6];
+      }
+    }
+  } // end omp
+
+  if (VFLAG) {
+    virial[0] += ov0;
+    virial[1] += ov1;
+    virial[2] += ov2;
+    virial[3] += ov3;
+    virial[4] += ov4;
+    virial[5] += ov5;
+  }
+}
+
+/* ---------------------------------------------------------------------- */
+
+void PairGranHookeHistoryIntel::init_style()
+{
+  PairGranHookeHistory::init_style();
+
+  int ifix = modify->find_fix("package_intel");
+  if (ifix < 0)
+    error->all(FLERR,
+               "The 'package intel' command is required for /intel styles");
+  fix = static_cast<FixIntel *>(modify->fix[ifix]);
+
+  fix->pair_init_check();
+  #ifdef _LMP_INTEL_OFFLOAD
+  if (fix->offload_balance() != 0.0)
+    error->all(FLERR,
+          "Offload for gran/hooke/history/intel is not yet available. "
+          "Set balance to 0.");
+  #endif
+}
+
+/* ---------------------------------------------------------------------- */
+
+double PairGranHookeHistoryIntel::memory_usage()
+{
+  double bytes = PairGranHookeHistory::memory_usage();
+  bytes += (double) fthr_size * sizeof(double);
+  bytes += (double) pack_single.nmax() * 12 * sizeof(float);
+  bytes += (double) pack_double.nmax() * 12 * sizeof(double);
+  return bytes;
+}
+
+/* ---------------------------------------------------------------------- */
+
+template <class flt_t>
+void PairGranHookeHistoryIntel::AtomPack<flt_t>::grow(const int nmax,
+                                                      Memory *memory)
+{
+  if (_nmax > 0) {
+    _memory->destroy(x);
+    _memory->destroy(v);
+    _memory->destroy(omega);
+  }
+  if (nmax > 0) {
+    memory->create(x, nmax, "pair:pack_x");
+    memory->create(v, nmax, "pair:pack_v");
+    memory->create(omega, nmax, "pair:pack_omega");
+  }
+  _nmax = nmax;
+  _memory = memory;
+}
@@ -0,0 +1,96 @@
+/* -*- c++ -*- ----------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   http://lammps.sandia.gov, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#ifdef PAIR_CLASS
+
+PairStyle(gran/hooke/history/intel,PairGranHookeHistoryIntel)
+
+#else
+
+#ifndef LMP_PAIR_GRAN_HOOKE_HISTORY_INTEL_H
+#define LMP_PAIR_GRAN_HOOKE_HISTORY_INTEL_H
+
+#include "pair_gran_hooke_history.h"
+#include "fix_intel.h"
+
+namespace LAMMPS_NS {
+
+class PairGranHookeHistoryIntel : public PairGranHookeHistory {
+
+ public:
+  PairGranHookeHistoryIntel(class LAMMPS *);
+  virtual ~PairGranHookeHistoryIntel();
+
+  virtual void compute(int, int);
+  void init_style();
+  double memory_usage();
+
+ private:
+  FixIntel *fix;
+
+  // per-thread force and torque accumulators, 8 per atom
+  double *fthr;
+  int fthr_size;
+
+  template <class flt_t> class AtomPack;
+  template <class flt_t>
+  void compute(int eflag, int vflag, AtomPack<flt_t> &pack);
+  template <int NEWTON_PAIR, int VFLAG, int SHEARUPDATE, class flt_t,
+            class acc_t>
+  void eval(AtomPack<flt_t> &pack);
+
+  // ----------------------------------------------------------------------
+
+  // positions, velocities and spins of owned and ghost atoms in the
+  //   precision of the kernel, packed once per call
+  template <class flt_t>
+  class AtomPack {
+   public:
+    typedef struct { flt_t x, y, z, radius; } pos_t;
+    typedef struct { flt_t x, y, z, rmassinv; } vel_t;
+    typedef struct { flt_t x, y, z, pad; } omega_t;
+
+    pos_t *x;
+    vel_t *v;
+    omega_t *omega;
+
+    AtomPack() : x(NULL), v(NULL), omega(NULL), _nmax(0), _memory(NULL) {}
+    ~AtomPack() { grow(0, NULL); }
+
+    void grow(const int nmax, Memory *memory);
+    int nmax() const { return _nmax; }
+
+   private:
+    int _nmax;
+    Memory *_memory;
+  };
+  AtomPack<float> pack_single;
+  AtomPack<double> pack_double;
+};
+
+}
+
+#endif
+#endif
+
+/* ERROR/WARNING messages:
+
+E: The 'package intel' command is required for /intel styles
+
+Self-explanatory.
+
+E: USER-INTEL package does not support per-atom stress
+
+Per-atom virials are not computed by the packed kernel.
+
+*/
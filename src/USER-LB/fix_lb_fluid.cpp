@@ -490,6 +490,7 @@ a z wall velocity without implementing fixed BCs in z");
   memory->create(Fftempx,5,subNby+3,subNbz+3,3,"FixLbFluid:Fftempx");
   memory->create(Fftempy,subNbx+3,5,subNbz+3,3,"FixLbFluid:Fftempy");
   memory->create(Fftempz,subNbx+3,subNby+3,5,3,"FixLbFluid:Fftempz");
+  drag_lb = NULL;
 
   if(noisestress==1){
     random = new RanMars(lmp,seed + comm->me);
@@ -537,6 +538,7 @@ FixLbFluid::~FixLbFluid()
   memory->destroy(Fftempx);
   memory->destroy(Fftempy);
   memory->destroy(Fftempz);
+  memory->destroy(drag_lb);
 
   if(noisestress==1){
     delete random;
@@ -784,6 +786,33 @@ int FixLbFluid::unpack_exchange(int nlocal, double *buf)
   return 3;
 }
 
+//==========================================================================
+//   give other fixes access to the local fluid grid.
+//   the drag_lb array is only allocated when first requested.
+//==========================================================================
+void *FixLbFluid::extract(const char *str, int &dim)
+{
+  dim = 0;
+  if(strcmp(str,"dx_lb") == 0) return &dx_lb;
+  if(strcmp(str,"dt_lb") == 0) return &dt_lb;
+  if(strcmp(str,"subNbx") == 0) return &subNbx;
+  if(strcmp(str,"subNby") == 0) return &subNby;
+  if(strcmp(str,"subNbz") == 0) return &subNbz;
+  if(strcmp(str,"u_lb") == 0){
+    dim = 4;
+    return u_lb;
+  }
+  if(strcmp(str,"drag_lb") == 0){
+    if(drag_lb == NULL){
+      memory->create(drag_lb,subNbx,subNby,subNbz,"FixLbFluid:drag_lb");
+      std::fill(&drag_lb[0][0][0],&drag_lb[0][0][0] + subNbx*subNby*subNbz,0.0);
+    }
+    dim = 3;
+    return drag_lb;
+  }
+  return NULL;
+}
+
 //==========================================================================
 //   calculate the force from the local atoms acting on the fluid.
 //==========================================================================
@@ -958,6 +987,17 @@ void FixLbFluid::calc_fluidforce(void)
     }
   }
 
+  //--------------------------------------------------------------------------
+  // Add the porous (Brinkman) drag set by a coupled fix, if any.
+  //--------------------------------------------------------------------------
+  if(drag_lb != NULL){
+    for(i=1; i<subNbx-1; i++)
+      for(j=1; j<subNby-1; j++)
+        for(k=1; k<subNbz-1; k++)
+          for(m=0; m<3; m++)
+            Ff[i][j][k][m] -= drag_lb[i][j][k]*density_lb[i][j][k]*u_lb[i][j][k][m];
+  }
+
   if(force_diagnostic > 0 && update->ntimestep > 0 && (update->ntimestep % force_diagnostic == 0)){
     force[0] = force[1] = force[2] = 0.0;
     torque[0] = torque[1] = torque[2] =0.0;
@@ -48,6 +48,7 @@ public:
     void copy_arrays(int, int, int);
     int pack_exchange(int, double *);
     int unpack_exchange(int, double *);
+    void *extract(const char *, int &);
 
   private:
     double viscosity,densityinit_real,a_0_real,T;
@@ -91,6 +92,8 @@ public:
     double ****Fftempx;
     double ****Fftempy;
     double ****Fftempz;
+    double ***drag_lb;                               // Porous drag coefficient per node
+                                                     //   (allocated on request by a coupled fix).
 
     double *Ng_lb;                                   // Lattice Boltzmann variables.
     double *w_lb;
@@ -63,7 +63,7 @@ void ComputeAveConc::compute_vector()
     }
 
     MPI_Allreduce(MPI_IN_PLACE, &sum, 1, MPI_DOUBLE, MPI_SUM, world);
-    sum /= (grid->box[0] * grid->box[1] * grid->box[2]);
+    sum /= grid->ntotal;
     vector[isub] = sum;
   }
 }
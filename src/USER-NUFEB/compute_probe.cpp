@@ -0,0 +1,207 @@
+/* ----------------------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   http://lammps.sandia.gov, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#include <cstring>
+#include <cmath>
+#include "compute_probe.h"
+#include "error.h"
+#include "force.h"
+#include "update.h"
+#include "memory.h"
+#include "domain.h"
+#include "grid.h"
+#include "comm_grid.h"
+
+using namespace LAMMPS_NS;
+
+enum{CONC,REAC};
+
+/* ----------------------------------------------------------------------
+   compute ID group nufeb/probe con|rea sub ... point x y z ...
+     line x1 y1 z1 x2 y2 z2 n ...
+------------------------------------------------------------------------- */
+
+ComputeProbe::ComputeProbe(LAMMPS *lmp, int narg, char **arg) :
+  Compute(lmp, narg, arg)
+{
+  if (narg < 8) error->all(FLERR,"Illegal compute nufeb/probe command");
+
+  ncol = 0;
+  field = new int[narg];
+  isub = new int[narg];
+  npoint = 0;
+  xp = NULL;
+  values = NULL;
+
+  int iarg = 3;
+  while (iarg < narg) {
+    if (strcmp(arg[iarg],"con") == 0 || strcmp(arg[iarg],"rea") == 0) {
+      if (iarg+2 > narg) error->all(FLERR,"Illegal compute nufeb/probe command");
+      field[ncol] = (arg[iarg][0] == 'c') ? CONC : REAC;
+      isub[ncol] = grid->find(arg[iarg+1]);
+      if (isub[ncol] < 0) error->all(FLERR,"Can't find substrate name");
+      ncol++;
+      iarg += 2;
+    } else if (strcmp(arg[iarg],"point") == 0) {
+      if (iarg+4 > narg) error->all(FLERR,"Illegal compute nufeb/probe command");
+      add_point(force->numeric(FLERR,arg[iarg+1]),
+		force->numeric(FLERR,arg[iarg+2]),
+		force->numeric(FLERR,arg[iarg+3]));
+      iarg += 4;
+    } else if (strcmp(arg[iarg],"line") == 0) {
+      if (iarg+8 > narg) error->all(FLERR,"Illegal compute nufeb/probe command");
+      double lo[3], hi[3];
+      for (int d = 0; d < 3; d++) {
+	lo[d] = force->numeric(FLERR,arg[iarg+1+d]);
+	hi[d] = force->numeric(FLERR,arg[iarg+4+d]);
+      }
+      int n = force->inumeric(FLERR,arg[iarg+7]);
+      if (n < 2) error->all(FLERR,"Illegal compute nufeb/probe command");
+      // n evenly spaced points including both ends
+      for (int k = 0; k < n; k++) {
+	double t = (double)k / (n - 1);
+	add_point(lo[0] + t * (hi[0] - lo[0]),
+		  lo[1] + t * (hi[1] - lo[1]),
+		  lo[2] + t * (hi[2] - lo[2]));
+      }
+      iarg += 8;
+    } else error->all(FLERR,"Illegal compute nufeb/probe command");
+  }
+
+  if (!ncol || !npoint)
+    error->all(FLERR,"Compute nufeb/probe requires at least one field and one point");
+
+  memory->create(values,npoint,ncol,"probe:values");
+
+  // a single column is a vector with one entry per point
+  if (ncol == 1) {
+    vector_flag = 1;
+    size_vector = npoint;
+    extvector = 0;
+    vector = values[0];
+  } else {
+    array_flag = 1;
+    size_array_rows = npoint;
+    size_array_cols = ncol;
+    extarray = 0;
+    array = values;
+  }
+}
+
+/* ---------------------------------------------------------------------- */
+
+ComputeProbe::~ComputeProbe()
+{
+  delete [] field;
+  delete [] isub;
+  memory->destroy(xp);
+  memory->destroy(values);
+}
+
+/* ---------------------------------------------------------------------- */
+
+void ComputeProbe::init()
+{
+  for (int p = 0; p < npoint; p++) {
+    for (int d = 0; d < 3; d++) {
+      if (xp[p][d] < domain->boxlo[d] || xp[p][d] > domain->boxhi[d])
+	error->all(FLERR,"Compute nufeb/probe point is outside the simulation box");
+    }
+  }
+}
+
+/* ---------------------------------------------------------------------- */
+
+void ComputeProbe::compute_vector()
+{
+  invoked_vector = update->ntimestep;
+  probe();
+}
+
+/* ---------------------------------------------------------------------- */
+
+void ComputeProbe::compute_array()
+{
+  invoked_array = update->ntimestep;
+  probe();
+}
+
+/* ---------------------------------------------------------------------- */
+
+void ComputeProbe::add_point(double x, double y, double z)
+{
+  memory->grow(xp,npoint+1,3,"probe:xp");
+  xp[npoint][0] = x;
+  xp[npoint][1] = y;
+  xp[npoint][2] = z;
+  npoint++;
+}
+
+/* ----------------------------------------------------------------------
+   each point is interpolated by the proc owning the cell containing it,
+   using the trilinear stencil of Grid::cic(), all other procs contribute
+   zeros to a single sum over the values of every point
+   the stencil reaches into ghost cells, which are refreshed first since
+     ghost conc lags one sweep and reac is never forward communicated
+------------------------------------------------------------------------- */
+
+void ComputeProbe::probe()
+{
+  int cells[8];
+  double w[8];
+
+  int conc_flag = 0, reac_flag = 0;
+  for (int j = 0; j < ncol; j++) {
+    if (field[j] == CONC) conc_flag = 1;
+    else reac_flag = 1;
+  }
+  if (conc_flag) comm_grid->forward_comm();
+  if (reac_flag) comm_grid->forward_comm_array(grid->nsubs, grid->reac);
+
+  for (int p = 0; p < npoint; p++) {
+    for (int j = 0; j < ncol; j++)
+      values[p][j] = 0.0;
+
+    int owned = 1;
+    for (int d = 0; d < 3; d++) {
+      int c = static_cast<int>((xp[p][d] - domain->boxlo[d]) / grid->cell_size);
+      c = MAX(0, MIN(c, grid->box[d] - 1));
+      if (c < grid->sublo[d] + grid->ghost || c >= grid->subhi[d] - grid->ghost)
+	owned = 0;
+    }
+    if (!owned) continue;
+
+    grid->cic(xp[p], cells, w);
+    for (int j = 0; j < ncol; j++) {
+      double *f = (field[j] == CONC) ? grid->conc[isub[j]] : grid->reac[isub[j]];
+      double sum = 0.0;
+      for (int k = 0; k < 8; k++)
+	if (cells[k] >= 0) sum += w[k] * f[cells[k]];
+      values[p][j] = sum;
+    }
+  }
+
+  MPI_Allreduce(MPI_IN_PLACE,values[0],npoint*ncol,MPI_DOUBLE,MPI_SUM,world);
+}
+
+/* ----------------------------------------------------------------------
+   memory usage of probe positions and values
+------------------------------------------------------------------------- */
+
+double ComputeProbe::memory_usage()
+{
+  double bytes = 0.0;
+  bytes += 3.0 * npoint * sizeof(double);
+  bytes += (double) npoint * ncol * sizeof(double);
+  return bytes;
+}
@@ -0,0 +1,73 @@
+/* -*- c++ -*- ----------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   http://lammps.sandia.gov, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#ifdef COMPUTE_CLASS
+
+ComputeStyle(nufeb/probe,ComputeProbe)
+
+#else
+
+#ifndef LMP_COMPUTE_PROBE_H
+#define LMP_COMPUTE_PROBE_H
+
+#include "compute.h"
+
+namespace LAMMPS_NS {
+
+class ComputeProbe : public Compute {
+ public:
+  ComputeProbe(class LAMMPS *, int, char **);
+  ~ComputeProbe();
+  void init();
+  void compute_vector();
+  void compute_array();
+  double memory_usage();
+
+ private:
+  int ncol;
+  int *field;                  // CONC or REAC of each column
+  int *isub;                   // substrate of each column
+  int npoint;
+  double **xp;                 // probe positions
+  double **values;             // npoint x ncol buffer of the reduction
+
+  void add_point(double, double, double);
+  void probe();
+};
+
+}
+
+#endif
+#endif
+
+/* ERROR/WARNING messages:
+
+E: Illegal ... command
+
+Self-explanatory.  Check the input script syntax and compare to the
+documentation for the command.  You can use -echo screen as a
+command-line option when running LAMMPS to see the offending line.
+
+E: Can't find substrate name
+
+Self-explanatory.
+
+E: Compute nufeb/probe requires at least one field and one point
+
+Self-explanatory.
+
+E: Compute nufeb/probe point is outside the simulation box
+
+Probe positions must lie inside the box when the run starts.
+
+*/
@@ -0,0 +1,347 @@
+/* ----------------------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   http://lammps.sandia.gov, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#include <cstring>
+#include <stdint.h>
+#include <string>
+#include "dump_vtu.h"
+#include "error.h"
+#include "memory.h"
+#include "update.h"
+
+using namespace LAMMPS_NS;
+
+/* ----------------------------------------------------------------------
+   dump ID group nufeb/vtu N file.*.vtu field1 field2 ...
+   fields are parsed as for dump custom, x y z are the point coordinates
+   and all other fields are written as point data arrays
+------------------------------------------------------------------------- */
+
+DumpVTU::DumpVTU(LAMMPS *lmp, int narg, char **arg) :
+  DumpCustom(lmp, narg, arg)
+{
+  if (multiproc)
+    error->all(FLERR,"Dump nufeb/vtu does not support one file per proc");
+  if (!multifile)
+    error->all(FLERR,"Dump nufeb/vtu requires one snapshot per file");
+
+  column = new int[size_one];
+  array_name = new char*[size_one];
+  narray = 0;
+  for (int d = 0; d < 3; d++) xcol[d] = -1;
+
+  char *copy = new char[strlen(columns)+1];
+  strcpy(copy,columns);
+  for (int i = 0; i < size_one; i++) {
+    char *word = strtok(i == 0 ? copy : NULL," ");
+    if (vtype[i] == Dump::STRING)
+      error->all(FLERR,"Dump nufeb/vtu does not support string fields");
+    if (strcmp(word,"x") == 0) xcol[0] = i;
+    else if (strcmp(word,"y") == 0) xcol[1] = i;
+    else if (strcmp(word,"z") == 0) xcol[2] = i;
+    else {
+      column[narray] = i;
+      array_name[narray] = new char[strlen(word)+1];
+      strcpy(array_name[narray],word);
+      narray++;
+    }
+  }
+  delete [] copy;
+
+  if (xcol[0] < 0 || xcol[1] < 0 || xcol[2] < 0)
+    error->all(FLERR,"Dump nufeb/vtu requires x, y and z fields");
+
+  scratch = NULL;
+  maxscratch = 0;
+  compressor = NULL;
+}
+
+/* ---------------------------------------------------------------------- */
+
+DumpVTU::~DumpVTU()
+{
+  delete [] column;
+  for (int i = 0; i < narray; i++) delete [] array_name[i];
+  delete [] array_name;
+  memory->destroy(scratch);
+}
+
+/* ---------------------------------------------------------------------- */
+
+void DumpVTU::init_style()
+{
+  if (sort_flag)
+    error->all(FLERR,"Dump nufeb/vtu does not support dump_modify sort");
+  DumpCustom::init_style();
+}
+
+/* ----------------------------------------------------------------------
+   write one snapshot as a VTU file with one piece per proc
+   the XML header lists every piece with the offsets of its arrays in the
+     raw appended section, each proc writes its own piece entry and arrays
+     at offsets given by prefix sums over procs, straight from the packed
+     dump buffer, so no proc gathers other atoms
+------------------------------------------------------------------------- */
+
+void DumpVTU::write()
+{
+  if (delay_flag && update->ntimestep < delaystep) return;
+
+  nme = count();
+  if (nme > maxbuf) {
+    maxbuf = nme;
+    memory->destroy(buf);
+    memory->create(buf,maxbuf*size_one,"dump:buf");
+  }
+  pack(NULL);
+  encode(nme);
+
+  // bytes of the appended arrays of this proc and of the procs before it
+
+  int nentry = narray + NEXTRA;
+  bigint mybytes = 0, mymax = 0, maxall;
+  for (int a = 0; a < nentry; a++) {
+    mybytes += array_bytes(a,nme);
+    mymax = MAX(mymax,array_bytes(a,nme));
+  }
+
+  // checked on all procs, no proc may abort inside the collective writes
+
+  MPI_Allreduce(&mymax,&maxall,1,MPI_LMP_BIGINT,MPI_MAX,world);
+  if (maxall > MAXSMALLINT)
+    error->all(FLERR,"Dump nufeb/vtu piece array is too large");
+  bigint databefore = 0, datatotal;
+  MPI_Exscan(&mybytes,&databefore,1,MPI_LMP_BIGINT,MPI_SUM,world);
+  if (me == 0) databefore = 0;
+  MPI_Allreduce(&mybytes,&datatotal,1,MPI_LMP_BIGINT,MPI_SUM,world);
+
+  // XML entry of this piece, array offsets are relative to the '_'
+  //   marking the start of the appended data
+
+  char str[128];
+  std::string piece;
+  sprintf(str,"    <Piece NumberOfPoints=\"%d\" NumberOfCells=\"%d\">\n",
+          nme,nme);
+  piece += str;
+  bigint offset = databefore;
+  piece += "      <PointData>\n";
+  for (int a = 0; a < narray; a++) {
+    piece += "        <DataArray type=\"";
+    piece += array_type(a);
+    piece += "\" Name=\"";
+    piece += array_name[a];
+    sprintf(str,"\" format=\"appended\" offset=\"" BIGINT_FORMAT "\"/>\n",
+            offset);
+    piece += str;
+    offset += array_bytes(a,nme);
+  }
+  piece += "      </PointData>\n      <Points>\n";
+  sprintf(str,"        <DataArray type=\"Float64\" NumberOfComponents=\"3\" "
+          "format=\"appended\" offset=\"" BIGINT_FORMAT "\"/>\n",offset);
+  piece += str;
+  offset += array_bytes(narray+POINTS,nme);
+  piece += "      </Points>\n      <Cells>\n";
+  const char *cellnames[3] = {"connectivity","offsets","types"};
+  for (int k = 0; k < 3; k++) {
+    int a = narray + CONNECTIVITY + k;
+    sprintf(str,"        <DataArray type=\"%s\" Name=\"%s\" "
+            "format=\"appended\" offset=\"" BIGINT_FORMAT "\"/>\n",
+            array_type(a),cellnames[k],offset);
+    piece += str;
+    offset += array_bytes(a,nme);
+  }
+  piece += "      </Cells>\n    </Piece>\n";
+
+  int one = 1;
+  std::string head = "<?xml version=\"1.0\"?>\n"
+    "<VTKFile type=\"UnstructuredGrid\" version=\"1.0\" byte_order=\"";
+  head += (*(char *) &one) ? "LittleEndian" : "BigEndian";
+  head += "\" header_type=\"UInt64\"";
+  if (compressor) {
+    head += " compressor=\"";
+    head += compressor;
+    head += "\"";
+  }
+  head += ">\n  <UnstructuredGrid>\n"
+    "    <FieldData>\n      <DataArray type=\"Int64\" Name=\"TIMESTEP\" "
+    "NumberOfTuples=\"1\" format=\"ascii\">";
+  sprintf(str,BIGINT_FORMAT,update->ntimestep);
+  head += str;
+  head += "</DataArray>\n    </FieldData>\n";
+  std::string mid = "  </UnstructuredGrid>\n"
+    "  <AppendedData encoding=\"raw\">\n   _";
+  std::string tail = "\n  </AppendedData>\n</VTKFile>\n";
+
+  bigint mylen = piece.size();
+  bigint xmlbefore = 0, xmltotal;
+  MPI_Exscan(&mylen,&xmlbefore,1,MPI_LMP_BIGINT,MPI_SUM,world);
+  if (me == 0) xmlbefore = 0;
+  MPI_Allreduce(&mylen,&xmltotal,1,MPI_LMP_BIGINT,MPI_SUM,world);
+  MPI_Offset data0 = head.size() + xmltotal + mid.size();
+
+  // if one file per timestep, replace '*' with current timestep
+
+  char *filecurrent = filename;
+  if (multifile) {
+    filecurrent = new char[strlen(filename) + 16];
+    char *ptr = strchr(filename,'*');
+    *ptr = '\0';
+    if (padflag == 0)
+      sprintf(filecurrent,"%s" BIGINT_FORMAT "%s",
+              filename,update->ntimestep,ptr+1);
+    else {
+      char bif[8],pad[16];
+      strcpy(bif,BIGINT_FORMAT);
+      sprintf(pad,"%%s%%0%d%s%%s",padflag,&bif[1]);
+      sprintf(filecurrent,pad,filename,update->ntimestep,ptr+1);
+    }
+    *ptr = '*';
+  }
+
+  MPI_File fh;
+  int err = MPI_File_open(world,filecurrent,MPI_MODE_CREATE | MPI_MODE_WRONLY,
+                          MPI_INFO_NULL,&fh);
+  int flag = (err != MPI_SUCCESS), flagall;
+  MPI_Allreduce(&flag,&flagall,1,MPI_INT,MPI_MAX,world);
+  if (flagall) {
+    char msg[256];
+    snprintf(msg,256,"Cannot open dump file %s",filecurrent);
+    error->all(FLERR,msg);
+  }
+  if (multifile) delete [] filecurrent;
+
+  MPI_File_set_size(fh,data0 + datatotal + tail.size());
+  if (me == 0) {
+    MPI_File_write_at(fh,0,(void *) head.c_str(),head.size(),
+                      MPI_CHAR,MPI_STATUS_IGNORE);
+    MPI_File_write_at(fh,head.size() + xmltotal,(void *) mid.c_str(),
+                      mid.size(),MPI_CHAR,MPI_STATUS_IGNORE);
+    MPI_File_write_at(fh,data0 + datatotal,(void *) tail.c_str(),tail.size(),
+                      MPI_CHAR,MPI_STATUS_IGNORE);
+  }
+  MPI_File_write_at_all(fh,head.size() + xmlbefore,(void *) piece.c_str(),
+                        piece.size(),MPI_CHAR,MPI_STATUS_IGNORE);
+
+  // stream the arrays one at a time through the scratch buffer
+
+  MPI_Offset fileoffset = data0 + databefore;
+  for (int a = 0; a < nentry; a++) {
+    bigint nbytes = array_bytes(a,nme);
+    char *data = array_data(a,nme);
+    MPI_File_write_at_all(fh,fileoffset,data,(int) nbytes,MPI_BYTE,
+                          MPI_STATUS_IGNORE);
+    fileoffset += nbytes;
+  }
+
+  MPI_File_close(&fh);
+}
+
+/* ----------------------------------------------------------------------
+   bytes of array a of a piece of n points, including its size header
+------------------------------------------------------------------------- */
+
+bigint DumpVTU::array_bytes(int a, int n)
+{
+  bigint size;
+  if (a < narray) size = (vtype[column[a]] == Dump::INT) ? 4 : 8;
+  else if (a == narray + POINTS) size = 3 * 8;
+  else if (a == narray + TYPES) size = 1;
+  else size = 8;
+  return sizeof(uint64_t) + size * n;
+}
+
+/* ----------------------------------------------------------------------
+   VTK type name of array a
+------------------------------------------------------------------------- */
+
+const char *DumpVTU::array_type(int a)
+{
+  if (a < narray) {
+    if (vtype[column[a]] == Dump::INT) return "Int32";
+    if (vtype[column[a]] == Dump::BIGINT) return "Int64";
+    return "Float64";
+  }
+  if (a == narray + POINTS) return "Float64";
+  if (a == narray + TYPES) return "UInt8";
+  return "Int64";
+}
+
+/* ----------------------------------------------------------------------
+   bytes of array a as written to the file, filled into scratch
+------------------------------------------------------------------------- */
+
+char *DumpVTU::array_data(int a, int n)
+{
+  bigint nbytes = array_bytes(a,n);
+  if (nbytes > maxscratch) {
+    maxscratch = nbytes;
+    memory->destroy(scratch);
+    memory->create(scratch,(int) maxscratch,"dump:scratch");
+  }
+  fill_array(a,n,scratch);
+  return scratch;
+}
+
+/* ----------------------------------------------------------------------
+   copy the size header and values of array a of n points into out
+   point data and coordinates come from the columns of the packed buf
+------------------------------------------------------------------------- */
+
+void DumpVTU::fill_array(int a, int n, char *out)
+{
+  uint64_t nbytes = DumpVTU::array_bytes(a,n) - sizeof(uint64_t);
+  memcpy(out,&nbytes,sizeof(uint64_t));
+  char *data = out + sizeof(uint64_t);
+
+  if (a < narray) {
+    int j = column[a];
+    if (vtype[j] == Dump::INT) {
+      int32_t *v = (int32_t *) data;
+      for (int i = 0; i < n; i++)
+        v[i] = static_cast<int32_t> (buf[i*size_one+j]);
+    } else if (vtype[j] == Dump::BIGINT) {
+      int64_t *v = (int64_t *) data;
+      for (int i = 0; i < n; i++)
+        v[i] = static_cast<int64_t> (buf[i*size_one+j]);
+    } else {
+      double *v = (double *) data;
+      for (int i = 0; i < n; i++)
+        v[i] = buf[i*size_one+j];
+    }
+  } else if (a == narray + POINTS) {
+    double *v = (double *) data;
+    for (int i = 0; i < n; i++)
+      for (int d = 0; d < 3; d++)
+        v[3*i+d] = buf[i*size_one+xcol[d]];
+  } else if (a == narray + CONNECTIVITY) {
+    int64_t *v = (int64_t *) data;
+    for (int i = 0; i < n; i++) v[i] = i;
+  } else if (a == narray + OFFSETS) {
+    int64_t *v = (int64_t *) data;
+    for (int i = 0; i < n; i++) v[i] = i + 1;
+  } else {
+    uint8_t *v = (uint8_t *) data;
+    for (int i = 0; i < n; i++) v[i] = 1;            // VTK_VERTEX
+  }
+}
+
+/* ----------------------------------------------------------------------
+   memory usage of dump buffers and the array scratch buffer
+------------------------------------------------------------------------- */
+
+bigint DumpVTU::memory_usage()
+{
+  bigint bytes = DumpCustom::memory_usage();
+  bytes += maxscratch;
+  return bytes;
+}
@@ -0,0 +1,100 @@
+/* -*- c++ -*- ----------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   http://lammps.sandia.gov, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#ifdef DUMP_CLASS
+
+DumpStyle(nufeb/vtu,DumpVTU)
+
+#else
+
+#ifndef LMP_DUMP_VTU_H
+#define LMP_DUMP_VTU_H
+
+#include "dump_custom.h"
+
+namespace LAMMPS_NS {
+
+class DumpVTU : public DumpCustom {
+ public:
+  DumpVTU(class LAMMPS *, int, char **);
+  virtual ~DumpVTU();
+  virtual void write();
+  virtual bigint memory_usage();
+
+ protected:
+  // arrays of a piece after its point data: coordinates and the
+  //   connectivity, offsets and types of one vertex cell per point
+  enum{POINTS,CONNECTIVITY,OFFSETS,TYPES,NEXTRA};
+
+  int narray;                  // # of point data arrays
+  int *column;                 // buf column of each point data array
+  char **array_name;           // name of each point data array
+  int xcol[3];                 // buf columns of x, y and z
+
+  char *scratch;               // one array of this proc's piece
+  bigint maxscratch;           // allocated bytes of scratch
+  const char *compressor;      // VTK compressor of the arrays, NULL if raw
+
+  virtual void init_style();
+  virtual void openfile() {}
+  virtual void write_header(bigint) {}
+  virtual void write_data(int, double *) {}
+
+  virtual void encode(int) {}
+  virtual bigint array_bytes(int, int);
+  virtual char *array_data(int, int);
+  const char *array_type(int);
+  void fill_array(int, int, char *);
+};
+
+}
+
+#endif
+#endif
+
+/* ERROR/WARNING messages:
+
+E: Dump nufeb/vtu requires x, y and z fields
+
+Point coordinates are taken from the x, y and z columns of the dump,
+they must be listed among the dumped fields.
+
+E: Dump nufeb/vtu does not support string fields
+
+Only numeric per-atom fields can be stored as VTK point data.
+
+E: Dump nufeb/vtu does not support one file per proc
+
+All procs write their piece into a single file, the filename cannot
+contain a % character.
+
+E: Dump nufeb/vtu requires one snapshot per file
+
+A VTU file holds a single snapshot, the filename must contain a *
+character that is replaced by the timestep.
+
+E: Dump nufeb/vtu does not support dump_modify sort
+
+Each proc writes the atoms it owns as a separate piece, they cannot be
+sorted across procs.
+
+E: Dump nufeb/vtu piece array is too large
+
+An array of the atoms of one proc exceeds 2 GB, use more procs.
+
+E: Cannot open dump file %s
+
+The output file could not be opened.  Check that the path and name are
+correct.
+
+*/
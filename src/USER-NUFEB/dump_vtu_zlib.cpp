@@ -0,0 +1,283 @@
+/* ----------------------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   http://lammps.sandia.gov, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#include <cstring>
+#include <cstdlib>
+#include <stdint.h>
+#include <pthread.h>
+#include <zlib.h>
+#include "dump_vtu_zlib.h"
+#include "comm.h"
+#include "error.h"
+#include "force.h"
+#include "memory.h"
+
+using namespace LAMMPS_NS;
+
+#define BLOCKSIZE 32768
+#define MINBLOCK 1024
+
+struct VTUZlibThread {
+  DumpVTUZlib *dump;
+  int tid;
+};
+
+/* ----------------------------------------------------------------------
+   dump ID group nufeb/vtu/zlib N file.*.vtu field1 field2 ...
+   same as nufeb/vtu, each array is cut into blocks that are compressed
+   by several threads in the vtkZLibDataCompressor layout, the sizes of
+   the compressed pieces then set the file offsets of each proc
+------------------------------------------------------------------------- */
+
+DumpVTUZlib::DumpVTUZlib(LAMMPS *lmp, int narg, char **arg) :
+  DumpVTU(lmp, narg, arg)
+{
+  compressor = "vtkZLibDataCompressor";
+  nthreads = comm->nthreads;
+  level = Z_DEFAULT_COMPRESSION;
+  blocksize = BLOCKSIZE;
+
+  int nentry = narray + NEXTRA;
+  raw = NULL;
+  maxraw = 0;
+  rawoff = new bigint[nentry];
+  rawsize = new bigint[nentry];
+  nblocks = new int[nentry];
+
+  ntask = maxtask = 0;
+  task_array = task_block = NULL;
+  zbuf = NULL;
+  zmax = zsize = NULL;
+  zerror = 0;
+
+  out = NULL;
+  maxout = 0;
+  outoff = new bigint[nentry];
+  outsize = new bigint[nentry];
+}
+
+/* ---------------------------------------------------------------------- */
+
+DumpVTUZlib::~DumpVTUZlib()
+{
+  memory->sfree(raw);
+  delete [] rawoff;
+  delete [] rawsize;
+  delete [] nblocks;
+  memory->destroy(task_array);
+  memory->destroy(task_block);
+  for (int t = 0; t < maxtask; t++) free(zbuf[t]);
+  memory->sfree(zbuf);
+  memory->destroy(zmax);
+  memory->destroy(zsize);
+  memory->sfree(out);
+  delete [] outoff;
+  delete [] outsize;
+}
+
+/* ---------------------------------------------------------------------- */
+
+int DumpVTUZlib::modify_param(int narg, char **arg)
+{
+  if (strcmp(arg[0],"threads") == 0) {
+    if (narg < 2) error->all(FLERR,"Illegal dump_modify command");
+    nthreads = force->inumeric(FLERR,arg[1]);
+    if (nthreads < 1) error->all(FLERR,"Illegal dump_modify command");
+    return 2;
+  } else if (strcmp(arg[0],"blocksize") == 0) {
+    if (narg < 2) error->all(FLERR,"Illegal dump_modify command");
+    bigint n = force->bnumeric(FLERR,arg[1]);
+    if (n < MINBLOCK || n > MAXSMALLINT)
+      error->all(FLERR,"Illegal dump_modify command");
+    blocksize = n;
+    return 2;
+  } else if (strcmp(arg[0],"compression_level") == 0) {
+    if (narg < 2) error->all(FLERR,"Illegal dump_modify command");
+    level = force->inumeric(FLERR,arg[1]);
+    if (level < 0 || level > 9) error->all(FLERR,"Illegal dump_modify command");
+    return 2;
+  }
+
+  return DumpVTU::modify_param(narg,arg);
+}
+
+/* ----------------------------------------------------------------------
+   fill the raw arrays of this proc's piece and compress all their
+   blocks, then lay out each array as the UInt64 header
+     [# of blocks, block size, size of a partial last block,
+     compressed size of each block] followed by the compressed blocks
+------------------------------------------------------------------------- */
+
+void DumpVTUZlib::encode(int n)
+{
+  int nentry = narray + NEXTRA;
+
+  // raw values, the size header written by fill_array() is skipped
+
+  bigint nraw = 0;
+  ntask = 0;
+  for (int a = 0; a < nentry; a++) {
+    rawoff[a] = nraw + sizeof(uint64_t);
+    rawsize[a] = DumpVTU::array_bytes(a,n) - sizeof(uint64_t);
+    nblocks[a] = (rawsize[a] + blocksize - 1) / blocksize;
+    nraw += DumpVTU::array_bytes(a,n);
+    ntask += nblocks[a];
+  }
+  if (nraw > maxraw) {
+    maxraw = nraw;
+    memory->sfree(raw);
+    raw = (char *) memory->smalloc(maxraw,"dump:raw");
+  }
+  for (int a = 0; a < nentry; a++)
+    fill_array(a,n,&raw[rawoff[a]-sizeof(uint64_t)]);
+
+  if (ntask > maxtask) {
+    zbuf = (char **) memory->srealloc(zbuf,ntask*sizeof(char *),"dump:zbuf");
+    memory->grow(zmax,ntask,"dump:zmax");
+    memory->grow(zsize,ntask,"dump:zsize");
+    memory->grow(task_array,ntask,"dump:task_array");
+    memory->grow(task_block,ntask,"dump:task_block");
+    for (int t = maxtask; t < ntask; t++) {
+      zbuf[t] = NULL;
+      zmax[t] = 0;
+    }
+    maxtask = ntask;
+  }
+  int t = 0;
+  for (int a = 0; a < nentry; a++)
+    for (int k = 0; k < nblocks[a]; k++) {
+      task_array[t] = a;
+      task_block[t] = k;
+      t++;
+    }
+
+  // compress the blocks of all arrays on nthreads threads, this one included
+
+  zerror = 0;
+  int nextra = MIN(nthreads,ntask) - 1;
+  if (nextra < 0) nextra = 0;
+  pthread_t *threads = new pthread_t[nextra];
+  VTUZlibThread *args = new VTUZlibThread[nextra+1];
+  for (int i = 0; i <= nextra; i++) {
+    args[i].dump = this;
+    args[i].tid = i;
+  }
+  for (int i = 0; i < nextra; i++)
+    pthread_create(&threads[i],NULL,&DumpVTUZlib::compress_loop,&args[i+1]);
+  compress_loop(&args[0]);
+  for (int i = 0; i < nextra; i++)
+    pthread_join(threads[i],NULL);
+  delete [] threads;
+  delete [] args;
+
+  int flagall;
+  MPI_Allreduce(&zerror,&flagall,1,MPI_INT,MPI_MAX,world);
+  if (flagall) error->all(FLERR,"Dump nufeb/vtu/zlib compression failed");
+
+  // headers and compressed blocks of each array
+
+  bigint nout = 0;
+  t = 0;
+  for (int a = 0; a < nentry; a++) {
+    outoff[a] = nout;
+    outsize[a] = (3 + nblocks[a]) * sizeof(uint64_t);
+    for (int k = 0; k < nblocks[a]; k++) outsize[a] += zsize[t+k];
+    nout += outsize[a];
+    t += nblocks[a];
+  }
+  if (nout > maxout) {
+    maxout = nout;
+    memory->sfree(out);
+    out = (char *) memory->smalloc(maxout,"dump:out");
+  }
+
+  t = 0;
+  for (int a = 0; a < nentry; a++) {
+    uint64_t *header = (uint64_t *) &out[outoff[a]];
+    header[0] = nblocks[a];
+    header[1] = blocksize;
+    header[2] = rawsize[a] % blocksize;
+    char *ptr = (char *) &header[3+nblocks[a]];
+    for (int k = 0; k < nblocks[a]; k++) {
+      header[3+k] = zsize[t];
+      memcpy(ptr,zbuf[t],zsize[t]);
+      ptr += zsize[t];
+      t++;
+    }
+  }
+}
+
+/* ---------------------------------------------------------------------- */
+
+bigint DumpVTUZlib::array_bytes(int a, int)
+{
+  return outsize[a];
+}
+
+/* ---------------------------------------------------------------------- */
+
+char *DumpVTUZlib::array_data(int a, int)
+{
+  return &out[outoff[a]];
+}
+
+/* ---------------------------------------------------------------------- */
+
+void *DumpVTUZlib::compress_loop(void *ptr)
+{
+  VTUZlibThread *arg = (VTUZlibThread *) ptr;
+  DumpVTUZlib *dump = arg->dump;
+
+  for (int t = arg->tid; t < dump->ntask; t += dump->nthreads)
+    dump->compress_block(t);
+
+  return NULL;
+}
+
+/* ----------------------------------------------------------------------
+   compress block t as a zlib stream into zbuf[t]
+------------------------------------------------------------------------- */
+
+void DumpVTUZlib::compress_block(int t)
+{
+  int a = task_array[t];
+  bigint offset = (bigint) task_block[t] * blocksize;
+  uLong n = MIN(blocksize,rawsize[a]-offset);
+
+  bigint bound = compressBound(n);
+  if (bound > zmax[t]) {
+    zmax[t] = bound;
+    free(zbuf[t]);
+    zbuf[t] = (char *) malloc(zmax[t]);
+    if (zbuf[t] == NULL) {
+      zmax[t] = 0;
+      zerror = 1;
+      return;
+    }
+  }
+
+  uLongf nz = zmax[t];
+  if (compress2((Bytef *) zbuf[t],&nz,(Bytef *) &raw[rawoff[a]+offset],n,
+                level) != Z_OK) zerror = 1;
+  zsize[t] = nz;
+}
+
+/* ---------------------------------------------------------------------- */
+
+bigint DumpVTUZlib::memory_usage()
+{
+  bigint bytes = DumpVTU::memory_usage();
+  bytes += maxraw + maxout;
+  for (int t = 0; t < maxtask; t++) bytes += zmax[t];
+  return bytes;
+}
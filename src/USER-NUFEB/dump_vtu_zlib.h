@@ -0,0 +1,83 @@
+/* -*- c++ -*- ----------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   http://lammps.sandia.gov, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#ifdef DUMP_CLASS
+
+DumpStyle(nufeb/vtu/zlib,DumpVTUZlib)
+
+#else
+
+#ifndef LMP_DUMP_VTU_ZLIB_H
+#define LMP_DUMP_VTU_ZLIB_H
+
+#include "dump_vtu.h"
+
+namespace LAMMPS_NS {
+
+class DumpVTUZlib : public DumpVTU {
+ public:
+  DumpVTUZlib(class LAMMPS *, int, char **);
+  virtual ~DumpVTUZlib();
+  virtual bigint memory_usage();
+
+ protected:
+  int nthreads;         // # of compression threads
+  int level;            // zlib compression level
+  bigint blocksize;     // uncompressed bytes per compressed block
+
+  char *raw;            // uncompressed arrays of this proc's piece
+  bigint maxraw;
+  bigint *rawoff;       // offset of each array in raw
+  bigint *rawsize;      // uncompressed bytes of each array
+  int *nblocks;         // # of blocks of each array
+
+  int ntask;            // # of blocks of all arrays
+  int maxtask;
+  int *task_array;      // array and block index of each block
+  int *task_block;
+  char **zbuf;          // compressed data of each block
+  bigint *zmax;         // allocated bytes of each zbuf
+  bigint *zsize;        // # of bytes in each zbuf
+  int zerror;           // set by a thread if compression fails
+
+  char *out;            // compressed arrays with their headers
+  bigint maxout;
+  bigint *outoff;       // offset of each array in out
+  bigint *outsize;      // bytes of each array in out
+
+  virtual int modify_param(int, char **);
+  virtual void encode(int);
+  virtual bigint array_bytes(int, int);
+  virtual char *array_data(int, int);
+
+  void compress_block(int);
+  static void *compress_loop(void *);
+};
+
+}
+
+#endif
+#endif
+
+/* ERROR/WARNING messages:
+
+E: Illegal dump_modify command
+
+Self-explanatory.
+
+E: Dump nufeb/vtu/zlib compression failed
+
+Zlib could not compress a block of an array, most likely because it
+ran out of memory.
+
+*/
@@ -0,0 +1,320 @@
+/* ----------------------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   http://lammps.sandia.gov, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#include <cstdio>
+#include <cstring>
+#include "fix_ave_grid.h"
+#include "error.h"
+#include "force.h"
+#include "grid.h"
+#include "group.h"
+#include "memory.h"
+
+using namespace LAMMPS_NS;
+using namespace FixConst;
+
+enum{CONC,REAC,DENS,GROWTH};
+
+/* ---------------------------------------------------------------------- */
+
+FixAveGrid::FixAveGrid(LAMMPS *lmp, int narg, char **arg) :
+  Fix(lmp, narg, arg)
+{
+  if (narg < 5)
+    error->all(FLERR, "Illegal fix nufeb/ave/grid command");
+
+  if (lmp->kokkos)
+    error->all(FLERR, "Fix nufeb/ave/grid is not supported with KOKKOS");
+
+  compute_flag = 1;
+  var_flag = 0;
+  minmax_flag = 0;
+
+  ncomp = 0;
+  cname = NULL;
+  cfield = NULL;
+  cindex = NULL;
+  nsample = 0;
+  ncells = 0;
+  mean = NULL;
+  m2 = NULL;
+  vmin = NULL;
+  vmax = NULL;
+
+  nwindow = force->inumeric(FLERR, arg[3]);
+  if (nwindow < 1)
+    error->all(FLERR, "Illegal fix nufeb/ave/grid command");
+
+  nfield = 0;
+  fields = new int[narg];
+
+  int iarg = 4;
+  while (iarg < narg) {
+    if (strcmp(arg[iarg], "con") == 0) {
+      fields[nfield++] = CONC;
+      iarg++;
+    } else if (strcmp(arg[iarg], "rea") == 0) {
+      fields[nfield++] = REAC;
+      iarg++;
+    } else if (strcmp(arg[iarg], "den") == 0) {
+      fields[nfield++] = DENS;
+      iarg++;
+    } else if (strcmp(arg[iarg], "gro") == 0) {
+      fields[nfield++] = GROWTH;
+      iarg++;
+    } else if (strcmp(arg[iarg], "var") == 0) {
+      if (iarg+2 > narg)
+	error->all(FLERR, "Illegal fix nufeb/ave/grid command");
+      if (strcmp(arg[iarg+1], "yes") == 0) var_flag = 1;
+      else if (strcmp(arg[iarg+1], "no") == 0) var_flag = 0;
+      else error->all(FLERR, "Illegal fix nufeb/ave/grid command");
+      iarg += 2;
+    } else if (strcmp(arg[iarg], "minmax") == 0) {
+      if (iarg+2 > narg)
+	error->all(FLERR, "Illegal fix nufeb/ave/grid command");
+      if (strcmp(arg[iarg+1], "yes") == 0) minmax_flag = 1;
+      else if (strcmp(arg[iarg+1], "no") == 0) minmax_flag = 0;
+      else error->all(FLERR, "Illegal fix nufeb/ave/grid command");
+      iarg += 2;
+    } else {
+      error->all(FLERR, "Illegal fix nufeb/ave/grid command");
+    }
+  }
+
+  if (!nfield)
+    error->all(FLERR, "Illegal fix nufeb/ave/grid command");
+}
+
+/* ---------------------------------------------------------------------- */
+
+FixAveGrid::~FixAveGrid()
+{
+  deallocate();
+  delete [] fields;
+}
+
+/* ---------------------------------------------------------------------- */
+
+int FixAveGrid::modify_param(int narg, char **arg)
+{
+  if (strcmp(arg[0], "compute") == 0) {
+    if (narg < 2) error->all(FLERR, "Illegal fix_modify command");
+    if (strcmp(arg[1], "yes") == 0) {
+      compute_flag = 1;
+    } else if (strcmp(arg[1], "no") == 0) {
+      compute_flag = 0;
+    } else {
+      error->all(FLERR, "Illegal fix_modify command");
+    }
+    return 2;
+  }
+  return 0;
+}
+
+/* ---------------------------------------------------------------------- */
+
+int FixAveGrid::setmask()
+{
+  int mask = 0;
+  mask |= END_OF_STEP;
+  return mask;
+}
+
+/* ----------------------------------------------------------------------
+   density and growth components follow the groups defined at the start
+   of the run, the window restarts if they or the grid changed
+------------------------------------------------------------------------- */
+
+void FixAveGrid::init()
+{
+  int n = 0;
+  for (int f = 0; f < nfield; f++)
+    n += (fields[f] == CONC || fields[f] == REAC) ? grid->nsubs : group->ngroup;
+
+  if (n != ncomp || ncells != grid->ncells) allocate();
+}
+
+/* ---------------------------------------------------------------------- */
+
+void FixAveGrid::end_of_step()
+{
+  if (compute_flag)
+    compute();
+}
+
+/* ----------------------------------------------------------------------
+   add one sample of every component to the running statistics, the
+   first sample after a full window starts a new one
+------------------------------------------------------------------------- */
+
+void FixAveGrid::compute()
+{
+  if (ncells != grid->ncells) allocate();
+  if (nsample == nwindow) nsample = 0;
+  nsample++;
+
+  const double inv = 1.0 / nsample;
+  for (int k = 0; k < ncomp; k++) {
+    int stride;
+    const double *x = source(k, stride);
+    double *mk = mean[k];
+    if (nsample == 1) {
+      for (int i = 0; i < ncells; i++) mk[i] = x[i*stride];
+      if (var_flag)
+	for (int i = 0; i < ncells; i++) m2[k][i] = 0.0;
+      if (minmax_flag)
+	for (int i = 0; i < ncells; i++) vmin[k][i] = vmax[k][i] = mk[i];
+      continue;
+    }
+    // Welford's update of the mean and the squared deviations
+    for (int i = 0; i < ncells; i++) {
+      double xi = x[i*stride];
+      double delta = xi - mk[i];
+      mk[i] += delta * inv;
+      if (var_flag) m2[k][i] += delta * (xi - mk[i]);
+      if (minmax_flag) {
+	if (xi < vmin[k][i]) vmin[k][i] = xi;
+	if (xi > vmax[k][i]) vmax[k][i] = xi;
+      }
+    }
+  }
+}
+
+/* ----------------------------------------------------------------------
+   statistics for dump grid/vtk and nufeb/hdf5, dim = 2 for per-component
+   grid arrays, variances are m2 / nsample
+------------------------------------------------------------------------- */
+
+void *FixAveGrid::extract(const char *str, int &dim)
+{
+  dim = 0;
+  if (strcmp(str, "ncomp") == 0) return &ncomp;
+  if (strcmp(str, "nsample") == 0) return &nsample;
+  dim = 1;
+  if (strcmp(str, "cname") == 0) return cname;
+  dim = 2;
+  if (strcmp(str, "mean") == 0) return mean;
+  if (strcmp(str, "m2") == 0) return m2;
+  if (strcmp(str, "min") == 0) return vmin;
+  if (strcmp(str, "max") == 0) return vmax;
+  return NULL;
+}
+
+/* ----------------------------------------------------------------------
+   first value and stride of a component, growth rates are interleaved
+   with the second growth coefficient
+------------------------------------------------------------------------- */
+
+const double *FixAveGrid::source(int k, int &stride)
+{
+  int j = cindex[k];
+  stride = 1;
+  switch (cfield[k]) {
+  case CONC: return grid->conc[j];
+  case REAC: return grid->reac[j];
+  case DENS: return grid->dens[j];
+  default:
+    stride = 2;
+    return &grid->growth[j][0][0];
+  }
+}
+
+/* ---------------------------------------------------------------------- */
+
+void FixAveGrid::allocate()
+{
+  deallocate();
+
+  ncomp = 0;
+  for (int f = 0; f < nfield; f++)
+    ncomp += (fields[f] == CONC || fields[f] == REAC) ? grid->nsubs : group->ngroup;
+  ncells = grid->ncells;
+  nsample = 0;
+
+  cfield = new int[ncomp];
+  cindex = new int[ncomp];
+  cname = new char*[ncomp];
+  int k = 0;
+  for (int f = 0; f < nfield; f++) {
+    const char *prefix;
+    int n;
+    char **names;
+    if (fields[f] == CONC) {
+      prefix = "concentration";
+      n = grid->nsubs;
+      names = grid->sub_names;
+    } else if (fields[f] == REAC) {
+      prefix = "reaction";
+      n = grid->nsubs;
+      names = grid->sub_names;
+    } else if (fields[f] == DENS) {
+      prefix = "density";
+      n = group->ngroup;
+      names = group->names;
+    } else {
+      prefix = "growth";
+      n = group->ngroup;
+      names = group->names;
+    }
+    for (int j = 0; j < n; j++) {
+      cfield[k] = fields[f];
+      cindex[k] = j;
+      cname[k] = new char[strlen(prefix) + strlen(names[j]) + 2];
+      sprintf(cname[k], "%s_%s", prefix, names[j]);
+      k++;
+    }
+  }
+
+  // dumps may write the statistics before the first sample
+  memory->create(mean, ncomp, ncells, "nufeb/ave/grid:mean");
+  if (var_flag) memory->create(m2, ncomp, ncells, "nufeb/ave/grid:m2");
+  if (minmax_flag) {
+    memory->create(vmin, ncomp, ncells, "nufeb/ave/grid:vmin");
+    memory->create(vmax, ncomp, ncells, "nufeb/ave/grid:vmax");
+  }
+  for (int k = 0; k < ncomp; k++) {
+    for (int i = 0; i < ncells; i++) {
+      mean[k][i] = 0.0;
+      if (var_flag) m2[k][i] = 0.0;
+      if (minmax_flag) vmin[k][i] = vmax[k][i] = 0.0;
+    }
+  }
+}
+
+/* ---------------------------------------------------------------------- */
+
+void FixAveGrid::deallocate()
+{
+  for (int k = 0; k < ncomp; k++)
+    delete [] cname[k];
+  delete [] cname;
+  delete [] cfield;
+  delete [] cindex;
+  cname = NULL;
+  cfield = cindex = NULL;
+  memory->destroy(mean);
+  memory->destroy(m2);
+  memory->destroy(vmin);
+  memory->destroy(vmax);
+  ncomp = 0;
+}
+
+/* ----------------------------------------------------------------------
+   memory usage of the running statistics
+------------------------------------------------------------------------- */
+
+double FixAveGrid::memory_usage()
+{
+  int nstat = 1 + var_flag + 2 * minmax_flag;
+  return (double) nstat * ncomp * ncells * sizeof(double);
+}
@@ -0,0 +1,81 @@
+/* -*- c++ -*- ----------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   http://lammps.sandia.gov, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#ifdef FIX_CLASS
+
+FixStyle(nufeb/ave/grid,FixAveGrid)
+
+#else
+
+#ifndef LMP_FIX_AVE_GRID_H
+#define LMP_FIX_AVE_GRID_H
+
+#include "fix.h"
+
+namespace LAMMPS_NS {
+
+class FixAveGrid : public Fix {
+ public:
+  int compute_flag;
+
+  // averaged components, one per substrate or group of each field
+  int ncomp;
+  char **cname;                // e.g. "concentration_o2"
+  int nsample;                 // # of samples in the current window
+  int var_flag;                // 1 if variances are accumulated
+  int minmax_flag;             // 1 if minima and maxima are accumulated
+  double **mean;               // running mean of each component
+  double **m2;                 // sum of squared deviations from the mean
+  double **vmin, **vmax;
+
+  FixAveGrid(class LAMMPS *, int, char **);
+  ~FixAveGrid();
+  int modify_param(int, char **);
+  int setmask();
+  void init();
+  void end_of_step();
+  void compute();
+  void *extract(const char *, int &);
+  double memory_usage();
+
+ protected:
+  int nwindow;                 // # of biological steps averaged
+  int nfield;
+  int *fields;                 // CONC, REAC, DENS or GROWTH
+  int *cfield;                 // field of each component
+  int *cindex;                 // substrate or group of each component
+  int ncells;
+
+  void allocate();
+  void deallocate();
+  const double *source(int, int &);
+};
+
+}
+
+#endif
+#endif
+
+/* ERROR/WARNING messages:
+
+E: Illegal ... command
+
+Self-explanatory.  Check the input script syntax and compare to the
+documentation for the command.  You can use -echo screen as a
+command-line option when running LAMMPS to see the offending line.
+
+E: Fix nufeb/ave/grid is not supported with KOKKOS
+
+Grid fields are averaged on the host copy of the grid.
+
+*/
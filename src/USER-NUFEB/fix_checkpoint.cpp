@@ -0,0 +1,643 @@
+/* ----------------------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   http://lammps.sandia.gov, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#include "fix_checkpoint.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include "atom.h"
+#include "atom_vec.h"
+#include "atom_vec_bacillus.h"
+#include "comm.h"
+#include "error.h"
+#include "force.h"
+#include "grid.h"
+#include "update.h"
+
+using namespace LAMMPS_NS;
+using namespace FixConst;
+
+enum{BASE,DELTA};
+
+#define MAGIC 0x4e434b50        // "NCKP"
+#define BUFEXTRA 1000
+#define MAXQUANT 1073741824.0
+
+/* ---------------------------------------------------------------------- */
+
+template <class T>
+static void put(std::vector<char> &v, const T *p, int n)
+{
+  const char *c = (const char *) p;
+  v.insert(v.end(), c, c + n * sizeof(T));
+}
+
+template <class T>
+static void get(const char *&p, T *out, int n)
+{
+  memcpy(out, p, n * sizeof(T));
+  p += n * sizeof(T);
+}
+
+/* ---------------------------------------------------------------------- */
+
+FixCheckpoint::FixCheckpoint(LAMMPS *lmp, int narg, char **arg) :
+  Fix(lmp, narg, arg)
+{
+  if (narg < 5) error->all(FLERR,"Illegal fix nufeb/checkpoint command");
+
+  if (lmp->kokkos)
+    error->all(FLERR,"Fix nufeb/checkpoint is not supported with KOKKOS");
+
+  if (igroup != 0)
+    error->all(FLERR,"Fix nufeb/checkpoint must use group all");
+  if (!atom->tag_enable)
+    error->all(FLERR,"Fix nufeb/checkpoint requires atom IDs");
+
+  nevery = force->inumeric(FLERR,arg[3]);
+  if (nevery <= 0) error->all(FLERR,"Illegal fix nufeb/checkpoint command");
+
+  int n = strlen(arg[4]) + 1;
+  prefix = new char[n];
+  strcpy(prefix,arg[4]);
+
+  nbase = 10;
+  quantum = 0.0;
+  tol = 0.0;
+  int restore_flag = 0;
+
+  int iarg = 5;
+  while (iarg < narg) {
+    if (strcmp(arg[iarg],"base") == 0) {
+      if (iarg+2 > narg) error->all(FLERR,"Illegal fix nufeb/checkpoint command");
+      nbase = force->inumeric(FLERR,arg[iarg+1]);
+      if (nbase <= 0) error->all(FLERR,"Illegal fix nufeb/checkpoint command");
+      iarg += 2;
+    } else if (strcmp(arg[iarg],"quantum") == 0) {
+      if (iarg+2 > narg) error->all(FLERR,"Illegal fix nufeb/checkpoint command");
+      quantum = force->numeric(FLERR,arg[iarg+1]);
+      if (quantum < 0.0) error->all(FLERR,"Illegal fix nufeb/checkpoint command");
+      iarg += 2;
+    } else if (strcmp(arg[iarg],"tol") == 0) {
+      if (iarg+2 > narg) error->all(FLERR,"Illegal fix nufeb/checkpoint command");
+      tol = force->numeric(FLERR,arg[iarg+1]);
+      if (tol < 0.0) error->all(FLERR,"Illegal fix nufeb/checkpoint command");
+      iarg += 2;
+    } else if (strcmp(arg[iarg],"restore") == 0) {
+      if (iarg+2 > narg) error->all(FLERR,"Illegal fix nufeb/checkpoint command");
+      if (strcmp(arg[iarg+1],"yes") == 0) restore_flag = 1;
+      else if (strcmp(arg[iarg+1],"no") == 0) restore_flag = 0;
+      else error->all(FLERR,"Illegal fix nufeb/checkpoint command");
+      iarg += 2;
+    } else error->all(FLERR,"Illegal fix nufeb/checkpoint command");
+  }
+
+  compute_flag = 1;
+  ncheckpoint = 0;
+  parity = 1;
+
+  if (restore_flag) restore();
+
+  busy = quit = 0;
+  pending_base = 0;
+  pending_file = new char[n + 32];
+  pthread_mutex_init(&mutex,NULL);
+  pthread_cond_init(&cond,NULL);
+  pthread_create(&writer,NULL,&FixCheckpoint::writer_loop,this);
+}
+
+/* ---------------------------------------------------------------------- */
+
+FixCheckpoint::~FixCheckpoint()
+{
+  // flush the record in flight before stopping the writer
+  pthread_mutex_lock(&mutex);
+  while (busy) pthread_cond_wait(&cond,&mutex);
+  quit = 1;
+  pthread_cond_broadcast(&cond);
+  pthread_mutex_unlock(&mutex);
+  pthread_join(writer,NULL);
+
+  pthread_mutex_destroy(&mutex);
+  pthread_cond_destroy(&cond);
+
+  delete [] prefix;
+  delete [] pending_file;
+}
+
+/* ---------------------------------------------------------------------- */
+
+int FixCheckpoint::setmask()
+{
+  int mask = 0;
+  mask |= END_OF_STEP;
+  return mask;
+}
+
+/* ---------------------------------------------------------------------- */
+
+void FixCheckpoint::init()
+{
+  if (atom->map_style == 0)
+    error->all(FLERR,"Fix nufeb/checkpoint requires an atom map, see atom_modify");
+}
+
+/* ----------------------------------------------------------------------
+   nufeb/run clears compute_flag and calls checkpoint() once per
+   biological step, end_of_step() is also invoked by each relaxation
+   iteration
+------------------------------------------------------------------------- */
+
+void FixCheckpoint::end_of_step()
+{
+  if (compute_flag)
+    checkpoint();
+}
+
+/* ----------------------------------------------------------------------
+   pack a full image every nbase checkpoints and deltas in between,
+   the record is written by the background thread
+------------------------------------------------------------------------- */
+
+void FixCheckpoint::checkpoint()
+{
+  int base = (ncheckpoint == 0);
+  int maxexchange = comm->maxexchange_atom + comm->maxexchange_fix;
+  if ((int) buf.size() < maxexchange + BUFEXTRA)
+    buf.resize(maxexchange + BUFEXTRA);
+
+  record.clear();
+  int type = base ? BASE : DELTA;
+  double atime = update->atime;
+  bigint nbytes = 0;
+  put(record, &type, 1);
+  put(record, &update->ntimestep, 1);
+  put(record, &atime, 1);
+  size_t size_offset = record.size();
+  put(record, &nbytes, 1);
+
+  size_t start = record.size();
+  if (base) pack_base();
+  else pack_delta();
+  pack_grid();
+
+  nbytes = record.size() - start;
+  memcpy(&record[size_offset], &nbytes, sizeof(bigint));
+  int magic = MAGIC;
+  put(record, &magic, 1);
+
+  submit(base);
+  ncheckpoint = (ncheckpoint + 1) % nbase;
+}
+
+/* ----------------------------------------------------------------------
+   full image of all owned atoms, as in atom exchange
+------------------------------------------------------------------------- */
+
+void FixCheckpoint::pack_base()
+{
+  int nlocal = atom->nlocal;
+  tagint *tag = atom->tag;
+
+  ref.clear();
+  put(record, &nlocal, 1);
+  for (int i = 0; i < nlocal; i++) {
+    int m = atom->avec->pack_exchange(i, &buf[0]);
+    put(record, &buf[0], m);
+    ref[tag[i]].assign(buf.begin(), buf.begin() + m);
+  }
+}
+
+/* ----------------------------------------------------------------------
+   changes since the last record: atoms that left this proc by tag,
+   full images of new and changed atoms, and quantized position
+   deltas of atoms that only moved
+------------------------------------------------------------------------- */
+
+void FixCheckpoint::pack_delta()
+{
+  int nlocal = atom->nlocal;
+  tagint *tag = atom->tag;
+
+  std::vector<tagint> removed;
+  std::map<tagint, std::vector<double> >::iterator it = ref.begin();
+  while (it != ref.end()) {
+    int i = atom->map(it->first);
+    if (i < 0 || i >= nlocal) {
+      removed.push_back(it->first);
+      ref.erase(it++);
+    } else ++it;
+  }
+
+  std::vector<char> full, moved;
+  int nfull = 0;
+  int nmoved = 0;
+  for (int i = 0; i < nlocal; i++) {
+    int m = atom->avec->pack_exchange(i, &buf[0]);
+    std::vector<double> &old = ref[tag[i]];
+
+    // positions are buf[1-3] in the exchange buffer of all atom styles
+    int q[3];
+    int full_flag = ((int) old.size() != m || changed(&buf[0], &old[0], m));
+    if (!full_flag) {
+      for (int d = 0; d < 3; d++) {
+	double del = buf[1+d] - old[1+d];
+	if (quantum == 0.0) {
+	  if (del != 0.0) full_flag = 1;
+	  q[d] = 0;
+	} else {
+	  double s = floor(del / quantum + 0.5);
+	  if (fabs(s) > MAXQUANT) full_flag = 1;
+	  else q[d] = static_cast<int>(s);
+	}
+      }
+    }
+
+    if (full_flag) {
+      put(full, &buf[0], m);
+      old.assign(buf.begin(), buf.begin() + m);
+      nfull++;
+    } else if (q[0] || q[1] || q[2]) {
+      // the reference follows the quantized position, as restored
+      put(moved, &tag[i], 1);
+      put(moved, q, 3);
+      for (int d = 0; d < 3; d++)
+	old[1+d] += q[d] * quantum;
+      nmoved++;
+    }
+  }
+
+  int nremoved = removed.size();
+  put(record, &nremoved, 1);
+  if (nremoved) put(record, &removed[0], nremoved);
+  put(record, &nfull, 1);
+  record.insert(record.end(), full.begin(), full.end());
+  put(record, &nmoved, 1);
+  record.insert(record.end(), moved.begin(), moved.end());
+}
+
+/* ----------------------------------------------------------------------
+   concentrations of all cells on this proc and reactor bulk values
+------------------------------------------------------------------------- */
+
+void FixCheckpoint::pack_grid()
+{
+  int nconc = 0;
+  int nbulk = 0;
+  if (grid->grid_exist && grid->conc) nconc = grid->nsubs * grid->ncells;
+  if (grid->grid_exist && grid->bulk) nbulk = grid->nsubs;
+
+  put(record, &nconc, 1);
+  if (nconc) {
+    put(record, grid->sublo, 3);
+    put(record, grid->subhi, 3);
+    for (int s = 0; s < grid->nsubs; s++)
+      put(record, grid->conc[s], grid->ncells);
+  }
+  put(record, &nbulk, 1);
+  if (nbulk) put(record, grid->bulk, nbulk);
+}
+
+/* ----------------------------------------------------------------------
+   1 if any value other than the size and position differs,
+   integers packed as ubuf are denormal and always compared exactly
+------------------------------------------------------------------------- */
+
+int FixCheckpoint::changed(const double *a, const double *b, int m)
+{
+  for (int k = 4; k < m; k++) {
+    if (memcmp(&a[k], &b[k], sizeof(double)) == 0) continue;
+    if (tol > 0.0 && std::fpclassify(a[k]) == FP_NORMAL &&
+	std::fpclassify(b[k]) == FP_NORMAL &&
+	fabs(a[k] - b[k]) <= tol * MAX(fabs(a[k]), fabs(b[k]))) continue;
+    return 1;
+  }
+  return 0;
+}
+
+/* ----------------------------------------------------------------------
+   hand the packed record to the writer, a full image starts the other
+   file so the previous image stays intact until this one is written
+------------------------------------------------------------------------- */
+
+void FixCheckpoint::submit(int base)
+{
+  wait();
+
+  if (base) parity = 1 - parity;
+  pending.swap(record);
+  pending_base = base;
+  sprintf(pending_file, "%s.%d.%d", prefix, comm->me, parity);
+
+  pthread_mutex_lock(&mutex);
+  busy = 1;
+  pthread_cond_broadcast(&cond);
+  pthread_mutex_unlock(&mutex);
+}
+
+/* ---------------------------------------------------------------------- */
+
+void FixCheckpoint::wait()
+{
+  pthread_mutex_lock(&mutex);
+  while (busy) pthread_cond_wait(&cond,&mutex);
+  pthread_mutex_unlock(&mutex);
+
+  // the writer cannot abort, errors are reported here
+  if (pending_base < 0) {
+    char str[128];
+    snprintf(str,128,"Cannot open checkpoint file %s",pending_file);
+    error->one(FLERR,str);
+  }
+}
+
+/* ---------------------------------------------------------------------- */
+
+void *FixCheckpoint::writer_loop(void *ptr)
+{
+  FixCheckpoint *fix = (FixCheckpoint *) ptr;
+
+  pthread_mutex_lock(&fix->mutex);
+  while (1) {
+    while (!fix->busy && !fix->quit)
+      pthread_cond_wait(&fix->cond,&fix->mutex);
+    if (!fix->busy) break;
+    pthread_mutex_unlock(&fix->mutex);
+
+    fix->write_pending();
+
+    pthread_mutex_lock(&fix->mutex);
+    fix->busy = 0;
+    pthread_cond_broadcast(&fix->cond);
+  }
+  pthread_mutex_unlock(&fix->mutex);
+
+  return NULL;
+}
+
+/* ----------------------------------------------------------------------
+   runs on the writer thread, a full image truncates its file and
+   writes the file header first
+------------------------------------------------------------------------- */
+
+void FixCheckpoint::write_pending()
+{
+  FILE *fp = fopen(pending_file, pending_base ? "wb" : "ab");
+  if (fp == NULL) {
+    pending_base = -1;
+    return;
+  }
+
+  if (pending_base) {
+    int header[3];
+    header[0] = MAGIC;
+    header[1] = comm->nprocs;
+    header[2] = comm->me;
+    fwrite(header, sizeof(int), 3, fp);
+  }
+  int magic = MAGIC;
+  fwrite(&magic, sizeof(int), 1, fp);
+  fwrite(&pending[0], 1, pending.size(), fp);
+  fclose(fp);
+}
+
+/* ----------------------------------------------------------------------
+   restore atoms, grid and timestep from the latest checkpoint that is
+   complete on all procs, by replaying a full image and its deltas
+------------------------------------------------------------------------- */
+
+void FixCheckpoint::restore()
+{
+  int nprocs = comm->nprocs;
+  int n = strlen(prefix) + 32;
+  char *file = new char[n];
+
+  bigint range[4];
+  for (int p = 0; p < 2; p++) {
+    sprintf(file, "%s.%d.%d", prefix, comm->me, p);
+    scan(file, range[2*p], range[2*p+1]);
+  }
+
+  bigint *all = new bigint[4*nprocs];
+  MPI_Allgather(range, 4, MPI_LMP_BIGINT, all, 4, MPI_LMP_BIGINT, world);
+
+  // latest step inside a complete file range on every proc
+  bigint step = -1;
+  for (int k = 0; k < 4*nprocs; k += 2) {
+    bigint s = all[k+1];
+    if (s <= step) continue;
+    int ok = 1;
+    for (int r = 0; r < nprocs && ok; r++) {
+      bigint *a = &all[4*r];
+      ok = (a[0] >= 0 && a[0] <= s && s <= a[1]) ||
+	(a[2] >= 0 && a[2] <= s && s <= a[3]);
+    }
+    if (ok) step = s;
+  }
+  delete [] all;
+  if (step < 0) error->all(FLERR,"No checkpoint common to all processors");
+
+  // newest file holding the step
+  int p = -1;
+  for (int q = 0; q < 2; q++) {
+    if (range[2*q] < 0 || range[2*q] > step || step > range[2*q+1]) continue;
+    if (p < 0 || range[2*q] > range[2*p]) p = q;
+  }
+  parity = p;
+  sprintf(file, "%s.%d.%d", prefix, comm->me, p);
+  replay(file, step);
+  delete [] file;
+
+  if (comm->me == 0) {
+    if (screen) fprintf(screen,"Restored checkpoint at step " BIGINT_FORMAT "\n",step);
+    if (logfile) fprintf(logfile,"Restored checkpoint at step " BIGINT_FORMAT "\n",step);
+  }
+}
+
+/* ----------------------------------------------------------------------
+   first and last step of the complete records in a checkpoint file,
+   -1 if the file is missing or does not start with a full image
+------------------------------------------------------------------------- */
+
+void FixCheckpoint::scan(const char *file, bigint &first, bigint &last)
+{
+  first = last = -1;
+  FILE *fp = fopen(file, "rb");
+  if (fp == NULL) return;
+
+  int header[3];
+  if (fread(header, sizeof(int), 3, fp) != 3 || header[0] != MAGIC ||
+      header[1] != comm->nprocs || header[2] != comm->me) {
+    fclose(fp);
+    return;
+  }
+
+  while (1) {
+    int magic, type;
+    bigint step, nbytes;
+    double atime;
+    if (fread(&magic, sizeof(int), 1, fp) != 1 || magic != MAGIC) break;
+    if (fread(&type, sizeof(int), 1, fp) != 1) break;
+    if (fread(&step, sizeof(bigint), 1, fp) != 1) break;
+    if (fread(&atime, sizeof(double), 1, fp) != 1) break;
+    if (fread(&nbytes, sizeof(bigint), 1, fp) != 1) break;
+    if (fseek(fp, nbytes, SEEK_CUR) != 0) break;
+    if (fread(&magic, sizeof(int), 1, fp) != 1 || magic != MAGIC) break;
+    if (first < 0) {
+      if (type != BASE) break;
+      first = step;
+    }
+    last = step;
+  }
+  if (last < 0) first = -1;
+  fclose(fp);
+}
+
+/* ----------------------------------------------------------------------
+   replay the records of a file up to step and replace all atoms
+------------------------------------------------------------------------- */
+
+void FixCheckpoint::replay(const char *file, bigint step)
+{
+  FILE *fp = fopen(file, "rb");
+  int header[3];
+  if (fp == NULL || fread(header, sizeof(int), 3, fp) != 3)
+    error->one(FLERR,"Cannot read checkpoint file");
+
+  std::vector<char> payload;
+  std::vector<double> conc, bulk;
+  int lo[3], hi[3];
+  double atime = 0.0;
+  int nconc = 0;
+  ref.clear();
+  while (1) {
+    int magic, type;
+    bigint s, nbytes;
+    if (fread(&magic, sizeof(int), 1, fp) != 1 ||
+	fread(&type, sizeof(int), 1, fp) != 1 ||
+	fread(&s, sizeof(bigint), 1, fp) != 1 ||
+	fread(&atime, sizeof(double), 1, fp) != 1 ||
+	fread(&nbytes, sizeof(bigint), 1, fp) != 1)
+      error->one(FLERR,"Cannot read checkpoint file");
+    payload.resize(nbytes + sizeof(int));
+    if (fread(&payload[0], 1, payload.size(), fp) != payload.size())
+      error->one(FLERR,"Cannot read checkpoint file");
+
+    // tags are buf[7] in the exchange buffer of all atom styles
+    const char *ptr = &payload[0];
+    if (type == BASE) {
+      int n;
+      get(ptr, &n, 1);
+      ref.clear();
+      for (int i = 0; i < n; i++) {
+	double size;
+	memcpy(&size, ptr, sizeof(double));
+	std::vector<double> one(static_cast<int>(size));
+	get(ptr, &one[0], one.size());
+	ref[(tagint) ubuf(one[7]).i].swap(one);
+      }
+    } else {
+      int nremoved, nfull, nmoved;
+      get(ptr, &nremoved, 1);
+      for (int i = 0; i < nremoved; i++) {
+	tagint t;
+	get(ptr, &t, 1);
+	ref.erase(t);
+      }
+      get(ptr, &nfull, 1);
+      for (int i = 0; i < nfull; i++) {
+	double size;
+	memcpy(&size, ptr, sizeof(double));
+	std::vector<double> one(static_cast<int>(size));
+	get(ptr, &one[0], one.size());
+	ref[(tagint) ubuf(one[7]).i].swap(one);
+      }
+      get(ptr, &nmoved, 1);
+      for (int i = 0; i < nmoved; i++) {
+	tagint t;
+	int q[3];
+	get(ptr, &t, 1);
+	get(ptr, q, 3);
+	std::vector<double> &one = ref[t];
+	for (int d = 0; d < 3; d++)
+	  one[1+d] += q[d] * quantum;
+      }
+    }
+
+    int nbulk;
+    get(ptr, &nconc, 1);
+    if (nconc) {
+      get(ptr, lo, 3);
+      get(ptr, hi, 3);
+      conc.resize(nconc);
+      get(ptr, &conc[0], nconc);
+    }
+    get(ptr, &nbulk, 1);
+    bulk.resize(nbulk);
+    if (nbulk) get(ptr, &bulk[0], nbulk);
+
+    if (s == step) break;
+  }
+  fclose(fp);
+
+  // replace all owned atoms, removing bonus data as delete_atoms does
+
+  AtomVec *avec = atom->avec;
+  while (atom->nlocal > 0) {
+    avec->copy(atom->nlocal-1, atom->nlocal-1, 1);
+    atom->nlocal--;
+  }
+  atom->nghost = 0;
+  std::map<tagint, std::vector<double> >::iterator it;
+  for (it = ref.begin(); it != ref.end(); ++it)
+    avec->unpack_exchange(&it->second[0]);
+
+  bigint nblocal = atom->nlocal;
+  MPI_Allreduce(&nblocal,&atom->natoms,1,MPI_LMP_BIGINT,MPI_SUM,world);
+  AtomVecBacillus *avec_bacillus = (AtomVecBacillus *) atom->style_match("bacillus");
+  if (avec_bacillus) {
+    bigint nlocal_bonus = avec_bacillus->nlocal_bonus;
+    MPI_Allreduce(&nlocal_bonus,&atom->nbacilli,1,MPI_LMP_BIGINT,MPI_SUM,world);
+  }
+  if (atom->map_style) {
+    atom->map_init();
+    atom->map_set();
+  }
+
+  // grid values, only valid for the same decomposition
+
+  int flag = 0;
+  if (nconc) {
+    if (!grid->grid_exist || grid->nsubs * grid->ncells != nconc) flag = 1;
+    else {
+      for (int d = 0; d < 3; d++)
+	if (lo[d] != grid->sublo[d] || hi[d] != grid->subhi[d]) flag = 1;
+    }
+  }
+  if (bulk.size() && (!grid->bulk || (int) bulk.size() != grid->nsubs)) flag = 1;
+  int flagall;
+  MPI_Allreduce(&flag,&flagall,1,MPI_INT,MPI_MAX,world);
+  if (flagall) error->all(FLERR,"Checkpoint grid does not match the current grid");
+
+  for (int s = 0; nconc && s < grid->nsubs; s++)
+    memcpy(grid->conc[s], &conc[s*grid->ncells], grid->ncells * sizeof(double));
+  if (bulk.size()) memcpy(grid->bulk, &bulk[0], bulk.size() * sizeof(double));
+
+  update->reset_timestep(step);
+  update->atime = atime;
+  update->atimestep = step;
+
+  // the next checkpoint is a full image in the other file
+  ncheckpoint = 0;
+}
@@ -0,0 +1,124 @@
+/* -*- c++ -*- ----------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   http://lammps.sandia.gov, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#ifdef FIX_CLASS
+
+FixStyle(nufeb/checkpoint,FixCheckpoint)
+
+#else
+
+#ifndef LMP_FIX_CHECKPOINT_H
+#define LMP_FIX_CHECKPOINT_H
+
+#include "fix.h"
+#include <map>
+#include <vector>
+#include <pthread.h>
+
+namespace LAMMPS_NS {
+
+class FixCheckpoint : public Fix {
+ public:
+  int compute_flag;
+
+  FixCheckpoint(class LAMMPS *, int, char **);
+  ~FixCheckpoint();
+  int setmask();
+  void init();
+  void end_of_step();
+  void checkpoint();
+
+ private:
+  char *prefix;         // checkpoint files are prefix.<proc>.<0|1>
+  int nbase;            // # of checkpoints per full image
+  double quantum;       // position quantum of delta records
+  double tol;           // relative tolerance of unchanged values
+  int ncheckpoint;      // # of checkpoints since the last full image
+  int parity;           // file receiving the current full image
+
+  // last written state of each owned atom, by tag
+  std::map<tagint, std::vector<double> > ref;
+  std::vector<double> buf;
+
+  // background writer, one record in flight
+  pthread_t writer;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  int busy, quit;
+  std::vector<char> record;     // record being packed
+  std::vector<char> pending;    // record being written
+  int pending_base;
+  char *pending_file;
+
+  void pack_base();
+  void pack_delta();
+  void pack_grid();
+  int changed(const double *, const double *, int);
+  void submit(int);
+  void wait();
+  static void *writer_loop(void *);
+  void write_pending();
+
+  void restore();
+  void scan(const char *, bigint &, bigint &);
+  void replay(const char *, bigint);
+};
+
+}
+
+#endif
+#endif
+
+/* ERROR/WARNING messages:
+
+E: Illegal ... command
+
+Self-explanatory.  Check the input script syntax and compare to the
+documentation for the command.  You can use -echo screen as a
+command-line option when running LAMMPS to see the offending line.
+
+E: Fix nufeb/checkpoint is not supported with KOKKOS
+
+Checkpoints are packed from the host copies of the atoms and the grid,
+once per biological step of run_style nufeb.
+
+E: Fix nufeb/checkpoint must use group all
+
+Restoring replaces all atoms, so all atoms must be checkpointed.
+
+E: Fix nufeb/checkpoint requires atom IDs
+
+Delta records identify atoms by tag.
+
+E: Fix nufeb/checkpoint requires an atom map, see atom_modify
+
+Delta records look up atoms by tag.
+
+E: Cannot open checkpoint file %s
+
+The file could not be opened for writing.
+
+E: Cannot read checkpoint file
+
+The checkpoint file selected for restoring is truncated or corrupt.
+
+E: No checkpoint common to all processors
+
+The checkpoint files of the processors do not share a complete record,
+or were written with a different number of processors.
+
+E: Checkpoint grid does not match the current grid
+
+Checkpoints can only be restored with the same grid decomposition.
+
+*/
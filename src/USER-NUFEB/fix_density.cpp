@@ -18,9 +18,12 @@
 #include "atom.h"
 #include "error.h"
 #include "grid.h"
+#include "comm_grid.h"
 #include "domain.h"
 #include "group.h"
+#include "comm.h"
 #include "atom_masks.h"
+#include "grid_masks.h"
 
 using namespace LAMMPS_NS;
 using namespace FixConst;
@@ -68,6 +71,17 @@ int FixDensity::modify_param(int narg, char **arg)
 
 /* ---------------------------------------------------------------------- */
 
+void FixDensity::setup(int vflag)
+{
+  if (grid->interp != Grid::CIC || comm->me != 0) return;
+  double cut = MIN(comm->cutghost[0], MIN(comm->cutghost[1], comm->cutghost[2]));
+  if (cut < 0.5 * grid->cell_size)
+    error->warning(FLERR,"Ghost cutoff is smaller than half a grid cell, "
+		   "CIC densities miss ghost atoms");
+}
+
+/* ---------------------------------------------------------------------- */
+
 void FixDensity::post_integrate()
 {
   if (compute_flag)
@@ -84,20 +98,48 @@ void FixDensity::compute()
   }
 
   double vol = grid->cell_size * grid->cell_size * grid->cell_size;
-  // including ghost atoms because there can be atoms that moved inside the
-  //   sub-domain and were not yet exchanged
-  // forward communication garantees that we have the latest ghost positions
-  //   which were updated during initial integrate
-  for (int i = 0; i < atom->nlocal + atom->nghost; i++) {
-    if (atom->x[i][0] >= domain->sublo[0] && atom->x[i][0] < domain->subhi[0] &&
-	atom->x[i][1] >= domain->sublo[1] && atom->x[i][1] < domain->subhi[1] &&
-	atom->x[i][2] >= domain->sublo[2] && atom->x[i][2] < domain->subhi[2]) {
-      int cell = grid->cell(atom->x[i]);
+  int nall = atom->nlocal + atom->nghost;
+
+  if (grid->interp == Grid::CIC) {
+    // each proc sums the stencils of local and ghost atoms over the
+    //   cells it owns, the stencils are kept for the growth gather
+    grid->compute_weights(nall);
+    for (int i = 0; i < nall; i++) {
       double d = atom->rmass[i] * atom->biomass[i] / vol;
-      grid->dens[0][cell] += d;
-      for (int igroup = 0; igroup < group->ngroup; igroup++)
-	if (atom->mask[i] & group->bitmask[igroup])
-	  grid->dens[igroup][cell] += d;
+      for (int k = 0; k < 8; k++) {
+	int cell = grid->wcell[i][k];
+	if (cell < 0 || (grid->mask[cell] & GHOST_MASK)) continue;
+	deposit(i, cell, grid->weight[i][k] * d);
+      }
+    }
+  } else {
+    // including ghost atoms because there can be atoms that moved inside the
+    //   sub-domain and were not yet exchanged
+    // forward communication garantees that we have the latest ghost positions
+    //   which were updated during initial integrate
+    for (int i = 0; i < nall; i++) {
+      if (atom->x[i][0] >= domain->sublo[0] && atom->x[i][0] < domain->subhi[0] &&
+	  atom->x[i][1] >= domain->sublo[1] && atom->x[i][1] < domain->subhi[1] &&
+	  atom->x[i][2] >= domain->sublo[2] && atom->x[i][2] < domain->subhi[2]) {
+	int cell = grid->cell(atom->x[i]);
+	deposit(i, cell, atom->rmass[i] * atom->biomass[i] / vol);
+      }
     }
   }
+
+  // reactions are also computed in halo cells with deep ghost layers
+  if (grid->ghost > 1) {
+    for (int igroup = 0; igroup < group->ngroup; igroup++)
+      comm_grid->forward_comm_array(1, &grid->dens[igroup]);
+  }
+}
+
+/* ---------------------------------------------------------------------- */
+
+void FixDensity::deposit(int i, int cell, double d)
+{
+  grid->dens[0][cell] += d;
+  for (int igroup = 0; igroup < group->ngroup; igroup++)
+    if (atom->mask[i] & group->bitmask[igroup])
+      grid->dens[igroup][cell] += d;
 }
@@ -32,8 +32,12 @@ class FixDensity : public Fix {
   virtual ~FixDensity() {}
   int setmask();
   int modify_param(int, char **);
+  virtual void setup(int);
   virtual void post_integrate();
   virtual void compute();
+
+ protected:
+  void deposit(int, int, double);
 };
 
 }
@@ -42,4 +46,10 @@ class FixDensity : public Fix {
 #endif
 
 /* ERROR/WARNING messages:
+
+W: Ghost cutoff is smaller than half a grid cell, CIC densities miss ghost atoms
+
+Atoms on other processors within half a cell of the sub-domain
+contribute to its cells.  Increase the cutoff with comm_modify cutoff.
+
 */
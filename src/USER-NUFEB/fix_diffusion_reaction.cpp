@@ -24,11 +24,18 @@
 #include "grid_masks.h"
 #include "memory.h"
 #include "comm.h"
+#include "modify.h"
+#include "domain.h"
+#include "comm_grid.h"
+#include "math_const.h"
 
 using namespace LAMMPS_NS;
 using namespace FixConst;
+using namespace MathConst;
 
 enum{DIRICHLET,NEUMANN,PERIODIC,BULK};
+enum{NONE,UPWIND,TVD};
+enum{UNIFORM,RATIO,FAN};
 
 /* ---------------------------------------------------------------------- */
 
@@ -43,11 +50,46 @@ FixDiffusionReaction::FixDiffusionReaction(LAMMPS *lmp, int narg, char **arg) :
   scalar_flag = 1;
 
   closed_system = 0;
+  residual_flag = 0;
+  nhalo = 0;
+  sor_flag = 0;
+  omega = 0.0;
+  color = 0;
+  split_flag = 0;
+  level = 1;
+  local_res = 0.0;
+  res_valid = 0;
 
   ncells = 0;
   prev = NULL;
   penult = NULL;
+  start = NULL;
   dt = 1.0;
+
+  adv_scheme = NONE;
+  lb_id = NULL;
+  fix_lb = NULL;
+  drag_coef = 0.0;
+  uface = NULL;
+  vstep = -1;
+  u_lb = NULL;
+  dx_lb = dt_lb = 1.0;
+  lbbox[0] = lbbox[1] = lbbox[2] = 0;
+
+  diff_style = UNIFORM;
+  diff_ratio = 1.0;
+  dcell = NULL;
+  dface = NULL;
+  nface = 0;
+
+  ncoarse = 0;
+  cstale = 1;
+  cconc = cprev = cpenult = creac = NULL;
+  cdface = NULL;
+  cface_flag = 1;
+  active_all = 1;
+  nactive = maxactive = 0;
+  active = active_block = NULL;
   
   boundary[0] = boundary[1] = boundary[2] = boundary[3] =
   boundary[4] = boundary[5] = -1;
@@ -98,6 +140,52 @@ FixDiffusionReaction::FixDiffusionReaction(LAMMPS *lmp, int narg, char **arg) :
       dirichlet[i] = 0.0;
     }
   }
+
+  while (iarg < narg) {
+    if (strcmp(arg[iarg], "advection") == 0) {
+      if (iarg+3 > narg)
+	error->all(FLERR, "Illegal fix nufeb/diffusion_reaction command");
+      int n = strlen(arg[iarg+1]) + 1;
+      lb_id = new char[n];
+      strcpy(lb_id, arg[iarg+1]);
+      if (strcmp(arg[iarg+2], "upwind") == 0) adv_scheme = UPWIND;
+      else if (strcmp(arg[iarg+2], "tvd") == 0) adv_scheme = TVD;
+      else error->all(FLERR, "Illegal fix nufeb/diffusion_reaction command");
+      iarg += 3;
+    } else if (strcmp(arg[iarg], "drag") == 0) {
+      if (iarg+2 > narg)
+	error->all(FLERR, "Illegal fix nufeb/diffusion_reaction command");
+      drag_coef = force->numeric(FLERR, arg[iarg+1]);
+      if (drag_coef < 0.0)
+	error->all(FLERR, "Illegal fix nufeb/diffusion_reaction command");
+      iarg += 2;
+    } else if (strcmp(arg[iarg], "diffusivity") == 0) {
+      if (iarg+2 > narg)
+	error->all(FLERR, "Illegal fix nufeb/diffusion_reaction command");
+      if (strcmp(arg[iarg+1], "uniform") == 0) {
+	diff_style = UNIFORM;
+	iarg += 2;
+      } else if (strcmp(arg[iarg+1], "ratio") == 0) {
+	if (iarg+3 > narg)
+	  error->all(FLERR, "Illegal fix nufeb/diffusion_reaction command");
+	diff_style = RATIO;
+	diff_ratio = force->numeric(FLERR, arg[iarg+2]);
+	if (diff_ratio <= 0.0)
+	  error->all(FLERR, "Illegal fix nufeb/diffusion_reaction command");
+	iarg += 3;
+      } else if (strcmp(arg[iarg+1], "fan") == 0) {
+	diff_style = FAN;
+	iarg += 2;
+      } else {
+	error->all(FLERR, "Illegal fix nufeb/diffusion_reaction command");
+      }
+    } else {
+      error->all(FLERR, "Illegal fix nufeb/diffusion_reaction command");
+    }
+  }
+
+  if (drag_coef > 0.0 && adv_scheme == NONE)
+    error->all(FLERR, "Fix nufeb/diffusion_reaction drag requires advection");
 }
 
 /* ---------------------------------------------------------------------- */
@@ -108,6 +196,18 @@ FixDiffusionReaction::~FixDiffusionReaction()
   if (copymode) return;
   memory->destroy(prev);
   if (closed_system) memory->destroy(penult);
+  memory->destroy(start);
+  memory->destroy(uface);
+  memory->destroy(dcell);
+  memory->destroy(dface);
+  memory->destroy(cconc);
+  memory->destroy(cprev);
+  memory->destroy(cpenult);
+  memory->destroy(creac);
+  memory->destroy(cdface);
+  memory->destroy(active);
+  memory->destroy(active_block);
+  delete [] lb_id;
 }
 
 /* ---------------------------------------------------------------------- */
@@ -154,22 +254,88 @@ void FixDiffusionReaction::init()
       penult[i] = 0.0;
   }
   dt = update->dt;
+
+  if (adv_scheme != NONE) {
+    if (lmp->kokkos)
+      error->all(FLERR, "Fix nufeb/diffusion_reaction advection is not supported with KOKKOS");
+    int ifix = modify->find_fix(lb_id);
+    if (ifix < 0)
+      error->all(FLERR, "Fix ID for nufeb/diffusion_reaction advection does not exist");
+    fix_lb = modify->fix[ifix];
+    if (strcmp(fix_lb->style, "lb/fluid") != 0)
+      error->all(FLERR, "Fix nufeb/diffusion_reaction advection requires fix lb/fluid");
+    uface = memory->grow(uface, 3, ncells, "nufeb/diffusion_reaction:uface");
+    vstep = -1;
+    if (grid->ghost > 1)
+      error->all(FLERR, "Fix nufeb/diffusion_reaction advection requires one ghost layer");
+  }
+
+  if (diff_style != UNIFORM && lmp->kokkos)
+    error->all(FLERR, "Fix nufeb/diffusion_reaction diffusivity is not supported with KOKKOS");
+
+  if (sor_flag) {
+    if (closed_system)
+      error->all(FLERR, "Diffsolver sor requires dirichlet or bulk boundaries");
+    if (adv_scheme != NONE)
+      error->all(FLERR, "Fix nufeb/diffusion_reaction advection requires diffsolver dt");
+    if (omega <= 0.0) omega = sor_omega();
+  }
+
+  if (split_flag) {
+    if (closed_system)
+      error->all(FLERR, "Diffreac strang requires dirichlet or bulk boundaries");
+    start = memory->grow(start, ncells, "nufeb/diffusion_reaction:start");
+  }
+
+  level = grid->level[isub];
+  if (level > 1) {
+    char str[128];
+    if (grid->ghost > 1) {
+      snprintf(str, 128, "Grid level of substrate %s requires one ghost layer",
+	       grid->sub_names[isub]);
+      error->all(FLERR, str);
+    }
+    if (sor_flag || split_flag) {
+      snprintf(str, 128, "Grid level of substrate %s requires diffsolver dt and diffreac explicit",
+	       grid->sub_names[isub]);
+      error->all(FLERR, str);
+    }
+    if (adv_scheme != NONE) {
+      snprintf(str, 128, "Grid level of substrate %s is not supported with advection",
+	       grid->sub_names[isub]);
+      error->all(FLERR, str);
+    }
+    // blocks are set up by the first restriction
+    cstale = 1;
+  }
+
+  // uniform until the first biomass density update
+  nface = ncells;
+  dcell = memory->grow(dcell, nface, "nufeb/diffusion_reaction:dcell");
+  dface = memory->grow(dface, 3, nface, "nufeb/diffusion_reaction:dface");
+  for (int i = 0; i < nface; i++)
+    dface[0][i] = dface[1][i] = dface[2][i] = diff_coef;
+  cface_flag = 1;
 }
 
 /* ---------------------------------------------------------------------- */
 
 void FixDiffusionReaction::pre_force(int)
 {
-  if (compute_flag)
+  if (compute_flag) {
+    restrict_conc();
     compute_initial();
+  }
 }
 
 /* ---------------------------------------------------------------------- */
 
 void FixDiffusionReaction::final_integrate()
 {
-  if (compute_flag)
+  if (compute_flag) {
     compute_final();
+    prolong_conc();
+  }
 }
 
 /* ---------------------------------------------------------------------- */
@@ -177,14 +343,42 @@ void FixDiffusionReaction::final_integrate()
 double FixDiffusionReaction::compute_scalar()
 {
   double result = 0.0;
-  for (int i = 0; i < grid->ncells; i++) {
-    if (!(grid->mask[i] & GHOST_MASK)) {
-      double res = fabs((grid->conc[isub][i] - prev[i]) / prev[i]);
-      if (closed_system) {
-        double res2 = fabs((prev[i] - penult[i]) / penult[i]);
-        res = fabs(res - res2);
+  if (res_valid || sor_flag) {
+    // already computed during the last update sweep
+    result = local_res;
+    res_valid = 0;
+  } else if (level > 1) {
+    int nx = cbox[0];
+    int nxy = cbox[0] * cbox[1];
+    for (int z = 1; z < cbox[2] - 1; z++) {
+      for (int y = 1; y < cbox[1] - 1; y++) {
+	for (int x = 1; x < cbox[0] - 1; x++) {
+	  int c = x + y * nx + z * nxy;
+	  double res = fabs((cconc[c] - cprev[c]) / cprev[c]);
+	  if (closed_system) {
+	    double res2 = fabs((cprev[c] - cpenult[c]) / cpenult[c]);
+	    res = fabs(res - res2);
+	  }
+	  result = MAX(result, res);
+	}
+      }
+    }
+  } else if (split_flag) {
+    // change over the whole reaction-diffusion-reaction sequence
+    for (int i = 0; i < grid->ncells; i++) {
+      if (!(grid->mask[i] & GHOST_MASK))
+	result = MAX(result, fabs((grid->conc[isub][i] - start[i]) / start[i]));
+    }
+  } else {
+    for (int i = 0; i < grid->ncells; i++) {
+      if (!(grid->mask[i] & GHOST_MASK)) {
+	double res = fabs((grid->conc[isub][i] - prev[i]) / prev[i]);
+	if (closed_system) {
+	  double res2 = fabs((prev[i] - penult[i]) / penult[i]);
+	  res = fabs(res - res2);
+	}
+	result = MAX(result, res);
       }
-      result = MAX(result, res);
     }
   }
   MPI_Allreduce(MPI_IN_PLACE, &result, 1, MPI_DOUBLE, MPI_MAX, world);
@@ -206,8 +400,39 @@ void FixDiffusionReaction::compute_initial()
     ncells = grid->ncells;
     prev = memory->grow(prev, ncells, "nufeb/diffusion_reaction:prev");
     if (closed_system) penult = memory->grow(penult, ncells, "nufeb/diffusion_reaction:penult");
+    if (split_flag) start = memory->grow(start, ncells, "nufeb/diffusion_reaction:start");
+    if (adv_scheme != NONE) {
+      uface = memory->grow(uface, 3, ncells, "nufeb/diffusion_reaction:uface");
+      vstep = -1;
+    }
+  }
+
+  // grid changed without a density update, fall back to uniform faces
+  if (nface != grid->ncells) {
+    nface = grid->ncells;
+    dcell = memory->grow(dcell, nface, "nufeb/diffusion_reaction:dcell");
+    dface = memory->grow(dface, 3, nface, "nufeb/diffusion_reaction:dface");
+    for (int i = 0; i < nface; i++)
+      dface[0][i] = dface[1][i] = dface[2][i] = diff_coef;
+    cface_flag = 1;
   }
 
+  if (level > 1) {
+    // reaction fixes only read and write the cells with biomass
+    coarse_comm();
+    coarse_boundary();
+    double *conc = grid->conc[isub];
+    double *reac = grid->reac[isub];
+    for (int k = 0; k < nactive; k++) {
+      conc[active[k]] = cconc[active_block[k]];
+      reac[active[k]] = 0.0;
+    }
+    return;
+  }
+
+  // flow field only changes during the mechanical relaxation
+  if (adv_scheme != NONE && vstep != update->ntimestep) lb_coupling();
+
   for (int i = 0; i < grid->ncells; i++) {
     // Dirichlet boundary conditions
     if (grid->mask[i] & X_NB_MASK && boundary[0] == DIRICHLET) {
@@ -236,6 +461,7 @@ void FixDiffusionReaction::compute_initial()
       grid->conc[isub][i] = grid->bulk[isub];
     }
     grid->reac[isub][i] = 0.0;
+    if (split_flag) start[i] = grid->conc[isub][i];
   }
 }
 
@@ -244,11 +470,88 @@ void FixDiffusionReaction::compute_initial()
 /* ---------------------------------------------------------------------- */
 
 void FixDiffusionReaction::compute_final()
+{
+  if (sor_flag) {
+    compute_sor();
+    return;
+  }
+  if (level > 1) {
+    compute_coarse();
+    return;
+  }
+
+  int nxy = grid->subbox[0] * grid->subbox[1];
+  neumann();
+  for (int i = 0; i < grid->ncells; i++) {
+    if (closed_system) penult[i] = prev[i];
+    prev[i] = grid->conc[isub][i];
+  }
+
+  // update owned cells and the halo cells that later sweeps still need
+  //   before the next forward communication
+  int lo[3], hi[3];
+  for (int d = 0; d < 3; d++) {
+    lo[d] = grid->ghost - nhalo;
+    hi[d] = grid->subbox[d] - grid->ghost + nhalo;
+    if (boundary[2*d] != PERIODIC) {
+      lo[d] = MAX(lo[d], -grid->sublo[d]);
+      hi[d] = MIN(hi[d], grid->box[d] - grid->sublo[d]);
+    }
+  }
+
+  double result = 0.0;
+  for (int z = lo[2]; z < hi[2]; z++) {
+    for (int y = lo[1]; y < hi[1]; y++) {
+      for (int x = lo[0]; x < hi[0]; x++) {
+	int i = x + y * grid->subbox[0] + z * nxy;
+	int nx = i - 1;
+	int px = i + 1;
+	int ny = i - grid->subbox[0];
+	int py = i + grid->subbox[0];
+	int nz = i - nxy;
+	int pz = i + nxy;
+	double dnx = dface[0][i] * (prev[i] - prev[nx]) / grid->cell_size;
+	double dpx = dface[0][px] * (prev[px] - prev[i]) / grid->cell_size;
+	double ddx = (dpx - dnx) / grid->cell_size;
+	double dny = dface[1][i] * (prev[i] - prev[ny]) / grid->cell_size;
+	double dpy = dface[1][py] * (prev[py] - prev[i]) / grid->cell_size;
+	double ddy = (dpy - dny) / grid->cell_size;
+	double dnz = dface[2][i] * (prev[i] - prev[nz]) / grid->cell_size;
+	double dpz = dface[2][pz] * (prev[pz] - prev[i]) / grid->cell_size;
+	double ddz = (dpz - dnz) / grid->cell_size;
+	double adv = 0.0;
+	if (adv_scheme != NONE) {
+	  adv = -(advection_flux(px, 1, 0) - advection_flux(i, 1, 0) +
+		  advection_flux(py, grid->subbox[0], 1) - advection_flux(i, grid->subbox[0], 1) +
+		  advection_flux(pz, nxy, 2) - advection_flux(i, nxy, 2)) / grid->cell_size;
+	}
+	// prevent negative concentrations
+	grid->conc[isub][i] = MAX(0, prev[i] + dt * (ddx + ddy + ddz + adv + grid->reac[isub][i]));
+	if (residual_flag && !split_flag && !(grid->mask[i] & GHOST_MASK)) {
+	  double res = fabs((grid->conc[isub][i] - prev[i]) / prev[i]);
+	  if (closed_system) {
+	    double res2 = fabs((prev[i] - penult[i]) / penult[i]);
+	    res = fabs(res - res2);
+	  }
+	  result = MAX(result, res);
+	}
+      }
+    }
+  }
+  if (residual_flag && !split_flag) {
+    local_res = result;
+    res_valid = 1;
+  }
+}
+
+/* ----------------------------------------------------------------------
+ Copy Neumann boundary ghost cells from their inner neighbours
+ ------------------------------------------------------------------------- */
+void FixDiffusionReaction::neumann()
 {
   int nx = grid->subbox[0];
   int nxy = grid->subbox[0] * grid->subbox[1];
   for (int i = 0; i < grid->ncells; i++) {
-    // Neumann boundary conditions
     if (grid->mask[i] & X_NB_MASK && boundary[0] == NEUMANN) {
       grid->conc[isub][i] = grid->conc[isub][i+1];
     } else if (grid->mask[i] & X_PB_MASK && boundary[1] == NEUMANN) {
@@ -266,29 +569,526 @@ void FixDiffusionReaction::compute_final()
       int pz = i - nxy;
       grid->conc[isub][i] = grid->conc[isub][pz];
     }
-    if (closed_system) penult[i] = prev[i];
-    prev[i] = grid->conc[isub][i];
   }
+}
+
+/* ----------------------------------------------------------------------
+ Explicit update of a substrate solved on blocks of level^3 base cells.
+ The field is stored on its own coarse grid with one ghost layer of
+ blocks. Base cells are only touched where reaction fixes read and write,
+ block values are injected into the active cells by compute_initial() and
+ their rates are restricted here by summing over the block. Blocks take
+ steps of dt*level*(level+1)/2, no face coefficient then exceeds that of
+ a base cell face, so they are stable whenever the base dt is.
+ ------------------------------------------------------------------------- */
+void FixDiffusionReaction::compute_coarse()
+{
+  if (cface_flag) coarse_faces();
+
+  for (int c = 0; c < ncoarse; c++) {
+    if (closed_system) cpenult[c] = cprev[c];
+    cprev[c] = cconc[c];
+    creac[c] = 0.0;
+  }
+  double *reac = grid->reac[isub];
+  for (int k = 0; k < nactive; k++)
+    creac[active_block[k]] += reac[active[k]];
+
+  int stride[3] = {1, cbox[0], cbox[0] * cbox[1]};
+  int gbox[3];
+  for (int d = 0; d < 3; d++)
+    gbox[d] = grid->box[d] / level;
+  double h = grid->cell_size;
+  double lh = level * h;
+  double inv = 1.0 / (level * level * level);
+  double dtc = dt * level * (level + 1) / 2;
+
+  double result = 0.0;
+  for (int z = 1; z < cbox[2] - 1; z++) {
+    for (int y = 1; y < cbox[1] - 1; y++) {
+      for (int x = 1; x < cbox[0] - 1; x++) {
+	int b[3] = {x, y, z};
+	int c = x + y * stride[1] + z * stride[2];
+	double cb = cprev[c];
+	double flux = 0.0;
+	for (int d = 0; d < 3; d++) {
+	  for (int side = 0; side < 2; side++) {
+	    int n = side ? c + stride[d] : c - stride[d];
+	    double df = cdface[d][side ? n : c];
+	    // domain boundary values lie half a base cell outside the block
+	    int g = clo[d] + b[d] + (side ? 1 : -1);
+	    double dist = lh;
+	    if (boundary[2*d+side] != PERIODIC && (g < 0 || g >= gbox[d]))
+	      dist = 0.5 * (lh + h);
+	    flux += df * (cprev[n] - cb) / dist;
+	  }
+	}
+
+	// prevent negative concentrations
+	cconc[c] = MAX(0, cb + dtc * (flux / lh + creac[c] * inv));
+	if (residual_flag) {
+	  double res = fabs((cconc[c] - cb) / cb);
+	  if (closed_system) {
+	    double res2 = fabs((cb - cpenult[c]) / cpenult[c]);
+	    res = fabs(res - res2);
+	  }
+	  result = MAX(result, res);
+	}
+      }
+    }
+  }
+  if (residual_flag) {
+    local_res = result;
+    res_valid = 1;
+  }
+}
+
+/* ----------------------------------------------------------------------
+ Set up the blocks of this proc and the pattern of their halo exchange,
+ which mirrors CommGrid::setup() on the coarse grid
+ ------------------------------------------------------------------------- */
+void FixDiffusionReaction::coarse_setup()
+{
+  // blocks must not straddle the global or the processor grid
+  int flag = 0;
+  for (int d = 0; d < 3; d++) {
+    if (grid->box[d] % level || (grid->sublo[d] + 1) % level ||
+	(grid->subbox[d] - 2) % level) flag = 1;
+  }
+  MPI_Allreduce(MPI_IN_PLACE, &flag, 1, MPI_INT, MPI_MAX, world);
+  if (flag) {
+    char str[128];
+    snprintf(str, 128, "Grid of substrate %s is not divisible into level blocks",
+	     grid->sub_names[isub]);
+    error->all(FLERR, str);
+  }
+
+  int gbox[3];
+  for (int d = 0; d < 3; d++) {
+    cbox[d] = (grid->subbox[d] - 2) / level + 2;
+    clo[d] = (grid->sublo[d] + 1) / level - 1;
+    gbox[d] = grid->box[d] / level;
+    csub[d] = grid->sublo[d];
+    csub[3+d] = grid->subbox[d];
+  }
+  ncoarse = cbox[0] * cbox[1] * cbox[2];
+
+  memory->destroy(cconc);
+  memory->destroy(cprev);
+  memory->destroy(cpenult);
+  memory->destroy(creac);
+  memory->destroy(cdface);
+  memory->create(cconc, ncoarse, "nufeb/diffusion_reaction:cconc");
+  memory->create(cprev, ncoarse, "nufeb/diffusion_reaction:cprev");
+  if (closed_system)
+    memory->create(cpenult, ncoarse, "nufeb/diffusion_reaction:cpenult");
+  memory->create(creac, ncoarse, "nufeb/diffusion_reaction:creac");
+  memory->create(cdface, 3, ncoarse, "nufeb/diffusion_reaction:cdface");
+  for (int c = 0; c < ncoarse; c++) {
+    cconc[c] = cprev[c] = creac[c] = 0.0;
+    if (closed_system) cpenult[c] = 0.0;
+    cdface[0][c] = cdface[1][c] = cdface[2][c] = 0.0;
+  }
+  cface_flag = 1;
+
+  // block boxes of all procs, ghost blocks included
+  int nprocs = comm->nprocs;
+  int mybox[6];
+  for (int d = 0; d < 3; d++) {
+    mybox[d] = clo[d];
+    mybox[3+d] = clo[d] + cbox[d];
+  }
+  int *boxes = new int[6*nprocs];
+  MPI_Allgather(mybox, 6, MPI_INT, boxes, 6, MPI_INT, world);
+
+  crecvproc.clear();
+  crecv_begin.clear();
+  crecv_cells.clear();
+  csendproc.clear();
+  csend_begin.clear();
+  csend_cells.clear();
+  crecv_self.clear();
+  csend_self.clear();
+
+  for (int p = 0; p < nprocs; p++) {
+    int *plo = &boxes[6*p];
+    int *phi = &boxes[6*p+3];
+    // loop over proc p and its periodic images, the diagonal ones only
+    //   fill edge and corner ghost blocks that the stencil does not read
+    for (int sz = -grid->periodic[2]; sz <= grid->periodic[2]; sz++) {
+      for (int sy = -grid->periodic[1]; sy <= grid->periodic[1]; sy++) {
+	for (int sx = -grid->periodic[0]; sx <= grid->periodic[0]; sx++) {
+	  int nshift = abs(sx) + abs(sy) + abs(sz);
+	  if (nshift == 0 && comm->me == p) continue;
+	  if (nshift > 1) continue;
+	  int shift[3] = {sx * gbox[0], sy * gbox[1], sz * gbox[2]};
+	  for (int dir = 0; dir < 2; dir++) {
+	    // recv: my ghost blocks owned by p
+	    // send: my owned blocks in the ghost layer of p
+	    int lo[3], hi[3];
+	    int n = 1;
+	    for (int d = 0; d < 3; d++) {
+	      if (dir == 0) {
+		lo[d] = MAX(mybox[d], plo[d] + 1 + shift[d]);
+		hi[d] = MIN(mybox[3+d], phi[d] - 1 + shift[d]);
+	      } else {
+		lo[d] = MAX(mybox[d] + 1, plo[d] - shift[d]);
+		hi[d] = MIN(mybox[3+d] - 1, phi[d] - shift[d]);
+	      }
+	      n *= MAX(0, hi[d] - lo[d]);
+	    }
+	    if (n == 0) continue;
+	    std::vector<int> &cells = (comm->me == p) ?
+	      (dir ? csend_self : crecv_self) : (dir ? csend_cells : crecv_cells);
+	    if (comm->me != p) {
+	      std::vector<int> &procs = dir ? csendproc : crecvproc;
+	      std::vector<int> &begin = dir ? csend_begin : crecv_begin;
+	      if (procs.empty() || procs.back() != p) {
+		procs.push_back(p);
+		begin.push_back(cells.size());
+	      }
+	    }
+	    for (int z = lo[2]; z < hi[2]; z++)
+	      for (int y = lo[1]; y < hi[1]; y++)
+		for (int x = lo[0]; x < hi[0]; x++)
+		  cells.push_back((x - clo[0]) + (y - clo[1]) * cbox[0] +
+				  (z - clo[2]) * cbox[0] * cbox[1]);
+	  }
+	}
+      }
+    }
+  }
+  delete [] boxes;
+
+  if (crecv_self.size() != csend_self.size()) {
+    char str[128];
+    snprintf(str, 128, "Conflicting self send and recv sizes of substrate %s "
+	     "blocks (this is possibly a bug)", grid->sub_names[isub]);
+    error->one(FLERR, str);
+  }
+
+  crecv_begin.push_back(crecv_cells.size());
+  csend_begin.push_back(csend_cells.size());
+  cbuf_recv.resize(crecv_cells.size());
+  cbuf_send.resize(csend_cells.size());
+  crequests.resize(crecvproc.size());
+  cstale = 0;
+}
+
+/* ----------------------------------------------------------------------
+ Forward communication of the ghost blocks
+ ------------------------------------------------------------------------- */
+void FixDiffusionReaction::coarse_comm()
+{
+  int nrecvproc = crecvproc.size();
+  for (int p = 0; p < nrecvproc; p++)
+    MPI_Irecv(&cbuf_recv[crecv_begin[p]], crecv_begin[p+1] - crecv_begin[p],
+	      MPI_DOUBLE, crecvproc[p], 0, world, &crequests[p]);
+  for (int p = 0; p < (int)csendproc.size(); p++) {
+    for (int k = csend_begin[p]; k < csend_begin[p+1]; k++)
+      cbuf_send[k] = cconc[csend_cells[k]];
+    MPI_Send(&cbuf_send[csend_begin[p]], csend_begin[p+1] - csend_begin[p],
+	     MPI_DOUBLE, csendproc[p], 0, world);
+  }
+  for (int k = 0; k < (int)crecv_self.size(); k++)
+    cconc[crecv_self[k]] = cconc[csend_self[k]];
+  if (nrecvproc) MPI_Waitall(nrecvproc, &crequests[0], MPI_STATUSES_IGNORE);
+  for (int k = 0; k < (int)crecv_cells.size(); k++)
+    cconc[crecv_cells[k]] = cbuf_recv[k];
+}
+
+/* ----------------------------------------------------------------------
+ Fill the ghost blocks beyond the non-periodic domain boundaries
+ ------------------------------------------------------------------------- */
+void FixDiffusionReaction::coarse_boundary()
+{
+  int stride[3] = {1, cbox[0], cbox[0] * cbox[1]};
+  for (int d = 0; d < 3; d++) {
+    int d1 = (d + 1) % 3;
+    int d2 = (d + 2) % 3;
+    for (int side = 0; side < 2; side++) {
+      int bc = boundary[2*d+side];
+      if (bc == PERIODIC) continue;
+      int layer = side ? cbox[d] - 1 : 0;
+      if (clo[d] + layer != (side ? grid->box[d] / level : -1)) continue;
+      int inner = side ? -stride[d] : stride[d];
+      for (int k = 0; k < cbox[d2]; k++) {
+	for (int j = 0; j < cbox[d1]; j++) {
+	  int c = layer * stride[d] + j * stride[d1] + k * stride[d2];
+	  if (bc == DIRICHLET) cconc[c] = dirichlet[2*d+side];
+	  else if (bc == BULK) cconc[c] = grid->bulk[isub];
+	  else cconc[c] = cconc[c+inner];
+	}
+      }
+    }
+  }
+}
+
+/* ----------------------------------------------------------------------
+ Block face diffusivities of the owned blocks and of the ghost blocks
+ after them, averaged over the base cell faces they cover
+ ------------------------------------------------------------------------- */
+void FixDiffusionReaction::coarse_faces()
+{
+  int stride[3] = {1, grid->subbox[0], grid->subbox[0] * grid->subbox[1]};
+  for (int d = 0; d < 3; d++) {
+    int hi[3] = {cbox[0] - 1, cbox[1] - 1, cbox[2] - 1};
+    hi[d]++;
+    for (int z = 1; z < hi[2]; z++) {
+      for (int y = 1; y < hi[1]; y++) {
+	for (int x = 1; x < hi[0]; x++) {
+	  int c = x + y * cbox[0] + z * cbox[0] * cbox[1];
+	  int i = (1 + (x - 1) * level) + (1 + (y - 1) * level) * stride[1] +
+	    (1 + (z - 1) * level) * stride[2];
+	  cdface[d][c] = block_face(dface[d], i, stride[(d+1)%3], stride[(d+2)%3]);
+	}
+      }
+    }
+  }
+  cface_flag = 0;
+}
 
+/* ----------------------------------------------------------------------
+ Block of base cell (x, y, z), ghost cells lie in the ghost blocks
+ ------------------------------------------------------------------------- */
+int FixDiffusionReaction::coarse_cell(int x, int y, int z)
+{
+  return (x - 1 + level) / level + (y - 1 + level) / level * cbox[0] +
+    (z - 1 + level) / level * cbox[0] * cbox[1];
+}
+
+/* ----------------------------------------------------------------------
+ Average the base concentrations into the blocks before the sweeps and
+ collect the owned cells reaction fixes act on, set up the blocks again
+ if the grid of any proc changed
+ ------------------------------------------------------------------------- */
+void FixDiffusionReaction::restrict_conc()
+{
+  if (level == 1) return;
+
+  int flag = cstale;
+  for (int d = 0; d < 3; d++) {
+    if (csub[d] != grid->sublo[d] || csub[3+d] != grid->subbox[d]) flag = 1;
+  }
+  MPI_Allreduce(MPI_IN_PLACE, &flag, 1, MPI_INT, MPI_MAX, world);
+  if (flag) coarse_setup();
+
+  int nx = grid->subbox[0];
+  int nxy = grid->subbox[0] * grid->subbox[1];
+  int nown = (grid->subbox[0] - 2) * (grid->subbox[1] - 2) * (grid->subbox[2] - 2);
+  if (nown > maxactive) {
+    maxactive = nown;
+    memory->destroy(active);
+    memory->destroy(active_block);
+    memory->create(active, maxactive, "nufeb/diffusion_reaction:active");
+    memory->create(active_block, maxactive, "nufeb/diffusion_reaction:active_block");
+  }
+
+  double *conc = grid->conc[isub];
+  double *reac = grid->reac[isub];
+  double *dens = grid->dens[0];
+  for (int c = 0; c < ncoarse; c++)
+    cconc[c] = 0.0;
+  for (int i = 0; i < grid->ncells; i++)
+    reac[i] = 0.0;
+
+  nactive = 0;
+  for (int z = 1; z < grid->subbox[2] - 1; z++) {
+    for (int y = 1; y < grid->subbox[1] - 1; y++) {
+      for (int x = 1; x < grid->subbox[0] - 1; x++) {
+	int i = x + y * nx + z * nxy;
+	int c = coarse_cell(x, y, z);
+	cconc[c] += conc[i];
+	if (active_all || dens[i] > 0.0) {
+	  active[nactive] = i;
+	  active_block[nactive++] = c;
+	}
+      }
+    }
+  }
+  double inv = 1.0 / (level * level * level);
+  for (int c = 0; c < ncoarse; c++)
+    cconc[c] *= inv;
+
+  coarse_comm();
+  coarse_boundary();
+  res_valid = 0;
+}
+
+/* ----------------------------------------------------------------------
+ Inject the block values into all base cells after the sweeps
+ ------------------------------------------------------------------------- */
+void FixDiffusionReaction::prolong_conc()
+{
+  if (level == 1) return;
+
+  coarse_comm();
+  coarse_boundary();
+
+  int nx = grid->subbox[0];
+  int nxy = grid->subbox[0] * grid->subbox[1];
+  double *conc = grid->conc[isub];
+  double *reac = grid->reac[isub];
+  for (int z = 0; z < grid->subbox[2]; z++) {
+    for (int y = 0; y < grid->subbox[1]; y++) {
+      for (int x = 0; x < grid->subbox[0]; x++) {
+	int i = x + y * nx + z * nxy;
+	conc[i] = cconc[coarse_cell(x, y, z)];
+	// rates of ghost cells accumulated over the sweeps
+	if (grid->mask[i] & GHOST_MASK) reac[i] = 0.0;
+      }
+    }
+  }
+}
+
+/* ----------------------------------------------------------------------
+ Average of a field over the level x level patch of cells normal to
+ a dimension, spanned by strides s1 and s2 from cell i
+ ------------------------------------------------------------------------- */
+double FixDiffusionReaction::block_face(double *f, int i, int s1, int s2)
+{
+  double sum = 0.0;
+  for (int k = 0; k < level; k++)
+    for (int j = 0; j < level; j++)
+      sum += f[i + j * s1 + k * s2];
+  return sum / (level * level);
+}
+
+/* ----------------------------------------------------------------------
+ In-place successive over-relaxation of the cells of one red-black colour
+ towards the steady state of the diffusion-reaction equation. Reaction
+ rates are lagged, they are evaluated once per full (red and black) sweep.
+ ------------------------------------------------------------------------- */
+void FixDiffusionReaction::compute_sor()
+{
+  neumann();
+
+  int nx = grid->subbox[0];
+  int nxy = grid->subbox[0] * grid->subbox[1];
+  double h2 = grid->cell_size * grid->cell_size;
+  double *conc = grid->conc[isub];
+  double *reac = grid->reac[isub];
+  int parity = grid->sublo[0] + grid->sublo[1] + grid->sublo[2] + color;
+
+  double result = 0.0;
+  for (int z = 1; z < grid->subbox[2] - 1; z++) {
+    for (int y = 1; y < grid->subbox[1] - 1; y++) {
+      int x0 = 1 + ((parity + 1 + y + z) & 1);
+      for (int x = x0; x < grid->subbox[0] - 1; x += 2) {
+	int i = x + y * nx + z * nxy;
+	double dnx = dface[0][i];
+	double dpx = dface[0][i+1];
+	double dny = dface[1][i];
+	double dpy = dface[1][i+nx];
+	double dnz = dface[2][i];
+	double dpz = dface[2][i+nxy];
+	double diag = dnx + dpx + dny + dpy + dnz + dpz;
+	if (diag <= 0.0) continue;
+	double sum = dnx * conc[i-1] + dpx * conc[i+1] +
+	  dny * conc[i-nx] + dpy * conc[i+nx] +
+	  dnz * conc[i-nxy] + dpz * conc[i+nxy];
+	double old = conc[i];
+	double gs = (sum + h2 * reac[i]) / diag;
+	// prevent negative concentrations
+	conc[i] = MAX(0, old + omega * (gs - old));
+	if (residual_flag) result = MAX(result, fabs((conc[i] - old) / old));
+      }
+    }
+  }
+
+  if (residual_flag) {
+    // the residual covers both colours of a full sweep
+    local_res = color ? MAX(local_res, result) : result;
+    res_valid = color;
+  }
+}
+
+/* ----------------------------------------------------------------------
+ Estimate the optimal SOR relaxation factor from the spectral radius of
+ the Jacobi iteration of a uniform Laplacian with these boundaries
+ ------------------------------------------------------------------------- */
+double FixDiffusionReaction::sor_omega()
+{
+  double rho = 0.0;
+  for (int d = 0; d < 3; d++) {
+    int nfixed = 0;
+    for (int j = 0; j < 2; j++) {
+      if (boundary[2*d+j] == DIRICHLET || boundary[2*d+j] == BULK) nfixed++;
+    }
+    int n = grid->box[d];
+    if (nfixed == 2) rho += cos(MY_PI / (n + 1));
+    else if (nfixed == 1) rho += cos(MY_PI / (2 * n + 1));
+    else rho += 1.0;
+  }
+  rho /= 3.0;
+  return 2.0 / (1.0 + sqrt(1.0 - rho * rho));
+}
+
+/* ----------------------------------------------------------------------
+ Largest dt of stable explicit sweeps, dt times the sum of the six face
+ diffusivities of a cell over h^2 must not exceed 1, return 0 if the
+ substrate does not diffuse. Coarse blocks scale their step so that the
+ same limit applies.
+ ------------------------------------------------------------------------- */
+double FixDiffusionReaction::max_dt()
+{
+  double dmax = 0.0;
   for (int i = 0; i < grid->ncells; i++) {
-    if (!(grid->mask[i] & GHOST_MASK)) {
-      int nx = i - 1;
-      int px = i + 1;
-      int ny = i - grid->subbox[0];
-      int py = i + grid->subbox[0];
-      int nz = i - nxy;
-      int pz = i + nxy;
-      double dnx = diff_coef * (prev[i] - prev[nx]) / grid->cell_size;
-      double dpx = diff_coef * (prev[px] - prev[i]) / grid->cell_size;
-      double ddx = (dpx - dnx) / grid->cell_size;
-      double dny = diff_coef * (prev[i] - prev[ny]) / grid->cell_size;
-      double dpy = diff_coef * (prev[py] - prev[i]) / grid->cell_size;
-      double ddy = (dpy - dny) / grid->cell_size;
-      double dnz = diff_coef * (prev[i] - prev[nz]) / grid->cell_size;
-      double dpz = diff_coef * (prev[pz] - prev[i]) / grid->cell_size;
-      double ddz = (dpz - dnz) / grid->cell_size;
-      // prevent negative concentrations
-      grid->conc[isub][i] = MAX(0, prev[i] + dt * (ddx + ddy + ddz + grid->reac[isub][i]));
+    for (int d = 0; d < 3; d++)
+      dmax = MAX(dmax, dface[d][i]);
+  }
+  MPI_Allreduce(MPI_IN_PLACE, &dmax, 1, MPI_DOUBLE, MPI_MAX, world);
+  if (dmax <= 0.0) return 0.0;
+  double h = grid->cell_size;
+  return h * h / (6.0 * dmax);
+}
+
+/* ----------------------------------------------------------------------
+ Update the cell diffusivities from the biomass density and precompute the
+ harmonic mean diffusivity of each cell face. Must be called after the
+ densities are updated, the diffusion stencil only reads dface.
+ ------------------------------------------------------------------------- */
+void FixDiffusionReaction::update_diffusivity()
+{
+  if (nface != grid->ncells) {
+    nface = grid->ncells;
+    dcell = memory->grow(dcell, nface, "nufeb/diffusion_reaction:dcell");
+    dface = memory->grow(dface, 3, nface, "nufeb/diffusion_reaction:dface");
+  }
+  cface_flag = 1;
+
+  if (diff_style == UNIFORM) {
+    for (int i = 0; i < nface; i++)
+      dface[0][i] = dface[1][i] = dface[2][i] = diff_coef;
+    return;
+  }
+
+  // ghost cells have no biomass, except those shared with other procs
+  //   which are filled by forward communication
+  double *dens = grid->dens[0];
+  for (int i = 0; i < nface; i++) {
+    if (diff_style == RATIO) {
+      dcell[i] = dens[i] > 0.0 ? diff_ratio * diff_coef : diff_coef;
+    } else if (diff_style == FAN) {
+      // Fan et al. (1990), biomass density in kg/m3
+      double x = dens[i];
+      dcell[i] = diff_coef * MAX(0.0, 1.0 - 0.43 * pow(x, 0.92) / (11.19 + 0.27 * pow(x, 0.99)));
+    }
+  }
+  comm_grid->forward_comm_array(1, &dcell);
+
+  int stride[3];
+  stride[0] = 1;
+  stride[1] = grid->subbox[0];
+  stride[2] = grid->subbox[0] * grid->subbox[1];
+  for (int d = 0; d < 3; d++) {
+    for (int i = 0; i < nface; i++) {
+      int n = i - stride[d];
+      if (n < 0 || dcell[i] + dcell[n] <= 0.0) {
+	dface[d][i] = n < 0 ? dcell[i] : 0.0;
+      } else {
+	dface[d][i] = 2.0 * dcell[i] * dcell[n] / (dcell[i] + dcell[n]);
+      }
     }
   }
 }
@@ -306,7 +1106,7 @@ void FixDiffusionReaction::closed_system_init()
     }
   }
   MPI_Allreduce(MPI_IN_PLACE, &sum, 1, MPI_DOUBLE, MPI_SUM, world);
-  sum /= (grid->box[0] * grid->box[1] * grid->box[2]);
+  sum /= grid->ntotal;
   for (int i = 0; i < grid->ncells; i++) {
     grid->conc[isub][i] = sum;
   }
@@ -319,9 +1119,158 @@ void FixDiffusionReaction::closed_system_init()
 void FixDiffusionReaction::closed_system_scaleup(double biodt)
 {
   if (!closed_system) return;
+  if (level > 1) {
+    // blocks are injected into the base cells by prolong_conc()
+    double dtc = dt * level * (level + 1) / 2;
+    for (int c = 0; c < ncoarse; c++)
+      cconc[c] = MAX(0, cconc[c] + (cconc[c] - cprev[c]) / dtc * biodt);
+    return;
+  }
   for (int i = 0; i < grid->ncells; i++) {
     double res = grid->conc[isub][i] - prev[i];
     grid->conc[isub][i] += res / dt * biodt;
     grid->conc[isub][i] = MAX(0, grid->conc[isub][i]);
   }
 }
+
+/* ----------------------------------------------------------------------
+ Interpolate the lb/fluid velocity onto the faces of the grid cells and
+ set the porous drag of the biomass on the fluid nodes
+ ------------------------------------------------------------------------- */
+void FixDiffusionReaction::lb_coupling()
+{
+  int dim;
+  u_lb = (double ****)fix_lb->extract("u_lb", dim);
+  dx_lb = *(double *)fix_lb->extract("dx_lb", dim);
+  dt_lb = *(double *)fix_lb->extract("dt_lb", dim);
+  lbbox[0] = *(int *)fix_lb->extract("subNbx", dim);
+  lbbox[1] = *(int *)fix_lb->extract("subNby", dim);
+  lbbox[2] = *(int *)fix_lb->extract("subNbz", dim);
+
+  // only faces adjacent to non-ghost cells are needed, those lie
+  //   within the sub-domain and thus within the local fluid nodes
+  double h = grid->cell_size;
+  double umax = 0.0;
+  double pos[3];
+  for (int z = 0; z < grid->subbox[2]; z++) {
+    for (int y = 0; y < grid->subbox[1]; y++) {
+      for (int x = 0; x < grid->subbox[0]; x++) {
+	int i = x + y * grid->subbox[0] + z * grid->subbox[0] * grid->subbox[1];
+	for (int d = 0; d < 3; d++) {
+	  int c[3] = {x, y, z};
+	  int inside = 1;
+	  for (int e = 0; e < 3; e++) {
+	    if (e == d && c[e] < 1) inside = 0;
+	    if (e != d && (c[e] < 1 || c[e] > grid->subbox[e] - 2)) inside = 0;
+	    pos[e] = domain->boxlo[e] + (grid->sublo[e] + c[e] + (e == d ? 0.0 : 0.5)) * h;
+	  }
+	  uface[d][i] = inside ? lb_velocity(d, pos) : 0.0;
+	  umax = MAX(umax, fabs(uface[d][i]));
+	}
+      }
+    }
+  }
+
+  MPI_Allreduce(MPI_IN_PLACE, &umax, 1, MPI_DOUBLE, MPI_MAX, world);
+  if (umax * dt / h > 1.0 && comm->me == 0)
+    error->warning(FLERR, "Courant number of nufeb/diffusion_reaction advection exceeds 1, reduce diffdt");
+
+  if (drag_coef > 0.0) {
+    double ***drag_lb = (double ***)fix_lb->extract("drag_lb", dim);
+    for (int i = 1; i < lbbox[0] - 1; i++) {
+      for (int j = 1; j < lbbox[1] - 1; j++) {
+	for (int k = 1; k < lbbox[2] - 1; k++) {
+	  pos[0] = domain->sublo[0] + (i - 1) * dx_lb;
+	  pos[1] = domain->sublo[1] + (j - 1) * dx_lb;
+	  pos[2] = domain->sublo[2] + (k - 1) * dx_lb;
+	  int cell = grid->cell(pos);
+	  drag_lb[i][j][k] = MIN(1.0, drag_coef * grid->dens[0][cell] * dt_lb);
+	}
+      }
+    }
+  }
+
+  vstep = update->ntimestep;
+}
+
+/* ----------------------------------------------------------------------
+ Trilinear interpolation of one component of the fluid velocity, using
+ the same stencil as fix lb/fluid
+ ------------------------------------------------------------------------- */
+double FixDiffusionReaction::lb_velocity(int d, double *pos)
+{
+  int lo[3], hi[3];
+  double w[3];
+  for (int e = 0; e < 3; e++) {
+    lo[e] = static_cast<int>(ceil((pos[e] - domain->sublo[e]) / dx_lb));
+    lo[e] = MAX(0, MIN(lo[e], lbbox[e] - 2));
+    hi[e] = lo[e] + 1;
+    w[e] = (pos[e] - (domain->sublo[e] + (lo[e] - 1) * dx_lb)) / dx_lb;
+  }
+
+  double u =
+    u_lb[lo[0]][lo[1]][lo[2]][d] * (1 - w[0]) * (1 - w[1]) * (1 - w[2]) +
+    u_lb[lo[0]][lo[1]][hi[2]][d] * (1 - w[0]) * (1 - w[1]) * w[2] +
+    u_lb[lo[0]][hi[1]][lo[2]][d] * (1 - w[0]) * w[1] * (1 - w[2]) +
+    u_lb[lo[0]][hi[1]][hi[2]][d] * (1 - w[0]) * w[1] * w[2] +
+    u_lb[hi[0]][lo[1]][lo[2]][d] * w[0] * (1 - w[1]) * (1 - w[2]) +
+    u_lb[hi[0]][lo[1]][hi[2]][d] * w[0] * (1 - w[1]) * w[2] +
+    u_lb[hi[0]][hi[1]][lo[2]][d] * w[0] * w[1] * (1 - w[2]) +
+    u_lb[hi[0]][hi[1]][hi[2]][d] * w[0] * w[1] * w[2];
+
+  // lattice units to physical units
+  return u * dx_lb / dt_lb;
+}
+
+/* ----------------------------------------------------------------------
+ Advective flux through the negative face of cell i in direction d.
+ TVD uses the van Leer limiter and falls back to upwind where the second
+ upstream cell is beyond the ghost layer.
+ ------------------------------------------------------------------------- */
+double FixDiffusionReaction::advection_flux(int i, int stride, int d)
+{
+  double u = uface[d][i];
+  int up, down, upup;
+  if (u > 0.0) {
+    up = i - stride;
+    down = i;
+    upup = (grid->mask[up] & GHOST_MASK) ? -1 : up - stride;
+  } else {
+    up = i;
+    down = i - stride;
+    upup = (grid->mask[up] & GHOST_MASK) ? -1 : up + stride;
+  }
+
+  double flux = prev[up];
+  if (adv_scheme == TVD && upup >= 0) {
+    double delta = prev[down] - prev[up];
+    if (delta != 0.0) {
+      double r = (prev[up] - prev[upup]) / delta;
+      flux += 0.5 * (r + fabs(r)) / (1.0 + fabs(r)) * delta;
+    }
+  }
+  return u * flux;
+}
+
+/* ----------------------------------------------------------------------
+   memory usage of per-cell solver arrays
+------------------------------------------------------------------------- */
+
+double FixDiffusionReaction::memory_usage()
+{
+  double bytes = 0.0;
+  if (prev) bytes += ncells * sizeof(double);
+  if (penult) bytes += ncells * sizeof(double);
+  if (start) bytes += ncells * sizeof(double);
+  if (uface) bytes += 3.0 * ncells * sizeof(double);
+  if (dcell) bytes += nface * sizeof(double);
+  if (dface) bytes += 3.0 * nface * sizeof(double);
+  if (cconc) bytes += 3.0 * ncoarse * sizeof(double);
+  if (cpenult) bytes += ncoarse * sizeof(double);
+  if (cdface) bytes += 3.0 * ncoarse * sizeof(double);
+  if (active) bytes += 2.0 * maxactive * sizeof(int);
+  bytes += (crecv_cells.size() + csend_cells.size() +
+	    crecv_self.size() + csend_self.size()) * sizeof(int);
+  bytes += (cbuf_recv.size() + cbuf_send.size()) * sizeof(double);
+  return bytes;
+}
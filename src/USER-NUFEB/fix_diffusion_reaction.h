@@ -21,12 +21,23 @@ FixStyle(nufeb/diffusion_reaction,FixDiffusionReaction)
 #define LMP_FIX_DIFFUSION_REACTION_H
 
 #include "fix.h"
+#include <vector>
 
 namespace LAMMPS_NS {
 
 class FixDiffusionReaction : public Fix {
  public:
   bool compute_flag;
+  int isub;                    // substrate index
+  int residual_flag;           // 1 to compute the residual in compute_final()
+  int nhalo;                   // # of ghost layers to update in compute_final()
+  int sor_flag;                // 1 for in-place red-black SOR sweeps
+  double omega;                // SOR relaxation factor, <= 0 for automatic
+  int color;                   // colour updated by the next SOR half sweep
+  int split_flag;              // 1 if reactions are solved by NufebRun
+  int level;                   // # of base cells per coarse block edge
+  int active_all;              // 1 if reactions may act outside biomass,
+                               //   cleared by NufebRun from its fixes
 
   FixDiffusionReaction(class LAMMPS *, int, char **);
   virtual ~FixDiffusionReaction();
@@ -41,9 +52,14 @@ class FixDiffusionReaction : public Fix {
   virtual void compute_final();
   virtual void closed_system_init();
   virtual void closed_system_scaleup(double);
+  void restrict_conc();
+  void prolong_conc();
+  void update_diffusivity();
+  double sor_omega();
+  double max_dt();
+  double memory_usage();
   
  protected:
-  int isub;
   double diff_coef;
   int ncells;
   double *prev;		       // substrate concentration at n-1 step
@@ -52,8 +68,66 @@ class FixDiffusionReaction : public Fix {
   int boundary[6];             // boundary conditions (-x, +x, -y, +y, -z, +z)
 
   double *penult;	       // substrate concentration at n-2 step
+  double *start;               // concentration before the split reaction step
   int closed_system;
+  double local_res;            // residual of the last sweep on this proc
+  int res_valid;               // 1 if local_res is up to date
 
+  // biomass dependent diffusivity
+  int diff_style;              // 0 = uniform, else relation to biomass density
+  double diff_ratio;           // diffusivity ratio inside biomass
+  double *dcell;               // diffusivity of each cell
+  double **dface;              // diffusivity of -x, -y and -z cell faces
+  int nface;                   // # of cells dface is allocated for
+
+  // advection by lb/fluid flow field
+  int adv_scheme;              // NONE, UPWIND or TVD
+  char *lb_id;                 // id of fix lb/fluid
+  class Fix *fix_lb;
+  double drag_coef;            // porous drag per unit biomass density
+  double **uface;              // velocity normal to -x, -y and -z cell faces
+  bigint vstep;                // timestep of last flow field interpolation
+
+  double ****u_lb;
+  double dx_lb, dt_lb;
+  int lbbox[3];
+
+  // coarse grid of level > 1 substrates, one ghost layer of blocks
+  int cbox[3];                 // # of blocks per dimension with ghosts
+  int clo[3];                  // global index of the first (ghost) block
+  int csub[6];                 // sublo and subbox the blocks are set up for
+  int ncoarse;                 // # of blocks with ghosts
+  int cstale;                  // 1 if the blocks must be set up again
+  double *cconc;               // block concentration
+  double *cprev;               // block concentration at n-1 step
+  double *cpenult;             // block concentration at n-2 step
+  double *creac;               // sum of the reaction rates of a block
+  double **cdface;             // diffusivity of -x, -y and -z block faces
+  int cface_flag;              // 1 if cdface is out of date
+  int nactive;                 // # of owned cells read by reaction fixes
+  int maxactive;
+  int *active;                 // base cell and block of each active cell
+  int *active_block;
+
+  // halo exchange of blocks, same pattern as CommGrid
+  std::vector<int> crecvproc, crecv_begin, crecv_cells;
+  std::vector<int> csendproc, csend_begin, csend_cells;
+  std::vector<int> crecv_self, csend_self;
+  std::vector<double> cbuf_recv, cbuf_send;
+  std::vector<MPI_Request> crequests;
+
+  void neumann();
+  void compute_sor();
+  void compute_coarse();
+  void coarse_setup();
+  void coarse_comm();
+  void coarse_boundary();
+  void coarse_faces();
+  int coarse_cell(int, int, int);
+  double block_face(double *, int, int, int);
+  void lb_coupling();
+  double lb_velocity(int, double *);
+  double advection_flux(int, int, int);
 };
 
 }
@@ -62,4 +136,36 @@ class FixDiffusionReaction : public Fix {
 #endif
 
 /* ERROR/WARNING messages:
+
+E: Fix nufeb/diffusion_reaction advection is not supported with KOKKOS
+
+The Kokkos diffusion kernel has no advection term.
+
+E: Fix nufeb/diffusion_reaction diffusivity is not supported with KOKKOS
+
+The Kokkos diffusion kernel uses the uniform diffusion coefficient, only
+diffusivity uniform can be used.
+
+E: Grid level of substrate %s requires one ghost layer
+
+Coarse blocks exchange their boundary values through a single layer
+of ghost cells.
+
+E: Grid level of substrate %s requires diffsolver dt and diffreac explicit
+
+Coarse blocks are only updated by the explicit solver.
+
+E: Grid level of substrate %s is not supported with advection
+
+Self-explanatory.
+
+E: Grid of substrate %s is not divisible into level blocks
+
+The global grid and the grid of each processor must be a whole number
+of coarse blocks in each dimension.
+
+E: Conflicting self send and recv sizes of substrate %s blocks (this is possibly a bug)
+
+Self-explanatory.
+
 */
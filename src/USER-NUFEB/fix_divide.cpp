@@ -16,6 +16,8 @@
 #include <string.h>
 #include "error.h"
 #include "update.h"
+#include "force.h"
+#include "nufeb_bins.h"
 
 using namespace LAMMPS_NS;
 using namespace FixConst;
@@ -28,6 +30,16 @@ FixDivide::FixDivide(LAMMPS *lmp, int narg, char **arg) :
 {
   compute_flag = 1;
   force_reneighbor = 1;
+
+  ntrial = 1;
+  bins = new NufebBins(lmp);
+}
+
+/* ---------------------------------------------------------------------- */
+
+FixDivide::~FixDivide()
+{
+  delete bins;
 }
 
 
@@ -56,6 +68,13 @@ int FixDivide::modify_param(int narg, char **arg)
 	error->all(FLERR, "Illegal fix_modify command");
       }
       iarg += 2;
+    } else if (strcmp(arg[iarg], "trials") == 0) {
+      if (iarg+2 > narg)
+	error->all(FLERR, "Illegal fix_modify command");
+      ntrial = force->inumeric(FLERR, arg[iarg+1]);
+      if (ntrial < 1)
+	error->all(FLERR, "Illegal fix_modify command");
+      iarg += 2;
     } else {
       error->all(FLERR, "Illegal fix_modify command");
     }
@@ -81,3 +100,12 @@ void FixDivide::post_neighbor()
   // reset reneighbour flag
   next_reneighbor = 0;
 }
+
+/* ----------------------------------------------------------------------
+   memory usage of cell bins
+------------------------------------------------------------------------- */
+
+double FixDivide::memory_usage()
+{
+  return bins->memory_usage();
+}
@@ -23,12 +23,18 @@ class FixDivide : public Fix {
   int compute_flag;
   
   FixDivide(class LAMMPS *, int, char **);
-  virtual ~FixDivide() {};
+  virtual ~FixDivide();
   int modify_param(int, char **);
   int setmask();
   void post_integrate();
   void post_neighbor();
   virtual void compute() = 0;
+  double memory_usage();
+
+ protected:
+  int ntrial;                   // # of candidate division axes
+  class NufebBins *bins;        // atoms binned for candidate scoring
+
 };
 
 }
@@ -27,6 +27,8 @@
 #include "modify.h"
 #include "domain.h"
 #include "atom_masks.h"
+#include "memory.h"
+#include "nufeb_bins.h"
 
 using namespace LAMMPS_NS;
 using namespace FixConst;
@@ -63,13 +65,36 @@ void FixDivideCoccus::compute()
 {  
   int nlocal = atom->nlocal;
 
+  // split ratio and division axis (theta, phi) of each dividing atom,
+  //   chosen before any atom is created since new atoms overwrite
+  //   the binned ghost atoms
+
+  double **axis;
+  memory->create(axis, MAX(nlocal, 1), 3, "nufeb/divide/coccus:axis");
+
+  int ndivide = 0;
+  for (int i = 0; i < nlocal; i++) {
+    if ((atom->mask[i] & groupbit) && atom->radius[i] * 2 >= diameter)
+      ndivide++;
+  }
+  if (ndivide && ntrial > 1) bins->bin_atoms();
+
+  for (int i = 0; i < nlocal; i++) {
+    if ((atom->mask[i] & groupbit) && atom->radius[i] * 2 >= diameter) {
+      axis[i][0] = 0.4 + (random->uniform() * 0.2);
+      axis[i][1] = random->uniform() * 2 * MY_PI;
+      axis[i][2] = random->uniform() * (MY_PI);
+      if (ntrial > 1) choose_axis(i, axis[i]);
+    }
+  }
+
   for (int i = 0; i < nlocal; i++) {
     if (atom->mask[i] & groupbit) {
       if (atom->radius[i] * 2 >= diameter) {
 	double density = atom->rmass[i] /
 	  (4.0 * MY_PI / 3.0 * atom->radius[i] * atom->radius[i] * atom->radius[i]);
 
-        double split = 0.4 + (random->uniform() * 0.2);
+        double split = axis[i][0];
         double imass = atom->rmass[i] * split;
         double jmass = atom->rmass[i] - imass;
 
@@ -79,8 +104,8 @@ void FixDivideCoccus::compute()
         double iouter_mass = atom->outer_mass[i] * split;
         double jouter_mass = atom->outer_mass[i] - iouter_mass;
 
-        double theta = random->uniform() * 2 * MY_PI;
-        double phi = random->uniform() * (MY_PI);
+        double theta = axis[i][1];
+        double phi = axis[i][2];
 
         double oldx = atom->x[i][0];
         double oldy = atom->x[i][1];
@@ -173,6 +198,8 @@ void FixDivideCoccus::compute()
     }
   }
 
+  memory->destroy(axis);
+
   bigint nblocal = atom->nlocal;
   MPI_Allreduce(&nblocal, &atom->natoms, 1, MPI_LMP_BIGINT, MPI_SUM, world);
   if (atom->natoms < 0 || atom->natoms >= MAXBIGINT)
@@ -188,3 +215,42 @@ void FixDivideCoccus::compute()
     atom->map_set();
   }
 }
+
+/* ----------------------------------------------------------------------
+   sample ntrial-1 more division axes of atom i and keep the one whose
+   daughters overlap least with the neighbors and the box boundaries
+------------------------------------------------------------------------- */
+
+void FixDivideCoccus::choose_axis(int i, double *axis)
+{
+  double density = atom->rmass[i] /
+    (4.0 * MY_PI / 3.0 * atom->radius[i] * atom->radius[i] * atom->radius[i]);
+  double imass = atom->rmass[i] * axis[0];
+  double jmass = atom->rmass[i] - imass;
+  double iouter_mass = atom->outer_mass[i] * axis[0];
+  double jouter_mass = atom->outer_mass[i] - iouter_mass;
+  double iouter_radius = pow((3.0 / (4.0 * MY_PI)) * ((imass / density) + (iouter_mass / eps_density)), (1.0 / 3.0));
+  double jouter_radius = pow((3.0 / (4.0 * MY_PI)) * ((jmass / density) + (jouter_mass / eps_density)), (1.0 / 3.0));
+
+  double best = -1.0;
+  double theta = axis[1];
+  double phi = axis[2];
+  for (int n = 0; n < ntrial; n++) {
+    if (n > 0) {
+      theta = random->uniform() * 2 * MY_PI;
+      phi = random->uniform() * (MY_PI);
+    }
+    double u[3] = {cos(theta) * sin(phi), sin(theta) * sin(phi), cos(phi)};
+    double xi[3], xj[3];
+    for (int d = 0; d < 3; d++) {
+      xi[d] = atom->x[i][d] + iouter_radius * u[d] * DELTA;
+      xj[d] = atom->x[i][d] - jouter_radius * u[d] * DELTA;
+    }
+    double score = bins->overlap(i, xi, iouter_radius) + bins->overlap(i, xj, jouter_radius);
+    if (best < 0.0 || score < best) {
+      best = score;
+      axis[1] = theta;
+      axis[2] = phi;
+    }
+  }
+}
@@ -37,6 +37,8 @@ class FixDivideCoccus : public FixDivide {
   int seed;  
 
   class RanPark *random;
+
+  void choose_axis(int, double *);
 };
 
 }
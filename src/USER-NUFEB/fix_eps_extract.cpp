@@ -26,6 +26,8 @@
 #include "domain.h"
 #include "group.h"
 #include "atom_masks.h"
+#include "memory.h"
+#include "nufeb_bins.h"
 
 using namespace LAMMPS_NS;
 using namespace FixConst;
@@ -55,6 +57,9 @@ FixEPSExtract::FixEPSExtract(LAMMPS *lmp, int narg, char **arg) :
   random = new RanPark(lmp, seed);
 
   force_reneighbor = 1;
+
+  ntrial = 1;
+  bins = new NufebBins(lmp);
 }
 
 /* ---------------------------------------------------------------------- */
@@ -62,6 +67,7 @@ FixEPSExtract::FixEPSExtract(LAMMPS *lmp, int narg, char **arg) :
 FixEPSExtract::~FixEPSExtract()
 {
   delete random;
+  delete bins;
 }
 
 /* ---------------------------------------------------------------------- */
@@ -89,6 +95,13 @@ int FixEPSExtract::modify_param(int narg, char **arg)
 	error->all(FLERR, "Illegal fix_modify command");
       }
       iarg += 2;
+    } else if (strcmp(arg[iarg], "trials") == 0) {
+      if (iarg+2 > narg)
+	error->all(FLERR, "Illegal fix_modify command");
+      ntrial = force->inumeric(FLERR, arg[iarg+1]);
+      if (ntrial < 1)
+	error->all(FLERR, "Illegal fix_modify command");
+      iarg += 2;
     } else {
       error->all(FLERR, "Illegal fix_modify command");
     }
@@ -118,13 +131,36 @@ void FixEPSExtract::compute()
 {
   int nlocal = atom->nlocal;
   int eps_mask = group->bitmask[ieps];
+
+  // split ratio and extraction direction (theta, phi) of each atom,
+  //   chosen before any atom is created since new atoms overwrite
+  //   the binned ghost atoms
+
+  double **axis;
+  memory->create(axis, MAX(nlocal, 1), 3, "nufeb/eps_extract:axis");
+
+  int nextract = 0;
+  for (int i = 0; i < nlocal; i++) {
+    if ((atom->mask[i] & groupbit) && (atom->outer_radius[i] / atom->radius[i]) > ratio)
+      nextract++;
+  }
+  if (nextract && ntrial > 1) bins->bin_atoms();
+
+  for (int i = 0; i < nlocal; i++) {
+    if ((atom->mask[i] & groupbit) && (atom->outer_radius[i] / atom->radius[i]) > ratio) {
+      axis[i][0] = 0.4 + (random->uniform() * 0.2);
+      axis[i][1] = random->uniform() * 2 * MY_PI;
+      axis[i][2] = random->uniform() * (MY_PI);
+      if (ntrial > 1) choose_axis(i, axis[i]);
+    }
+  }
   
   for (int i = 0; i < nlocal; i++) {
     if (atom->mask[i] & groupbit) {
       if ((atom->outer_radius[i] / atom->radius[i]) > ratio) {
         atom->outer_mass[i] = (4.0 * MY_PI / 3.0) * ((atom->outer_radius[i] * atom->outer_radius[i] * atom->outer_radius[i]) - (atom->radius[i] * atom->radius[i] * atom->radius[i])) * density;
 
-        double split = 0.4 + (random->uniform() * 0.2);
+        double split = axis[i][0];
 
         double new_outer_mass = atom->outer_mass[i] * split;
         double eps_mass = atom->outer_mass[i] - new_outer_mass;
@@ -134,8 +170,8 @@ void FixEPSExtract::compute()
         double density = atom->rmass[i] / (4.0 * MY_PI / 3.0 * atom->radius[i] * atom->radius[i] * atom->radius[i]);
         atom->outer_radius[i] = pow((3.0 / (4.0 * MY_PI)) * ((atom->rmass[i] / density) + (atom->outer_mass[i] / density)), (1.0 / 3.0));
 
-        double theta = random->uniform() * 2 * MY_PI;
-        double phi = random->uniform() * (MY_PI);
+        double theta = axis[i][1];
+        double phi = axis[i][2];
 
         double oldx = atom->x[i][0];
         double oldy = atom->x[i][1];
@@ -196,6 +232,8 @@ void FixEPSExtract::compute()
     }
   }
 
+  memory->destroy(axis);
+
   bigint nblocal = atom->nlocal;
   MPI_Allreduce(&nblocal, &atom->natoms, 1, MPI_LMP_BIGINT, MPI_SUM, world);
   if (atom->natoms < 0 || atom->natoms >= MAXBIGINT)
@@ -214,3 +252,47 @@ void FixEPSExtract::compute()
   // trigger immediate reneighboring
   next_reneighbor = update->ntimestep;
 }
+
+/* ----------------------------------------------------------------------
+   sample ntrial-1 more extraction directions of atom i and keep the one
+   whose EPS particle overlaps least with the neighbors and the box
+------------------------------------------------------------------------- */
+
+void FixEPSExtract::choose_axis(int i, double *axis)
+{
+  double outer_mass = (4.0 * MY_PI / 3.0) * ((atom->outer_radius[i] * atom->outer_radius[i] * atom->outer_radius[i]) - (atom->radius[i] * atom->radius[i] * atom->radius[i])) * density;
+  double new_outer_mass = outer_mass * axis[0];
+  double eps_mass = outer_mass - new_outer_mass;
+  double idensity = atom->rmass[i] / (4.0 * MY_PI / 3.0 * atom->radius[i] * atom->radius[i] * atom->radius[i]);
+  double outer_radius = pow((3.0 / (4.0 * MY_PI)) * ((atom->rmass[i] / idensity) + (new_outer_mass / idensity)), (1.0 / 3.0));
+  double child_radius = pow(((6 * eps_mass) / (idensity * MY_PI)), (1.0 / 3.0)) * 0.5;
+
+  double best = -1.0;
+  double theta = axis[1];
+  double phi = axis[2];
+  for (int n = 0; n < ntrial; n++) {
+    if (n > 0) {
+      theta = random->uniform() * 2 * MY_PI;
+      phi = random->uniform() * (MY_PI);
+    }
+    double x[3];
+    x[0] = atom->x[i][0] - ((child_radius + outer_radius) * cos(theta) * sin(phi) * DELTA);
+    x[1] = atom->x[i][1] - ((child_radius + outer_radius) * sin(theta) * sin(phi) * DELTA);
+    x[2] = atom->x[i][2] - ((child_radius + outer_radius) * cos(phi) * DELTA);
+    double score = bins->overlap(i, x, child_radius);
+    if (best < 0.0 || score < best) {
+      best = score;
+      axis[1] = theta;
+      axis[2] = phi;
+    }
+  }
+}
+
+/* ----------------------------------------------------------------------
+   memory usage of cell bins
+------------------------------------------------------------------------- */
+
+double FixEPSExtract::memory_usage()
+{
+  return bins->memory_usage();
+}
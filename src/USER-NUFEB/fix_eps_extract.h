@@ -35,6 +35,7 @@ class FixEPSExtract : public Fix {
   void post_integrate();
   void post_neighbor();
   void compute();
+  double memory_usage();
   
  private:
   int type;
@@ -42,8 +43,12 @@ class FixEPSExtract : public Fix {
   double ratio;
   double density;
   int seed;
+  int ntrial;                   // # of candidate extraction directions
+  class NufebBins *bins;        // atoms binned for candidate scoring
 
   class RanPark *random;
+
+  void choose_axis(int, double *);
 };
 }
 
@@ -133,7 +133,7 @@ void FixGasLiquid::compute()
   double vol = grid->cell_size * grid->cell_size * grid->cell_size;
 
   for (int i = 0; i < grid->ncells; i++) {
-    if (!(grid->mask[i] & GHOST_MASK)) {
+    if (!(grid->mask[i] & GHOST_MASK) || grid->mask[i] & HALO_MASK) {
       p_g2l = kga * (conc[iliquid][i]/(h * mw) - grid->bulk[igas]);
       n_l2g = -p_g2l / (rg * temp);
       // update reaction rates
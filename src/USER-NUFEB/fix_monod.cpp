@@ -17,6 +17,7 @@
 
 #include "fix_monod.h"
 #include "error.h"
+#include "force.h"
 #include "update.h"
 #include "atom.h"
 #include "grid.h"
@@ -35,6 +36,8 @@ FixMonod::FixMonod(LAMMPS *lmp, int narg, char **arg) :
   compute_flag = 1;
   reaction_flag = 1;
   growth_flag = 1;
+  growth_every = 1;
+  outside_flag = 0;
   dt = 1.0;
 }
 
@@ -71,6 +74,11 @@ int FixMonod::modify_param(int narg, char **arg)
 	error->all(FLERR, "Illegal fix_modify command");
       }
       iarg += 2;
+    } else if (strcmp(arg[iarg], "subcycle") == 0) {
+      growth_every = force->inumeric(FLERR, arg[iarg+1]);
+      if (growth_every < 1)
+	error->all(FLERR, "Illegal fix_modify command");
+      iarg += 2;
     } else {
       error->all(FLERR, "Illegal fix_modify command");
     }
@@ -114,7 +122,6 @@ void FixMonod::post_integrate()
 
 void FixMonod::update_atoms_coccus()
 {
-  double **x = atom->x;
   double *radius = atom->radius;
   double *rmass = atom->rmass;
   double *biomass = atom->biomass;
@@ -125,12 +132,14 @@ void FixMonod::update_atoms_coccus()
   const double four_thirds_pi = 4.0 * MY_PI / 3.0;
   const double third = 1.0 / 3.0;
 
+  gather_setup();
   for (int i = 0; i < atom->nlocal; i++) {
     if (atom->mask[i] & groupbit) {
-      const int cell = grid->cell(x[i]);
+      double g[2];
+      gather(i, g);
       const double density = rmass[i] /
     (four_thirds_pi * radius[i] * radius[i] * radius[i]);
-      double growth = grid->growth[igroup][cell][0];
+      double growth = g[0];
       // forward Euler to update rmass
       rmass[i] = rmass[i] * (1 + growth * dt);
       radius[i] = pow(three_quarters_pi * (rmass[i] / density), third);
@@ -144,13 +153,13 @@ void FixMonod::update_atoms_coccus()
 
 void FixMonod::update_atoms_bacillus(AtomVecBacillus *&avec)
 {
-  double **x = atom->x;
   double *radius = atom->radius;
   double *rmass = atom->rmass;
   double *biomass = atom->biomass;
 
   const double four_thirds_pi = 4.0 * MY_PI / 3.0;
 
+  gather_setup();
   for (int i = 0; i < atom->nlocal; i++) {
     if (atom->mask[i] & groupbit) {
       double vsphere = four_thirds_pi * atom->radius[i]*atom->radius[i]*atom->radius[i];
@@ -161,9 +170,10 @@ void FixMonod::update_atoms_bacillus(AtomVecBacillus *&avec)
       double length = bonus->length;
 
       double new_length;
-      const int cell = grid->cell(x[i]);
+      double g[2];
+      gather(i, g);
       const double density = rmass[i] /	(vsphere + acircle * bonus->length);
-      double growth = grid->growth[igroup][cell][0];
+      double growth = g[0];
       // forward Eular to update rmass
       rmass[i] = rmass[i] * (1 + growth * dt);
       new_length = (rmass[i] - density * vsphere) / (density * acircle);
@@ -181,3 +191,47 @@ void FixMonod::update_atoms_bacillus(AtomVecBacillus *&avec)
     }
   }
 }
+
+/* ----------------------------------------------------------------------
+   make sure the CIC stencils of local atoms are available, they are
+   normally left by the last density deposition
+------------------------------------------------------------------------- */
+
+void FixMonod::gather_setup()
+{
+  if (grid->interp == Grid::CIC && !grid->weights_current(atom->nlocal))
+    grid->compute_weights(atom->nlocal);
+}
+
+/* ----------------------------------------------------------------------
+   growth rates of the group at local atom i, from the cell containing
+   it or interpolated over its CIC stencil
+------------------------------------------------------------------------- */
+
+void FixMonod::gather(int i, double *g)
+{
+  double **grow = grid->growth[igroup];
+
+  if (grid->interp == Grid::CIC) {
+    int *cells = grid->wcell[i];
+    double *w = grid->weight[i];
+    double wsum = 0.0;
+    g[0] = g[1] = 0.0;
+    for (int k = 0; k < 8; k++) {
+      if (cells[k] < 0) continue;
+      g[0] += w[k] * grow[cells[k]][0];
+      g[1] += w[k] * grow[cells[k]][1];
+      wsum += w[k];
+    }
+    // stencils of atoms that drifted out of the sub-domain lose cells
+    if (wsum > 0.0) {
+      g[0] /= wsum;
+      g[1] /= wsum;
+      return;
+    }
+  }
+
+  int cell = grid->cell(atom->x[i]);
+  g[0] = grow[cell][0];
+  g[1] = grow[cell][1];
+}
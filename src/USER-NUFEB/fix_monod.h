@@ -24,6 +24,8 @@ class FixMonod : public Fix {
   int compute_flag;
   int reaction_flag;
   int growth_flag;
+  int growth_every;             // update growth every this many bio steps
+  int outside_flag;             // 1 if reactions also act without biomass
 
   FixMonod(class LAMMPS *, int, char **);
   virtual ~FixMonod() {}
@@ -41,6 +43,8 @@ class FixMonod : public Fix {
   virtual void update_atoms() = 0;
   void update_atoms_coccus();
   void update_atoms_bacillus(AtomVecBacillus *&avec);
+  void gather_setup();
+  void gather(int, double *);
 };
 
 }
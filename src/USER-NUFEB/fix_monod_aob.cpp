@@ -22,6 +22,8 @@
 #include "group.h"
 #include "grid_masks.h"
 #include "math_const.h"
+#include "modify.h"
+#include "fix_ph.h"
 
 using namespace LAMMPS_NS;
 using namespace FixConst;
@@ -49,6 +51,9 @@ FixMonodAOB::FixMonodAOB(LAMMPS *lmp, int narg, char **arg) :
   maintain = 0.0;
   decay = 0.0;
 
+  ph_id = NULL;
+  fix_ph = NULL;
+
   inh4 = grid->find(arg[3]);
   if (inh4 < 0)
     error->all(FLERR, "Can't find substrate name");
@@ -77,6 +82,13 @@ FixMonodAOB::FixMonodAOB(LAMMPS *lmp, int narg, char **arg) :
     } else if (strcmp(arg[iarg], "decay") == 0) {
       decay = force->numeric(FLERR, arg[iarg+1]);
       iarg += 2;
+    } else if (strcmp(arg[iarg], "ph") == 0) {
+      if (iarg+2 > narg)
+	error->all(FLERR, "Illegal fix nufeb/monod/aob command");
+      int n = strlen(arg[iarg+1]) + 1;
+      ph_id = new char[n];
+      strcpy(ph_id, arg[iarg+1]);
+      iarg += 2;
     } else {
       error->all(FLERR, "Illegal fix nufeb/monod/aob command");
     }
@@ -85,6 +97,31 @@ FixMonodAOB::FixMonodAOB(LAMMPS *lmp, int narg, char **arg) :
 
 /* ---------------------------------------------------------------------- */
 
+FixMonodAOB::~FixMonodAOB()
+{
+  delete [] ph_id;
+}
+
+/* ---------------------------------------------------------------------- */
+
+void FixMonodAOB::init()
+{
+  FixMonod::init();
+
+  if (ph_id) {
+    int ifix = modify->find_fix(ph_id);
+    if (ifix < 0)
+      error->all(FLERR, "Fix ID for nufeb/monod/aob ph does not exist");
+    if (strcmp(modify->fix[ifix]->style, "nufeb/ph") != 0)
+      error->all(FLERR, "Fix nufeb/monod/aob ph requires fix nufeb/ph");
+    fix_ph = (FixPH *)modify->fix[ifix];
+    if (fix_ph->find_acid(inh4) < 0)
+      error->all(FLERR, "Fix nufeb/ph does not speciate the substrate of nufeb/monod/aob");
+  }
+}
+
+/* ---------------------------------------------------------------------- */
+
 void FixMonodAOB::compute()
 {
   if (reaction_flag && growth_flag) {
@@ -106,12 +143,14 @@ void FixMonodAOB::update_cells()
   double **conc = grid->conc;
   double **reac = grid->reac;
   double **dens = grid->dens;
+  // growth is limited by free ammonia if the pH is resolved
+  double *nh3 = fix_ph ? fix_ph->species(inh4, FixPH::BASE) : conc[inh4];
 
   for (int i = 0; i < grid->ncells; i++) {
-    double tmp1 = growth * conc[inh4][i] / (nh4_affinity + conc[inh4][i]) * conc[io2][i] / (o2_affinity + conc[io2][i]);
+    double tmp1 = growth * nh3[i] / (nh4_affinity + nh3[i]) * conc[io2][i] / (o2_affinity + conc[io2][i]);
     double tmp2 = maintain * conc[io2][i] / (o2_affinity + conc[io2][i]);
 
-    if (Reaction &&  !(grid->mask[i] & GHOST_MASK)) {
+    if (Reaction && (!(grid->mask[i] & GHOST_MASK) || grid->mask[i] & HALO_MASK)) {
       reac[inh4][i] -= 1 / yield * tmp1 * dens[igroup][i];
       reac[io2][i] -= (4.57 - yield) / yield * tmp1 * dens[igroup][i] + tmp2 * dens[igroup][i];
       reac[ino2][i] += 1 / yield * tmp1 * dens[igroup][i];
@@ -27,7 +27,8 @@ namespace LAMMPS_NS {
 class FixMonodAOB: public FixMonod {
  public:
   FixMonodAOB(class LAMMPS *, int, char **);
-  virtual ~FixMonodAOB() {}
+  virtual ~FixMonodAOB();
+  virtual void init();
   virtual void compute();
 
  protected:
@@ -42,6 +43,9 @@ class FixMonodAOB: public FixMonod {
   double yield;
   double maintain;
   double decay;
+
+  char *ph_id;                  // id of fix nufeb/ph, NULL for total ammonium
+  class FixPH *fix_ph;
   
   template <int, int> void update_cells();
   virtual void update_atoms();
@@ -53,4 +57,17 @@ class FixMonodAOB: public FixMonod {
 #endif
 
 /* ERROR/WARNING messages:
+
+E: Fix ID for nufeb/monod/aob ph does not exist
+
+Self-explanatory.
+
+E: Fix nufeb/monod/aob ph requires fix nufeb/ph
+
+Self-explanatory.
+
+E: Fix nufeb/ph does not speciate the substrate of nufeb/monod/aob
+
+The ammonium substrate must be defined as an acid of fix nufeb/ph.
+
 */
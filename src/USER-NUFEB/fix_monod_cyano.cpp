@@ -108,6 +108,9 @@ FixMonodCyano::FixMonodCyano(LAMMPS *lmp, int narg, char **arg) :
       error->all(FLERR, "Illegal fix nufeb/monod/cyano command");
     }
   }
+
+  // co2 dissolves in every cell
+  outside_flag = gco2_flag;
 }
 
 /* ---------------------------------------------------------------------- */
@@ -141,7 +144,7 @@ void FixMonodCyano::update_cells()
     double tmp2 = 0.2 * tmp1 * suc_exp;
     double tmp3 = 4 * tmp1 * suc_exp;
 
-    if (Reaction && !(grid->mask[i] & GHOST_MASK)) {
+    if (Reaction && (!(grid->mask[i] & GHOST_MASK) || grid->mask[i] & HALO_MASK)) {
       // nutrient utilization
       reac[ilight][i] -= 1 / yield * (tmp1 + tmp3) * dens[igroup][i];
       reac[ico2][i] -= 1 / yield * (tmp1 + tmp3) * dens[igroup][i];
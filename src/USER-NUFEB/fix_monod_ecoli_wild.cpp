@@ -123,7 +123,7 @@ void FixMonodEcoliWild::update_cells()
     // sucrose export-induced growth reduction
     double tmp2 = maintain * conc[io2][i] / (o2_affinity + conc[io2][i]);
 
-    if (Reaction && !(grid->mask[i] & GHOST_MASK)) {
+    if (Reaction && (!(grid->mask[i] & GHOST_MASK) || grid->mask[i] & HALO_MASK)) {
       // nutrient utilization
       reac[isuc][i] -= 1 / yield * tmp1 * dens[igroup][i];
       reac[io2][i] -= 0.399 * (tmp1 + tmp2) * dens[igroup][i];
@@ -79,7 +79,7 @@ void FixMonodEPS::update_cells()
   double **dens = grid->dens;
 
   for (int i = 0; i < grid->ncells; i++) {
-    if (Reaction &&  !(grid->mask[i] & GHOST_MASK)) {
+    if (Reaction && (!(grid->mask[i] & GHOST_MASK) || grid->mask[i] & HALO_MASK)) {
       reac[isub][i] += decay * dens[igroup][i];
     }
 
@@ -137,7 +137,7 @@ void FixMonodHET::update_cells()
     double tmp5 = 1 / 2.86 * maintain * anoxic * conc[ino3][i] / (no3_affinity + conc[ino3][i]) * o2_affinity / (o2_affinity + conc[io2][i]);
     double tmp6 = 1 / 1.17 * maintain * anoxic * conc[ino2][i] / (no2_affinity + conc[ino2][i]) * o2_affinity / (o2_affinity + conc[io2][i]);
 
-    if (Reaction && !(grid->mask[i] & GHOST_MASK)) {
+    if (Reaction && (!(grid->mask[i] & GHOST_MASK) || grid->mask[i] & HALO_MASK)) {
       reac[isub][i] -= 1 / yield * (tmp1 + tmp2 + tmp3) * dens[igroup][i];
       reac[io2][i] -= (1 - yield - eps_yield) / yield * tmp1 * dens[igroup][i] + tmp4 * dens[igroup][i];
       reac[ino2][i] -= (1 - yield - eps_yield) / (1.17 * yield) * tmp3 * dens[igroup][i] + tmp6 * dens[igroup][i];
@@ -156,29 +156,29 @@ void FixMonodHET::update_cells()
 
 void FixMonodHET::update_atoms()
 {
-  double **x = atom->x;
   double *radius = atom->radius;
   double *rmass = atom->rmass;
   double *biomass = atom->biomass;
   double *outer_radius = atom->outer_radius;
   double *outer_mass = atom->outer_mass;
-  double ***growth = grid->growth;
 
   const double three_quarters_pi = (3.0 / (4.0 * MY_PI));
   const double four_thirds_pi = 4.0 * MY_PI / 3.0;
   const double third = 1.0 / 3.0;
 
+  gather_setup();
   for (int i = 0; i < atom->nlocal; i++) {
     if (atom->mask[i] & groupbit) {
-      const int cell = grid->cell(x[i]);
+      double g[2];
+      gather(i, g);
       const double density = rmass[i] /
 	(four_thirds_pi * radius[i] * radius[i] * radius[i]);
       // forward Euler to update biomass and rmass
-      rmass[i] = rmass[i] * (1 + growth[igroup][cell][0] * dt);
+      rmass[i] = rmass[i] * (1 + g[0] * dt);
       outer_mass[i] = four_thirds_pi *
 	(outer_radius[i] * outer_radius[i] * outer_radius[i] -
 	 radius[i] * radius[i] * radius[i]) *
-	eps_dens + growth[igroup][cell][1] * rmass[i] * dt;
+	eps_dens + g[1] * rmass[i] * dt;
       radius[i] = pow(three_quarters_pi * (rmass[i] / density), third);
       outer_radius[i] = pow(three_quarters_pi *
 			    (rmass[i] / density + outer_mass[i] / eps_dens),
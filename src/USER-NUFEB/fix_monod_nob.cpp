@@ -22,6 +22,8 @@
 #include "group.h"
 #include "grid_masks.h"
 #include "math_const.h"
+#include "modify.h"
+#include "fix_ph.h"
 
 using namespace LAMMPS_NS;
 using namespace FixConst;
@@ -49,6 +51,9 @@ FixMonodNOB::FixMonodNOB(LAMMPS *lmp, int narg, char **arg) :
   maintain = 0.0;
   decay = 0.0;
 
+  ph_id = NULL;
+  fix_ph = NULL;
+
   io2 = grid->find(arg[3]);
   if (io2 < 0)
     error->all(FLERR, "Can't find substrate name");
@@ -77,6 +82,13 @@ FixMonodNOB::FixMonodNOB(LAMMPS *lmp, int narg, char **arg) :
     } else if (strcmp(arg[iarg], "decay") == 0) {
       decay = force->numeric(FLERR, arg[iarg+1]);
       iarg += 2;
+    } else if (strcmp(arg[iarg], "ph") == 0) {
+      if (iarg+2 > narg)
+	error->all(FLERR, "Illegal fix nufeb/monod/nob command");
+      int n = strlen(arg[iarg+1]) + 1;
+      ph_id = new char[n];
+      strcpy(ph_id, arg[iarg+1]);
+      iarg += 2;
     } else {
       error->all(FLERR, "Illegal fix nufeb/monod/nob command");
     }
@@ -85,6 +97,31 @@ FixMonodNOB::FixMonodNOB(LAMMPS *lmp, int narg, char **arg) :
 
 /* ---------------------------------------------------------------------- */
 
+FixMonodNOB::~FixMonodNOB()
+{
+  delete [] ph_id;
+}
+
+/* ---------------------------------------------------------------------- */
+
+void FixMonodNOB::init()
+{
+  FixMonod::init();
+
+  if (ph_id) {
+    int ifix = modify->find_fix(ph_id);
+    if (ifix < 0)
+      error->all(FLERR, "Fix ID for nufeb/monod/nob ph does not exist");
+    if (strcmp(modify->fix[ifix]->style, "nufeb/ph") != 0)
+      error->all(FLERR, "Fix nufeb/monod/nob ph requires fix nufeb/ph");
+    fix_ph = (FixPH *)modify->fix[ifix];
+    if (fix_ph->find_acid(ino2) < 0)
+      error->all(FLERR, "Fix nufeb/ph does not speciate the substrate of nufeb/monod/nob");
+  }
+}
+
+/* ---------------------------------------------------------------------- */
+
 void FixMonodNOB::compute()
 {
   if (reaction_flag && growth_flag) {
@@ -106,12 +143,14 @@ void FixMonodNOB::update_cells()
   double **conc = grid->conc;
   double **reac = grid->reac;
   double **dens = grid->dens;
+  // growth is limited by free nitrous acid if the pH is resolved
+  double *hno2 = fix_ph ? fix_ph->species(ino2, FixPH::ACID) : conc[ino2];
 
   for (int i = 0; i < grid->ncells; i++) {
-    double tmp1 = growth * conc[ino2][i] / (no2_affinity + conc[ino2][i]) * conc[io2][i] / (o2_affinity + conc[io2][i]);
+    double tmp1 = growth * hno2[i] / (no2_affinity + hno2[i]) * conc[io2][i] / (o2_affinity + conc[io2][i]);
     double tmp2 = maintain * conc[io2][i] / (o2_affinity + conc[io2][i]);
 
-    if (Reaction && !(grid->mask[i] & GHOST_MASK)) {
+    if (Reaction && (!(grid->mask[i] & GHOST_MASK) || grid->mask[i] & HALO_MASK)) {
       reac[ino2][i] -= 1 / yield * tmp1 * dens[igroup][i];
       reac[io2][i] -= (1.15 - yield) / yield * tmp1 * dens[igroup][i] + tmp2 * dens[igroup][i];
       reac[ino3][i] += 1 / yield * tmp1 * dens[igroup][i];
@@ -27,7 +27,8 @@ namespace LAMMPS_NS {
 class FixMonodNOB: public FixMonod {
  public:
   FixMonodNOB(class LAMMPS *, int, char **);
-  virtual ~FixMonodNOB() {}
+  virtual ~FixMonodNOB();
+  virtual void init();
   virtual void compute();
 
  protected:
@@ -42,6 +43,9 @@ class FixMonodNOB: public FixMonod {
   double yield;
   double maintain;
   double decay;
+
+  char *ph_id;                  // id of fix nufeb/ph, NULL for total nitrite
+  class FixPH *fix_ph;
   
   template <int, int> void update_cells();
   virtual void update_atoms();
@@ -53,4 +57,17 @@ class FixMonodNOB: public FixMonod {
 #endif
 
 /* ERROR/WARNING messages:
+
+E: Fix ID for nufeb/monod/nob ph does not exist
+
+Self-explanatory.
+
+E: Fix nufeb/monod/nob ph requires fix nufeb/ph
+
+Self-explanatory.
+
+E: Fix nufeb/ph does not speciate the substrate of nufeb/monod/nob
+
+The nitrite substrate must be defined as an acid of fix nufeb/ph.
+
 */
@@ -0,0 +1,367 @@
+/* ----------------------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   http://lammps.sandia.gov, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include "fix_ph.h"
+#include "error.h"
+#include "force.h"
+#include "grid.h"
+#include "grid_masks.h"
+#include "memory.h"
+
+using namespace LAMMPS_NS;
+using namespace FixConst;
+
+#define PTOL 1.0e-8             // convergence of the pH iterate
+#define PHLO 0.0                // initial bracket of the charge balance root
+#define PHHI 14.0
+
+/* ---------------------------------------------------------------------- */
+
+FixPH::FixPH(LAMMPS *lmp, int narg, char **arg) :
+  Fix(lmp, narg, arg)
+{
+  if (narg < 4)
+    error->all(FLERR, "Illegal fix nufeb/ph command");
+
+  if (lmp->kokkos)
+    error->all(FLERR, "Fix nufeb/ph is not supported with KOKKOS");
+
+  compute_flag = 1;
+  scalar_flag = 1;
+  global_freq = 1;
+
+  kw = 1.0e-14;
+  cation = 0.0;
+  tol = 1.0e-6;
+  maxiter = 50;
+
+  nacid = 0;
+  iacid = NULL;
+  ka = NULL;
+  zacid = NULL;
+  molar = NULL;
+
+  ncells = 0;
+  ph = NULL;
+  cref = NULL;
+  spec = NULL;
+  active = NULL;
+  pcur = pmin = pmax = NULL;
+
+  ph0 = force->numeric(FLERR, arg[3]);
+
+  int iarg = 4;
+  while (iarg < narg) {
+    if (strcmp(arg[iarg], "acid") == 0) {
+      if (iarg+5 > narg)
+	error->all(FLERR, "Illegal fix nufeb/ph command");
+      int isub = grid->find(arg[iarg+1]);
+      if (isub < 0)
+	error->all(FLERR, "Can't find substrate name");
+      double mw = force->numeric(FLERR, arg[iarg+4]);
+      if (mw <= 0)
+	error->all(FLERR, "Illegal fix nufeb/ph command");
+      memory->grow(iacid, nacid+1, "nufeb/ph:iacid");
+      memory->grow(ka, nacid+1, "nufeb/ph:ka");
+      memory->grow(zacid, nacid+1, "nufeb/ph:zacid");
+      memory->grow(molar, nacid+1, "nufeb/ph:molar");
+      iacid[nacid] = isub;
+      ka[nacid] = pow(10.0, -force->numeric(FLERR, arg[iarg+2]));
+      zacid[nacid] = force->numeric(FLERR, arg[iarg+3]);
+      // kg m-3 -> mol m-3 -> mol L-1
+      molar[nacid] = 1.0e-3 / mw;
+      nacid++;
+      iarg += 5;
+    } else if (strcmp(arg[iarg], "cation") == 0) {
+      if (iarg+2 > narg)
+	error->all(FLERR, "Illegal fix nufeb/ph command");
+      // mol m-3 -> mol L-1
+      cation = 1.0e-3 * force->numeric(FLERR, arg[iarg+1]);
+      iarg += 2;
+    } else if (strcmp(arg[iarg], "kw") == 0) {
+      if (iarg+2 > narg)
+	error->all(FLERR, "Illegal fix nufeb/ph command");
+      kw = force->numeric(FLERR, arg[iarg+1]);
+      if (kw <= 0)
+	error->all(FLERR, "Illegal fix nufeb/ph command");
+      iarg += 2;
+    } else if (strcmp(arg[iarg], "tol") == 0) {
+      if (iarg+2 > narg)
+	error->all(FLERR, "Illegal fix nufeb/ph command");
+      tol = force->numeric(FLERR, arg[iarg+1]);
+      if (tol < 0)
+	error->all(FLERR, "Illegal fix nufeb/ph command");
+      iarg += 2;
+    } else if (strcmp(arg[iarg], "maxiter") == 0) {
+      if (iarg+2 > narg)
+	error->all(FLERR, "Illegal fix nufeb/ph command");
+      maxiter = force->inumeric(FLERR, arg[iarg+1]);
+      if (maxiter < 1)
+	error->all(FLERR, "Illegal fix nufeb/ph command");
+      iarg += 2;
+    } else {
+      error->all(FLERR, "Illegal fix nufeb/ph command");
+    }
+  }
+
+  if (!nacid)
+    error->all(FLERR, "Fix nufeb/ph requires at least one acid");
+}
+
+/* ---------------------------------------------------------------------- */
+
+FixPH::~FixPH()
+{
+  memory->destroy(iacid);
+  memory->destroy(ka);
+  memory->destroy(zacid);
+  memory->destroy(molar);
+  memory->destroy(ph);
+  memory->destroy(cref);
+  memory->destroy(spec);
+  memory->destroy(active);
+  memory->destroy(pcur);
+  memory->destroy(pmin);
+  memory->destroy(pmax);
+}
+
+/* ---------------------------------------------------------------------- */
+
+int FixPH::modify_param(int narg, char **arg)
+{
+  if (strcmp(arg[0], "compute") == 0) {
+    if (narg < 2) error->all(FLERR, "Illegal fix_modify command");
+    if (strcmp(arg[1], "yes") == 0) {
+      compute_flag = 1;
+    } else if (strcmp(arg[1], "no") == 0) {
+      compute_flag = 0;
+    } else {
+      error->all(FLERR, "Illegal fix_modify command");
+    }
+    return 2;
+  }
+  return 0;
+}
+
+/* ---------------------------------------------------------------------- */
+
+int FixPH::setmask()
+{
+  int mask = 0;
+  mask |= POST_INTEGRATE;
+  return mask;
+}
+
+/* ----------------------------------------------------------------------
+   speciate the initial concentrations so that monod fixes can use the
+   fields before the first call to compute()
+------------------------------------------------------------------------- */
+
+void FixPH::init()
+{
+  compute();
+}
+
+/* ---------------------------------------------------------------------- */
+
+void FixPH::post_integrate()
+{
+  if (compute_flag)
+    compute();
+}
+
+/* ----------------------------------------------------------------------
+   average pH of the owned cells
+------------------------------------------------------------------------- */
+
+double FixPH::compute_scalar()
+{
+  double sum[2] = {0.0, 0.0};
+  for (int i = 0; i < ncells; i++) {
+    if (!(grid->mask[i] & GHOST_MASK)) {
+      sum[0] += ph[i];
+      sum[1] += 1.0;
+    }
+  }
+  MPI_Allreduce(MPI_IN_PLACE, sum, 2, MPI_DOUBLE, MPI_SUM, world);
+  return sum[1] > 0.0 ? sum[0] / sum[1] : ph0;
+}
+
+/* ----------------------------------------------------------------------
+   index of the acid-base pair of a substrate, -1 if not speciated
+------------------------------------------------------------------------- */
+
+int FixPH::find_acid(int isub)
+{
+  for (int j = 0; j < nacid; j++)
+    if (iacid[j] == isub) return j;
+  return -1;
+}
+
+/* ----------------------------------------------------------------------
+   ACID or BASE form of a substrate at the last computed pH
+------------------------------------------------------------------------- */
+
+double *FixPH::species(int isub, int form)
+{
+  int j = find_acid(isub);
+  if (j < 0) return NULL;
+  return spec[2*j+form];
+}
+
+/* ----------------------------------------------------------------------
+   re-solve the charge balance of cells whose acid concentrations changed
+   by more than tol since their last solve, and refresh the speciation of
+   all other cells at their current pH in the same pass
+------------------------------------------------------------------------- */
+
+void FixPH::compute()
+{
+  if (ncells != grid->ncells) grow();
+
+  double **conc = grid->conc;
+  int nactive = 0;
+  for (int i = 0; i < ncells; i++) {
+    int changed = 0;
+    for (int j = 0; j < nacid; j++) {
+      double c = conc[iacid[j]][i];
+      if (fabs(c - cref[j][i]) > tol * fabs(cref[j][i])) changed = 1;
+    }
+    if (changed) {
+      for (int j = 0; j < nacid; j++)
+	cref[j][i] = conc[iacid[j]][i];
+      active[nactive++] = i;
+    } else {
+      speciate(i);
+    }
+  }
+
+  solve(nactive);
+}
+
+/* ----------------------------------------------------------------------
+   safeguarded Newton iterations on the pH of the active cells
+
+   the charge balance
+     f(h) = h - kw/h + cation + sum_j c_j (z_j - ka_j / (h + ka_j))
+   increases monotonically with h = 10^-pH, so each cell keeps a bracket
+   of its root and falls back to bisection if a Newton step leaves it.
+   All cells are iterated in lockstep over compact arrays, converged
+   cells are dropped from the active list after each sweep.
+------------------------------------------------------------------------- */
+
+void FixPH::solve(int nactive)
+{
+  const double ln10 = log(10.0);
+
+  // warm start from the pH of the last solve
+  for (int k = 0; k < nactive; k++) {
+    pcur[k] = ph[active[k]];
+    pmin[k] = PHLO;
+    pmax[k] = PHHI;
+  }
+
+  for (int iter = 0; iter < maxiter && nactive > 0; iter++) {
+    int m = 0;
+    for (int k = 0; k < nactive; k++) {
+      int i = active[k];
+      double p = pcur[k];
+      double h = pow(10.0, -p);
+      double f = h - kw / h + cation;
+      double df = 1.0 + kw / (h * h);
+      for (int j = 0; j < nacid; j++) {
+	double c = cref[j][i] * molar[j];
+	double d = h + ka[j];
+	f += c * (zacid[j] - ka[j] / d);
+	df += c * ka[j] / (d * d);
+      }
+      // f decreases with pH
+      double lo = pmin[k];
+      double hi = pmax[k];
+      if (f > 0.0) lo = p;
+      else hi = p;
+      double pnew = p + f / (ln10 * h * df);
+      if (!(pnew > lo && pnew < hi)) pnew = 0.5 * (lo + hi);
+      ph[i] = pnew;
+      if (fabs(pnew - p) > PTOL) {
+	active[m] = i;
+	pcur[m] = pnew;
+	pmin[m] = lo;
+	pmax[m] = hi;
+	m++;
+      } else {
+	speciate(i);
+      }
+    }
+    nactive = m;
+  }
+
+  // cells that did not converge keep their last iterate
+  for (int k = 0; k < nactive; k++)
+    speciate(active[k]);
+}
+
+/* ---------------------------------------------------------------------- */
+
+void FixPH::speciate(int i)
+{
+  double h = pow(10.0, -ph[i]);
+  for (int j = 0; j < nacid; j++) {
+    double c = grid->conc[iacid[j]][i];
+    double frac = h / (h + ka[j]);
+    spec[2*j][i] = c * frac;
+    spec[2*j+1][i] = c - spec[2*j][i];
+  }
+}
+
+/* ----------------------------------------------------------------------
+   resize the per-cell arrays, cells are reset to the initial pH and
+   solved on the next call
+------------------------------------------------------------------------- */
+
+void FixPH::grow()
+{
+  ncells = grid->ncells;
+  memory->grow(ph, ncells, "nufeb/ph:ph");
+  memory->destroy(cref);
+  memory->create(cref, nacid, ncells, "nufeb/ph:cref");
+  memory->destroy(spec);
+  memory->create(spec, 2*nacid, ncells, "nufeb/ph:spec");
+  memory->grow(active, ncells, "nufeb/ph:active");
+  memory->grow(pcur, ncells, "nufeb/ph:pcur");
+  memory->grow(pmin, ncells, "nufeb/ph:pmin");
+  memory->grow(pmax, ncells, "nufeb/ph:pmax");
+  for (int i = 0; i < ncells; i++) {
+    ph[i] = ph0;
+    for (int j = 0; j < nacid; j++)
+      cref[j][i] = -1.0;
+  }
+}
+
+/* ----------------------------------------------------------------------
+   memory usage of per-cell pH, speciation and solver arrays
+------------------------------------------------------------------------- */
+
+double FixPH::memory_usage()
+{
+  double bytes = 0.0;
+  bytes += ncells * sizeof(double);
+  bytes += (double) nacid * ncells * sizeof(double);
+  bytes += (double) 2 * nacid * ncells * sizeof(double);
+  bytes += ncells * sizeof(int);
+  bytes += 3.0 * ncells * sizeof(double);
+  return bytes;
+}
@@ -0,0 +1,95 @@
+/* -*- c++ -*- ----------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   http://lammps.sandia.gov, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#ifdef FIX_CLASS
+
+FixStyle(nufeb/ph,FixPH)
+
+#else
+
+#ifndef LMP_FIX_PH_H
+#define LMP_FIX_PH_H
+
+#include "fix.h"
+
+namespace LAMMPS_NS {
+
+class FixPH : public Fix {
+ public:
+  enum {ACID,BASE};            // protonated and deprotonated forms
+
+  int compute_flag;
+  double *ph;                  // pH of each cell
+
+  FixPH(class LAMMPS *, int, char **);
+  ~FixPH();
+  int modify_param(int, char **);
+  int setmask();
+  void init();
+  void post_integrate();
+  double compute_scalar();
+  void compute();
+  int find_acid(int);
+  double *species(int, int);
+  double memory_usage();
+
+ protected:
+  double ph0;                  // initial pH of every cell
+  double kw;                   // ionic product of water - mol2 L-2
+  double cation;               // net charge of strong ions - mol L-1
+  double tol;                  // relative change of an acid to resolve a cell
+  int maxiter;                 // max # of Newton iterations per cell
+
+  int nacid;
+  int *iacid;                  // substrate index of each acid-base pair
+  double *ka;                  // dissociation constant - mol L-1
+  double *zacid;               // charge of the protonated form
+  double *molar;               // kg m-3 to mol L-1 conversion factor
+
+  int ncells;
+  double **cref;               // acid concentrations of the last solve
+  double **spec;               // ACID and BASE forms of each pair - kg m-3
+  int *active;                 // cells still iterating
+  double *pcur, *pmin, *pmax;  // pH iterate and bracket of active cells
+
+  void grow();
+  void solve(int);
+  void speciate(int);
+};
+
+}
+
+#endif
+#endif
+
+/* ERROR/WARNING messages:
+
+E: Illegal ... command
+
+Self-explanatory.  Check the input script syntax and compare to the
+documentation for the command.  You can use -echo screen as a
+command-line option when running LAMMPS to see the offending line.
+
+E: Fix nufeb/ph is not supported with KOKKOS
+
+The charge balance is solved on the host copy of the grid.
+
+E: Can't find substrate name
+
+Self-explanatory.
+
+E: Fix nufeb/ph requires at least one acid
+
+Self-explanatory.
+
+*/
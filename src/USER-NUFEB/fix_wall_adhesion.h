@@ -29,7 +29,7 @@ class FixWallAdhesion : public Fix {
   FixWallAdhesion(class LAMMPS *, int, char **);
   virtual ~FixWallAdhesion() {}
   int setmask();
-  void post_force(int);
+  virtual void post_force(int);
 
  protected:
   double kn;
@@ -41,7 +41,10 @@ void GridVecMonod::init()
 {
   GridVec::init();
 
-  size_forward = grid->nsubs;
+  // coarse substrates exchange their own ghost blocks
+  size_forward = 0;
+  for (int s = 0; s < grid->nsubs; s++)
+    if (grid->level[s] == 1) size_forward++;
   size_exchange = grid->nsubs;
 }
 
@@ -75,6 +78,7 @@ int GridVecMonod::pack_comm(int n, int *cells, double *buf)
 {
   int m = 0;
   for (int s = 0; s < grid->nsubs; s++) {
+    if (grid->level[s] > 1) continue;
     for (int c = 0; c < n; c++) {
       buf[m++] = conc[s][cells[c]];
     }
@@ -88,6 +92,7 @@ void GridVecMonod::unpack_comm(int n, int *cells, double *buf)
 {
   int m = 0;
   for (int s = 0; s < grid->nsubs; s++) {
+    if (grid->level[s] > 1) continue;
     for (int c = 0; c < n; c++) {
       conc[s][cells[c]] = buf[m++];
     }
@@ -170,3 +175,18 @@ void GridVecMonod::set_monod(int isub, double domain, double nx, double px,
     grid->reac[isub][i] = 0.0;
   }
 }
+
+/* ----------------------------------------------------------------------
+   return # of bytes of allocated per-cell fields
+------------------------------------------------------------------------- */
+
+bigint GridVecMonod::memory_usage()
+{
+  bigint bytes = 0;
+  bytes += memory->usage(mask,nmax);
+  bytes += memory->usage(conc,grid->nsubs,nmax);
+  bytes += memory->usage(reac,grid->nsubs,nmax);
+  bytes += memory->usage(dens,group->ngroup,nmax);
+  bytes += memory->usage(growth,group->ngroup,nmax,2);
+  return bytes;
+}
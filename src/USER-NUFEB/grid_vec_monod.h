@@ -37,6 +37,7 @@ class GridVecMonod : public GridVec {
   void unpack_exchange(int, int *, double *);
 
   void set(int, char **);
+  bigint memory_usage();
 
  private:
   void set_monod(int, double);
@@ -42,7 +42,10 @@ void GridVecReactor::init()
 {
   GridVec::init();
 
-  size_forward = grid->nsubs;
+  // coarse substrates exchange their own ghost blocks
+  size_forward = 0;
+  for (int s = 0; s < grid->nsubs; s++)
+    if (grid->level[s] == 1) size_forward++;
   size_exchange = grid->nsubs;
 }
 
@@ -78,6 +81,7 @@ int GridVecReactor::pack_comm(int n, int *cells, double *buf)
 {
   int m = 0;
   for (int s = 0; s < grid->nsubs; s++) {
+    if (grid->level[s] > 1) continue;
     for (int c = 0; c < n; c++) {
       buf[m++] = conc[s][cells[c]];
     }
@@ -91,6 +95,7 @@ void GridVecReactor::unpack_comm(int n, int *cells, double *buf)
 {
   int m = 0;
   for (int s = 0; s < grid->nsubs; s++) {
+    if (grid->level[s] > 1) continue;
     for (int c = 0; c < n; c++) {
       conc[s][cells[c]] = buf[m++];
     }
@@ -144,3 +149,19 @@ void GridVecReactor::set_reactor(int isub, double domain, double cbulk)
   }
   bulk[isub] = cbulk;
 }
+
+/* ----------------------------------------------------------------------
+   return # of bytes of allocated per-cell fields
+------------------------------------------------------------------------- */
+
+bigint GridVecReactor::memory_usage()
+{
+  bigint bytes = 0;
+  bytes += memory->usage(mask,nmax);
+  bytes += memory->usage(conc,grid->nsubs,nmax);
+  bytes += memory->usage(reac,grid->nsubs,nmax);
+  bytes += memory->usage(dens,group->ngroup,nmax);
+  bytes += memory->usage(growth,group->ngroup,nmax,2);
+  bytes += memory->usage(bulk,grid->nsubs);
+  return bytes;
+}
@@ -37,6 +37,7 @@ class GridVecReactor : public GridVec {
   void unpack_exchange(int, int *, double *);
 
   void set(int, char **);
+  bigint memory_usage();
 
  private:
   void set_reactor(int, double, double);
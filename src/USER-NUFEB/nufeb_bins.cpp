@@ -0,0 +1,137 @@
+/* ----------------------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   http://lammps.sandia.gov, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#include <cmath>
+#include "nufeb_bins.h"
+#include "atom.h"
+#include "domain.h"
+#include "grid.h"
+#include "memory.h"
+
+using namespace LAMMPS_NS;
+
+/* ---------------------------------------------------------------------- */
+
+NufebBins::NufebBins(LAMMPS *lmp) : Pointers(lmp)
+{
+  bin_head = NULL;
+  bin_next = NULL;
+  nbin_head = nbin_next = 0;
+  max_outer = 0.0;
+}
+
+/* ---------------------------------------------------------------------- */
+
+NufebBins::~NufebBins()
+{
+  memory->destroy(bin_head);
+  memory->destroy(bin_next);
+}
+
+/* ----------------------------------------------------------------------
+   bin owned and ghost atoms into the grid cells of this proc
+------------------------------------------------------------------------- */
+
+void NufebBins::bin_atoms()
+{
+  int nall = atom->nlocal + atom->nghost;
+  if (grid->ncells > nbin_head) {
+    nbin_head = grid->ncells;
+    memory->destroy(bin_head);
+    memory->create(bin_head, nbin_head, "nufeb/bins:bin_head");
+  }
+  if (nall > nbin_next) {
+    nbin_next = atom->nmax;
+    memory->destroy(bin_next);
+    memory->create(bin_next, nbin_next, "nufeb/bins:bin_next");
+  }
+
+  for (int c = 0; c < grid->ncells; c++)
+    bin_head[c] = -1;
+  max_outer = 0.0;
+
+  const double small = 1e-12;
+  for (int i = nall-1; i >= 0; i--) {
+    int c[3];
+    int inside = 1;
+    for (int d = 0; d < 3; d++) {
+      c[d] = static_cast<int>(floor((atom->x[i][d] - domain->boxlo[d]) /
+				    grid->cell_size + small)) - grid->sublo[d];
+      if (c[d] < 0 || c[d] >= grid->subbox[d]) inside = 0;
+    }
+    if (!inside) continue;
+    max_outer = MAX(max_outer, atom->outer_radius[i]);
+    int cell = c[0] + c[1] * grid->subbox[0] + c[2] * grid->subbox[0] * grid->subbox[1];
+    bin_next[i] = bin_head[cell];
+    bin_head[cell] = i;
+  }
+}
+
+/* ----------------------------------------------------------------------
+   summed overlap depth of a sphere of radius r at x with the binned
+   atoms other than i and with the non-periodic box boundaries
+   the grid cells within r plus the largest outer radius of x are searched
+------------------------------------------------------------------------- */
+
+double NufebBins::overlap(int i, double *x, double r)
+{
+  double **xa = atom->x;
+  double *outer_radius = atom->outer_radius;
+
+  int lo[3], hi[3];
+  const double small = 1e-12;
+  int n = static_cast<int>(ceil((r + max_outer) / grid->cell_size));
+  for (int d = 0; d < 3; d++) {
+    int c = static_cast<int>(floor((x[d] - domain->boxlo[d]) /
+				   grid->cell_size + small)) - grid->sublo[d];
+    lo[d] = MAX(0, c - n);
+    hi[d] = MIN(grid->subbox[d] - 1, c + n);
+  }
+
+  double result = 0.0;
+  for (int z = lo[2]; z <= hi[2]; z++) {
+    for (int y = lo[1]; y <= hi[1]; y++) {
+      for (int x0 = lo[0]; x0 <= hi[0]; x0++) {
+	int cell = x0 + y * grid->subbox[0] + z * grid->subbox[0] * grid->subbox[1];
+	for (int j = bin_head[cell]; j >= 0; j = bin_next[j]) {
+	  if (j == i) continue;
+	  double dx = x[0] - xa[j][0];
+	  double dy = x[1] - xa[j][1];
+	  double dz = x[2] - xa[j][2];
+	  double rsq = dx * dx + dy * dy + dz * dz;
+	  double cut = r + outer_radius[j];
+	  if (rsq < cut * cut) result += cut - sqrt(rsq);
+	}
+      }
+    }
+  }
+  // periodic dimensions have no box boundaries
+  for (int d = 0; d < 3; d++) {
+    if (domain->periodicity[d]) continue;
+    if (x[d] - r < domain->boxlo[d]) result += domain->boxlo[d] - (x[d] - r);
+    else if (x[d] + r > domain->boxhi[d]) result += x[d] + r - domain->boxhi[d];
+  }
+  return result;
+}
+
+/* ----------------------------------------------------------------------
+   memory usage of cell bins
+------------------------------------------------------------------------- */
+
+double NufebBins::memory_usage()
+{
+  double bytes = 0.0;
+  bytes += nbin_head * sizeof(int);
+  bytes += nbin_next * sizeof(int);
+  return bytes;
+}
@@ -0,0 +1,41 @@
+/* -*- c++ -*- ----------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   http://lammps.sandia.gov, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#ifndef LMP_NUFEB_BINS_H
+#define LMP_NUFEB_BINS_H
+
+#include "pointers.h"
+
+namespace LAMMPS_NS {
+
+// owned and ghost atoms binned into the grid cells of this proc, used to
+//   score candidate positions of new atoms by their overlap
+
+class NufebBins : protected Pointers {
+ public:
+  NufebBins(class LAMMPS *);
+  ~NufebBins();
+  void bin_atoms();
+  double overlap(int, double *, double);
+  double memory_usage();
+
+ private:
+  int *bin_head;                // first atom in each grid cell
+  int *bin_next;                // next atom in the same grid cell
+  int nbin_head, nbin_next;
+  double max_outer;             // largest outer radius of the binned atoms
+};
+
+}
+
+#endif
@@ -0,0 +1,169 @@
+/* ----------------------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   http://lammps.sandia.gov, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#include <cstring>
+#include "nufeb_memory.h"
+#include "atom.h"
+#include "comm.h"
+#include "domain.h"
+#include "error.h"
+#include "fix.h"
+#include "force.h"
+#include "grid.h"
+#include "grid_vec.h"
+#include "modify.h"
+
+using namespace LAMMPS_NS;
+
+#define MBYTES (1024.0*1024.0)
+
+/* ----------------------------------------------------------------------
+   nufeb/memory [natoms N] [procs P]
+   predict the per-proc memory of a run with N atoms on P procs from the
+   per-cell and per-atom costs of the grid, fixes and atom style defined
+   so far, assuming atoms are evenly spread over procs
+------------------------------------------------------------------------- */
+
+void NufebMemory::command(int narg, char **arg)
+{
+  if (domain->box_exist == 0)
+    error->all(FLERR,"Nufeb/memory command before simulation box is defined");
+  if (!grid->grid_exist)
+    error->all(FLERR,"Nufeb/memory command before grid_style is defined");
+
+  bigint natoms = atom->natoms;
+  int nprocs = comm->nprocs;
+
+  int iarg = 0;
+  while (iarg < narg) {
+    if (strcmp(arg[iarg],"natoms") == 0) {
+      if (iarg+2 > narg) error->all(FLERR,"Illegal nufeb/memory command");
+      natoms = force->bnumeric(FLERR,arg[iarg+1]);
+      if (natoms < 0) error->all(FLERR,"Illegal nufeb/memory command");
+      iarg += 2;
+    } else if (strcmp(arg[iarg],"procs") == 0) {
+      if (iarg+2 > narg) error->all(FLERR,"Illegal nufeb/memory command");
+      nprocs = force->inumeric(FLERR,arg[iarg+1]);
+      if (nprocs < 1) error->all(FLERR,"Illegal nufeb/memory command");
+      iarg += 2;
+    } else error->all(FLERR,"Illegal nufeb/memory command");
+  }
+
+  // allocate grid fields and per-cell fix arrays of the current run setup
+
+  lmp->init();
+  grid->setup();
+
+  // fixes storing per-atom data mostly hold fixed size pages, they are
+  //   counted as is, all other fixes scale with cells
+
+  double local[5];
+  local[0] = grid->memory_usage();
+  local[1] = grid->ncells;
+  local[2] = atom->memory_usage();
+  local[3] = atom->nmax;
+  local[4] = 0.0;
+  for (int i = 0; i < modify->nfix; i++) {
+    int peratom = 0;
+    for (int j = 0; j < atom->nextra_grow; j++)
+      if (atom->extra_grow[j] == i) peratom = 1;
+    if (peratom) local[4] += modify->fix[i]->memory_usage();
+    else local[0] += modify->fix[i]->memory_usage();
+  }
+  double all[4];
+  MPI_Allreduce(local,all,4,MPI_DOUBLE,MPI_SUM,world);
+  double cell_bytes = all[1] > 0.0 ? all[0] / all[1] : 0.0;
+  double atom_bytes = all[3] > 0.0 ? all[2] / all[3] : 0.0;
+  double fix_bytes;
+  MPI_Allreduce(&local[4],&fix_bytes,1,MPI_DOUBLE,MPI_MAX,world);
+
+  // cells of the largest sub-domain of the target proc grid
+
+  int pgrid[3];
+  proc_grid(nprocs,pgrid);
+  int sub[3];
+  double ncells = 1.0, nowned = 1.0;
+  for (int d = 0; d < 3; d++) {
+    sub[d] = (grid->box[d] + pgrid[d] - 1) / pgrid[d];
+    nowned *= sub[d];
+    ncells *= sub[d] + 2 * grid->ghost;
+  }
+
+  // halo cells are sent and received, each with its index and fields
+
+  int max_size = MAX(grid->gvec->size_forward,grid->gvec->size_exchange);
+  double halo_bytes = 2.0 * (ncells - nowned) *
+    (sizeof(int) + max_size * sizeof(double));
+  double natoms_proc = (double) natoms / nprocs;
+
+  double grid_mb = ncells * cell_bytes / MBYTES;
+  double halo_mb = halo_bytes / MBYTES;
+  double atom_mb = natoms_proc * atom_bytes / MBYTES;
+  double fix_mb = fix_bytes / MBYTES;
+
+  if (comm->me == 0) {
+    FILE *out[2] = {screen, logfile};
+    for (int f = 0; f < 2; f++) {
+      if (!out[f]) continue;
+      fprintf(out[f],"NUFEB memory estimate for " BIGINT_FORMAT
+	      " atoms on %d procs (%d x %d x %d):\n",
+	      natoms,nprocs,pgrid[0],pgrid[1],pgrid[2]);
+      fprintf(out[f],"  Cells per proc     = %d x %d x %d + %d ghost layers\n",
+	      sub[0],sub[1],sub[2],grid->ghost);
+      fprintf(out[f],"  Grid and fixes     = %.4g Mbytes (%.4g bytes/cell)\n",
+	      grid_mb,cell_bytes);
+      fprintf(out[f],"  Grid halo buffers  = %.4g Mbytes\n",halo_mb);
+      fprintf(out[f],"  Atoms              = %.4g Mbytes (%.4g bytes/atom)\n",
+	      atom_mb,atom_bytes);
+      fprintf(out[f],"  Per-atom fixes     = %.4g Mbytes\n",fix_mb);
+      fprintf(out[f],"  Total per MPI rank = %.4g Mbytes "
+	      "(excluding neighbor lists)\n",
+	      grid_mb + halo_mb + atom_mb + fix_mb);
+    }
+  }
+}
+
+/* ----------------------------------------------------------------------
+   proc grid of nprocs, the current one if nprocs is unchanged, else the
+   factorization with the fewest ghost cells, as done by processors *
+------------------------------------------------------------------------- */
+
+void NufebMemory::proc_grid(int nprocs, int *pgrid)
+{
+  if (nprocs == comm->nprocs) {
+    for (int d = 0; d < 3; d++) pgrid[d] = comm->procgrid[d];
+    return;
+  }
+
+  double best = -1.0;
+  for (int px = 1; px <= nprocs; px++) {
+    if (nprocs % px) continue;
+    for (int py = 1; py <= nprocs / px; py++) {
+      if ((nprocs / px) % py) continue;
+      int pz = nprocs / px / py;
+      if (domain->dimension == 2 && pz != 1) continue;
+      int p[3] = {px, py, pz};
+      double surf = 0.0;
+      for (int d = 0; d < 3; d++) {
+	double area = 1.0;
+	for (int e = 0; e < 3; e++)
+	  if (e != d) area *= (double) grid->box[e] / p[e];
+	surf += area;
+      }
+      if (best < 0.0 || surf < best) {
+	best = surf;
+	for (int d = 0; d < 3; d++) pgrid[d] = p[d];
+      }
+    }
+  }
+}
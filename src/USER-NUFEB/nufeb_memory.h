@@ -0,0 +1,57 @@
+/* -*- c++ -*- ----------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   http://lammps.sandia.gov, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#ifdef COMMAND_CLASS
+
+CommandStyle(nufeb/memory,NufebMemory)
+
+#else
+
+#ifndef LMP_NUFEB_MEMORY_H
+#define LMP_NUFEB_MEMORY_H
+
+#include "pointers.h"
+
+namespace LAMMPS_NS {
+
+class NufebMemory : protected Pointers {
+ public:
+  NufebMemory(class LAMMPS *lmp) : Pointers(lmp) {};
+  void command(int, char **);
+
+ private:
+  void proc_grid(int, int *);
+};
+
+}
+
+#endif
+#endif
+
+/* ERROR/WARNING messages:
+
+E: Illegal ... command
+
+Self-explanatory.  Check the input script syntax and compare to the
+documentation for the command.  You can use -echo screen as a
+command-line option when running LAMMPS to see the offending line.
+
+E: Nufeb/memory command before simulation box is defined
+
+Self-explanatory.
+
+E: Nufeb/memory command before grid_style is defined
+
+Self-explanatory.
+
+*/
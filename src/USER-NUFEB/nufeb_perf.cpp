@@ -0,0 +1,197 @@
+/* ----------------------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   http://lammps.sandia.gov, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#include <cstdio>
+#include <cstring>
+#include <mpi.h>
+#include "nufeb_perf.h"
+#include "comm.h"
+#include "error.h"
+
+#if defined(__linux__)
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#define NUFEB_PERF_EVENT
+#endif
+
+using namespace LAMMPS_NS;
+
+#define CACHELINE 64            // bytes moved by a last level cache miss
+
+static const char *phase_names[] =
+  {"Growth", "Pair", "Density", "Diffusion", "Reactor"};
+
+/* ----------------------------------------------------------------------
+   open one group of user space counters on the calling thread of each
+   proc, the counters run for the whole lifetime of the run style and
+   phases are measured from the differences of two group reads
+------------------------------------------------------------------------- */
+
+NufebPerf::NufebPerf(LAMMPS *lmp) : Pointers(lmp)
+{
+  leader = -1;
+  nopen = 0;
+  for (int e = 0; e < NEVENT; e++) {
+    fd[e] = -1;
+    index[e] = -1;
+  }
+
+#ifdef NUFEB_PERF_EVENT
+  const uint64_t config[NEVENT] = {PERF_COUNT_HW_CPU_CYCLES,
+				   PERF_COUNT_HW_INSTRUCTIONS,
+				   PERF_COUNT_HW_CACHE_MISSES};
+  for (int e = 0; e < NEVENT; e++) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = config[e];
+    attr.disabled = (leader < 0);
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP |
+      PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    fd[e] = syscall(__NR_perf_event_open, &attr, 0, -1, leader, 0);
+    if (fd[e] < 0) continue;
+    if (leader < 0) leader = fd[e];
+    index[e] = nopen++;
+  }
+  if (leader >= 0) {
+    ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  }
+#endif
+
+  int nmin;
+  MPI_Allreduce(&nopen, &nmin, 1, MPI_INT, MPI_MIN, world);
+  if (nmin == 0)
+    error->warning(FLERR, "Hardware performance counters are not available");
+  else if (nmin < NEVENT)
+    error->warning(FLERR, "Some hardware performance counters are not available");
+
+  reset();
+}
+
+/* ---------------------------------------------------------------------- */
+
+NufebPerf::~NufebPerf()
+{
+#ifdef NUFEB_PERF_EVENT
+  for (int e = 0; e < NEVENT; e++)
+    if (fd[e] >= 0) close(fd[e]);
+#endif
+}
+
+/* ---------------------------------------------------------------------- */
+
+void NufebPerf::reset()
+{
+  for (int p = 0; p < NPHASE; p++) {
+    wall[p] = 0.0;
+    calls[p] = 0.0;
+    for (int e = 0; e < NEVENT; e++)
+      count[p][e] = 0.0;
+  }
+}
+
+/* ---------------------------------------------------------------------- */
+
+void NufebPerf::start()
+{
+  tstart = MPI_Wtime();
+  read_counters(vstart);
+}
+
+/* ----------------------------------------------------------------------
+   add the counts since start() to a phase made of n sub-steps
+------------------------------------------------------------------------- */
+
+void NufebPerf::stop(int phase, int n)
+{
+  double v[NEVENT];
+  read_counters(v);
+  wall[phase] += MPI_Wtime() - tstart;
+  calls[phase] += n;
+  for (int e = 0; e < NEVENT; e++)
+    count[phase][e] += v[e] - vstart[e];
+}
+
+/* ----------------------------------------------------------------------
+   current value of each counter, scaled up if the kernel multiplexed
+   the group with other events, 0 if the counter is unavailable
+   return 1 if the counters could be read
+------------------------------------------------------------------------- */
+
+int NufebPerf::read_counters(double *v)
+{
+  for (int e = 0; e < NEVENT; e++) v[e] = 0.0;
+#ifdef NUFEB_PERF_EVENT
+  if (leader < 0) return 0;
+  uint64_t buf[3+NEVENT];
+  if (read(leader, buf, sizeof(buf)) < (ssize_t)((3+nopen)*sizeof(uint64_t)))
+    return 0;
+  double scale = buf[2] > 0 ? (double)buf[1] / buf[2] : 1.0;
+  for (int e = 0; e < NEVENT; e++)
+    if (index[e] >= 0) v[e] = scale * buf[3+index[e]];
+  return 1;
+#else
+  return 0;
+#endif
+}
+
+/* ----------------------------------------------------------------------
+   counters of each phase averaged over procs, the bandwidth is estimated
+   from the last level cache misses as one cache line per miss
+------------------------------------------------------------------------- */
+
+void NufebPerf::print()
+{
+  double sum[NPHASE*(NEVENT+2)];
+  double wmax[NPHASE];
+  int m = 0;
+  for (int p = 0; p < NPHASE; p++) {
+    sum[m++] = wall[p];
+    sum[m++] = calls[p];
+    for (int e = 0; e < NEVENT; e++)
+      sum[m++] = count[p][e];
+  }
+  MPI_Allreduce(MPI_IN_PLACE, sum, m, MPI_DOUBLE, MPI_SUM, world);
+  MPI_Allreduce(wall, wmax, NPHASE, MPI_DOUBLE, MPI_MAX, world);
+
+  if (comm->me != 0) return;
+
+  FILE *out[2] = {screen, logfile};
+  for (int f = 0; f < 2; f++) {
+    if (!out[f]) continue;
+    fprintf(out[f], "\nNUFEB phase counters (average per rank):\n\n"
+	    "Phase     |   Calls   | avg time  | max time  |  Gcycles  |  IPC  "
+	    "| LLC miss/call | est. GB/s\n"
+	    "---------------------------------------------------------------"
+	    "-------------------------------\n");
+    for (int p = 0; p < NPHASE; p++) {
+      double *s = &sum[p*(NEVENT+2)];
+      double t = s[0] / comm->nprocs;
+      double n = s[1] / comm->nprocs;
+      double cycles = s[2+CYCLES] / comm->nprocs;
+      double ipc = s[2+CYCLES] > 0.0 ? s[2+INSTRUCTIONS] / s[2+CYCLES] : 0.0;
+      double misses = s[2+LLC_MISSES] / comm->nprocs;
+      double bw = t > 0.0 ? misses * CACHELINE / t * 1.0e-9 : 0.0;
+      fprintf(out[f], "%-9s | %9.0f | %9.3g | %9.3g | %9.4g | %5.3f "
+	      "| %13.4g | %9.4g\n", phase_names[p], n, t, wmax[p],
+	      cycles * 1.0e-9, ipc, n > 0.0 ? misses / n : 0.0, bw);
+    }
+  }
+}
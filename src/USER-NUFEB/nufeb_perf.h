@@ -0,0 +1,66 @@
+/* -*- c++ -*- ----------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   http://lammps.sandia.gov, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#ifndef LMP_NUFEB_PERF_H
+#define LMP_NUFEB_PERF_H
+
+#include "pointers.h"
+
+namespace LAMMPS_NS {
+
+class NufebPerf : protected Pointers {
+ public:
+  enum {GROWTH, PAIR, DENSITY, DIFFUSION, REACTOR, NPHASE};
+  enum {CYCLES, INSTRUCTIONS, LLC_MISSES, NEVENT};
+
+  NufebPerf(class LAMMPS *);
+  ~NufebPerf();
+  void reset();
+  void start();
+  void stop(int, int);
+  void print();
+
+ private:
+  int fd[NEVENT];               // counter of each event, -1 if unavailable
+  int leader;                   // fd of the group leader, -1 if none
+  int nopen;                    // # of opened counters
+  int index[NEVENT];            // position of each event in a group read
+
+  double tstart;
+  double vstart[NEVENT];
+  double wall[NPHASE];          // wall time spent in each phase
+  double calls[NPHASE];         // # of sub-steps or iterations of each phase
+  double count[NPHASE][NEVENT];
+
+  int read_counters(double *);
+};
+
+}
+
+#endif
+
+/* ERROR/WARNING messages:
+
+W: Hardware performance counters are not available
+
+The perf_event_open system call failed, usually because
+/proc/sys/kernel/perf_event_paranoid is too restrictive or the run is
+inside a container without access to the PMU.  Only the times of
+each phase are reported.
+
+W: Some hardware performance counters are not available
+
+The CPU or kernel does not provide all counted events, those are
+reported as zero.
+
+*/
@@ -20,6 +20,7 @@
 #endif
 
 #include <cstring>
+#include <cmath>
 #include "nufeb_run.h"
 #include "neighbor.h"
 #include "domain.h"
@@ -49,6 +50,7 @@
 // NUFEB specific
 
 #include "grid.h"
+#include "grid_masks.h"
 #include "comm_grid.h"
 #include "fix_density.h"
 #include "fix_diffusion_reaction.h"
@@ -59,10 +61,88 @@
 #include "fix_reactor.h"
 #include "fix_gas_liquid.h"
 #include "fix_property.h"
+#include "fix_ph.h"
+#include "fix_ave_grid.h"
+#include "fix_checkpoint.h"
 #include "compute_volume.h"
+#include "nufeb_perf.h"
 
 using namespace LAMMPS_NS;
 
+#define MAXCHECK 256      // max # of iterations between convergence checks
+#define MAXNEWTON 20      // max # of Newton iterations of a reaction step
+#define NEWTONTOL 1e-10   // relative concentration change of Newton convergence
+#define NEWTONEPS 1e-7    // relative perturbation of the jacobian differences
+#define TUNEITER 200      // max # of iterations of a trial solve
+#define TUNEPAIR 1000     // max # of iterations of a trial relaxation
+#define TUNEGAIN 0.05     // min relative gain to replace the best candidate
+#define BUFEXTRA 1000     // extra room of the snapshot for one atom
+
+// candidate diffdt as fractions of the explicit stability limit,
+//   pairdt and skin as multiples of the input values
+static const double diff_frac[] = {0.9, 0.7, 0.5, 0.3};
+static const double pair_scale[] = {1.0, 2.0, 4.0, 0.5};
+static const double skin_scale[] = {0.5, 2.0};
+#define NDIFF (int)(sizeof(diff_frac)/sizeof(double))
+#define NPAIR (int)(sizeof(pair_scale)/sizeof(double))
+#define NSKIN (int)(sizeof(skin_scale)/sizeof(double))
+
+/* ----------------------------------------------------------------------
+   solve the dense n x n system a x = b by Gaussian elimination with
+   partial pivoting, b is overwritten by x
+------------------------------------------------------------------------- */
+
+static void solve_linear(int n, double *a, double *b)
+{
+  for (int c = 0; c < n; c++) {
+    int p = c;
+    for (int r = c+1; r < n; r++)
+      if (fabs(a[r*n+c]) > fabs(a[p*n+c])) p = r;
+    if (a[p*n+c] == 0.0) continue;
+    if (p != c) {
+      for (int k = 0; k < n; k++) {
+	double tmp = a[c*n+k];
+	a[c*n+k] = a[p*n+k];
+	a[p*n+k] = tmp;
+      }
+      double tmp = b[c];
+      b[c] = b[p];
+      b[p] = tmp;
+    }
+    for (int r = c+1; r < n; r++) {
+      double f = a[r*n+c] / a[c*n+c];
+      for (int k = c; k < n; k++) a[r*n+k] -= f * a[c*n+k];
+      b[r] -= f * b[c];
+    }
+  }
+  for (int c = n-1; c >= 0; c--) {
+    if (a[c*n+c] == 0.0) {
+      b[c] = 0.0;
+      continue;
+    }
+    for (int k = c+1; k < n; k++) b[c] -= a[c*n+k] * b[k];
+    b[c] /= a[c*n+c];
+  }
+}
+
+/* ----------------------------------------------------------------------
+   cost of a trial that took time t for n iterations, extrapolated to
+   convergence from the decay of its residual from r0 at iteration n0 to
+   r at iteration n, est is set to the estimated # of iterations
+   return -1 if the residual does not decay
+------------------------------------------------------------------------- */
+
+static double trial_cost(double t, int n, int n0, double r0, double r,
+			 double tol, double *est)
+{
+  *est = n;
+  if (r <= tol) return t;
+  if (!(r < r0) || n <= n0) return -1.0;
+  double rate = log(r / r0) / (n - n0);
+  *est = n + log(tol / r) / rate;
+  return t / n * (*est);
+}
+
 /* ---------------------------------------------------------------------- */
 
 NufebRun::NufebRun(LAMMPS *lmp, int narg, char **arg) :
@@ -76,6 +156,10 @@ NufebRun::NufebRun(LAMMPS *lmp, int narg, char **arg) :
   diffdt = 1.0;
   difftol = 1.0;
   diffmax = -1;
+  lazy_check = 0;
+  sor_flag = 0;
+  sor_omega = 0.0;
+  split_flag = 0;
   pairdt = 1.0;
   pairtol = 1.0;
   pairmax = -1;
@@ -89,8 +173,13 @@ NufebRun::NufebRun(LAMMPS *lmp, int narg, char **arg) :
   nfix_gas_liquid = 0;
   nfix_reactor = 0;
   nfix_property = 0;
+  nfix_ave_grid = 0;
+  nfix_checkpoint = 0;
   
   fix_density = NULL;
+  fix_ph = NULL;
+  fix_ave_grid = NULL;
+  fix_checkpoint = NULL;
   fix_monod = NULL;
   fix_diffusion = NULL;
   comp_pressure = NULL;
@@ -101,7 +190,30 @@ NufebRun::NufebRun(LAMMPS *lmp, int narg, char **arg) :
   fix_death = NULL;
   fix_property = NULL;
 
+  last_growth = NULL;
+  growth_active = NULL;
+
+  nsplit = 0;
+  split_c0 = NULL;
+  split_r = NULL;
+  split_jac = NULL;
+  split_done = NULL;
+
   profile = NULL;
+  perf = NULL;
+  memory_flag = 0;
+
+  autotune_flag = 0;
+  tune_saved = 0;
+  pairdt_in = skin_in = diffdt_in = 0.0;
+  tuning = 0;
+  diffmark = 0;
+  resmark = 0.0;
+  pairmark = 0;
+  pressmark = 0.0;
+  diffres = 0.0;
+  snapshot = NULL;
+  nsnapshot = 0;
   
   int iarg = 0;
   while (iarg < narg) {
@@ -114,6 +226,35 @@ NufebRun::NufebRun(LAMMPS *lmp, int narg, char **arg) :
     } else if (strcmp(arg[iarg], "diffmax") == 0) {
       diffmax = force->inumeric(FLERR, arg[iarg+1]);
       iarg += 2;
+    } else if (strcmp(arg[iarg], "diffcheck") == 0) {
+      if (strcmp(arg[iarg+1], "every") == 0) lazy_check = 0;
+      else if (strcmp(arg[iarg+1], "lazy") == 0) lazy_check = 1;
+      else {
+	error->all(FLERR, "Illegal run_style nufeb command");
+      }
+      iarg += 2;
+    } else if (strcmp(arg[iarg], "diffsolver") == 0) {
+      if (strcmp(arg[iarg+1], "dt") == 0) sor_flag = 0;
+      else if (strcmp(arg[iarg+1], "sor") == 0) sor_flag = 1;
+      else {
+	error->all(FLERR, "Illegal run_style nufeb command");
+      }
+      iarg += 2;
+    } else if (strcmp(arg[iarg], "diffomega") == 0) {
+      if (strcmp(arg[iarg+1], "auto") == 0) sor_omega = 0.0;
+      else {
+	sor_omega = force->numeric(FLERR, arg[iarg+1]);
+	if (sor_omega <= 0.0 || sor_omega >= 2.0)
+	  error->all(FLERR, "Illegal run_style nufeb command");
+      }
+      iarg += 2;
+    } else if (strcmp(arg[iarg], "diffreac") == 0) {
+      if (strcmp(arg[iarg+1], "explicit") == 0) split_flag = 0;
+      else if (strcmp(arg[iarg+1], "strang") == 0) split_flag = 1;
+      else {
+	error->all(FLERR, "Illegal run_style nufeb command");
+      }
+      iarg += 2;
     } else if (strcmp(arg[iarg], "pairdt") == 0) {
       pairdt = force->numeric(FLERR, arg[iarg+1]);
       iarg += 2;
@@ -128,6 +269,28 @@ NufebRun::NufebRun(LAMMPS *lmp, int narg, char **arg) :
       sprintf(filename, "%s_%d.log", arg[iarg+1], comm->me);
       profile = fopen(filename,"w");
       iarg += 2;
+    } else if (strcmp(arg[iarg], "perf") == 0) {
+      delete perf;
+      perf = NULL;
+      if (strcmp(arg[iarg+1], "yes") == 0) perf = new NufebPerf(lmp);
+      else if (strcmp(arg[iarg+1], "no") != 0) {
+	error->all(FLERR, "Illegal run_style nufeb command");
+      }
+      iarg += 2;
+    } else if (strcmp(arg[iarg], "memory") == 0) {
+      if (strcmp(arg[iarg+1], "yes") == 0) memory_flag = 1;
+      else if (strcmp(arg[iarg+1], "no") == 0) memory_flag = 0;
+      else {
+	error->all(FLERR, "Illegal run_style nufeb command");
+      }
+      iarg += 2;
+    } else if (strcmp(arg[iarg], "autotune") == 0) {
+      if (strcmp(arg[iarg+1], "yes") == 0) autotune_flag = 1;
+      else if (strcmp(arg[iarg+1], "no") == 0) autotune_flag = 0;
+      else {
+	error->all(FLERR, "Illegal run_style nufeb command");
+      }
+      iarg += 2;
     } else if (strcmp(arg[iarg], "screen") == 0) {
       info = force->inumeric(FLERR, arg[iarg+1]);
       iarg += 2;
@@ -150,6 +313,7 @@ NufebRun::~NufebRun()
 {
   if (profile)
     fclose(profile);
+  delete perf;
   
   delete [] fix_monod;
   delete [] fix_diffusion;
@@ -159,6 +323,15 @@ NufebRun::~NufebRun()
   delete [] fix_gas_liquid;
   delete [] fix_reactor;
   delete [] fix_property;
+  delete [] fix_ave_grid;
+  delete [] fix_checkpoint;
+  delete [] last_growth;
+  delete [] growth_active;
+  memory->destroy(split_c0);
+  memory->destroy(split_r);
+  memory->destroy(split_jac);
+  memory->destroy(split_done);
+  memory->destroy(snapshot);
 }
 
 /* ----------------------------------------------------------------------
@@ -182,6 +355,16 @@ void NufebRun::init()
   fix_density = (FixDensity *)modify->fix[modify->nfix-1];
 
   // allocate space for storing fixes
+  // init is called again by every run command
+  delete [] fix_monod;
+  delete [] fix_diffusion;
+  delete [] fix_eps_extract;
+  delete [] fix_divide;
+  delete [] fix_death;
+  delete [] fix_reactor;
+  delete [] fix_gas_liquid;
+  delete [] fix_property;
+  delete [] fix_ave_grid;
   fix_monod = new FixMonod*[modify->nfix];
   fix_diffusion = new FixDiffusionReaction*[modify->nfix];
   fix_eps_extract = new FixEPSExtract*[modify->nfix];
@@ -190,8 +373,26 @@ void NufebRun::init()
   fix_reactor = new FixReactor*[modify->nfix];
   fix_gas_liquid = new FixGasLiquid*[modify->nfix];
   fix_property = new FixProperty*[modify->nfix];
+  fix_ave_grid = new FixAveGrid*[modify->nfix];
+  delete [] fix_checkpoint;
+  fix_checkpoint = new FixCheckpoint*[modify->nfix];
+  delete [] last_growth;
+  delete [] growth_active;
+  last_growth = new bigint[modify->nfix];
+  growth_active = new int[modify->nfix];
   
   // find fixes
+  fix_ph = NULL;
+  nfix_monod = 0;
+  nfix_diffusion = 0;
+  nfix_eps_extract = 0;
+  nfix_divide = 0;
+  nfix_death = 0;
+  nfix_gas_liquid = 0;
+  nfix_reactor = 0;
+  nfix_property = 0;
+  nfix_ave_grid = 0;
+  nfix_checkpoint = 0;
   for (int i = 0; i < modify->nfix; i++) {
     if (strstr(modify->fix[i]->style, "nufeb/monod")) {
       fix_monod[nfix_monod++] = (FixMonod *)modify->fix[i];
@@ -209,9 +410,42 @@ void NufebRun::init()
       fix_gas_liquid[nfix_gas_liquid++] = (FixGasLiquid *)modify->fix[i];
     } else if (strstr(modify->fix[i]->style, "nufeb/property")) {
       fix_property[nfix_property++] = (FixProperty *)modify->fix[i];
+    } else if (strcmp(modify->fix[i]->style, "nufeb/ph") == 0) {
+      fix_ph = (FixPH *)modify->fix[i];
+    } else if (strcmp(modify->fix[i]->style, "nufeb/ave/grid") == 0) {
+      fix_ave_grid[nfix_ave_grid++] = (FixAveGrid *)modify->fix[i];
+    } else if (strcmp(modify->fix[i]->style, "nufeb/checkpoint") == 0) {
+      fix_checkpoint[nfix_checkpoint++] = (FixCheckpoint *)modify->fix[i];
     }
   }
   
+  // in-place red-black sweeps rely on a single ghost layer
+  if (sor_flag && grid->ghost > 1)
+    error->all(FLERR, "Diffsolver sor requires one grid ghost layer");
+  if (split_flag && sor_flag)
+    error->all(FLERR, "Diffreac strang requires diffsolver dt");
+  if (split_flag && grid->ghost > 1)
+    error->all(FLERR, "Diffreac strang requires one grid ghost layer");
+  // coarse substrates restrict the reactions of the cells with biomass
+  //   unless a reaction fix also acts outside them
+  int outside = nfix_gas_liquid > 0;
+  for (int i = 0; i < nfix_monod; i++)
+    if (fix_monod[i]->outside_flag) outside = 1;
+  for (int i = 0; i < nfix_diffusion; i++) {
+    fix_diffusion[i]->sor_flag = sor_flag;
+    fix_diffusion[i]->omega = sor_omega;
+    fix_diffusion[i]->split_flag = split_flag;
+    fix_diffusion[i]->active_all = outside;
+  }
+
+  // computes of a previous run are replaced
+  if (modify->find_compute("nufeb_volume") >= 0)
+    modify->delete_compute("nufeb_volume");
+  if (modify->find_compute("nufeb_pressure") >= 0)
+    modify->delete_compute("nufeb_pressure");
+  if (modify->find_compute("nufeb_ke") >= 0)
+    modify->delete_compute("nufeb_ke");
+
   // create compute volume
   char **volarg = new char*[3];
   volarg[0] = (char *)"nufeb_volume";
@@ -354,10 +588,21 @@ void NufebRun::setup(int flag)
   modify->setup(vflag);
   output->setup(flag);
   update->setupflag = 0;
+  if (perf) perf->reset();
+  if (memory_flag) {
+    for (int i = 0; i < 6; i++) mempeak[i] = 0.0;
+    memory_track();
+  }
 
   // NUFEB specific
 
   biodt = update->dt;
+
+  // slow growing groups accumulate dt from the start of the run
+  for (int i = 0; i < nfix_monod; i++) {
+    last_growth[i] = update->ntimestep;
+    growth_active[i] = 1;
+  }
   
   // disable all fixes that will be called directly
   fix_density->compute_flag = 0;
@@ -377,9 +622,42 @@ void NufebRun::setup(int flag)
     fix_gas_liquid[i]->compute_flag = 0;
   for (int i = 0; i < nfix_property; i++)
     fix_property[i]->compute_flag = 0;
+  if (fix_ph) fix_ph->compute_flag = 0;
+  for (int i = 0; i < nfix_ave_grid; i++)
+    fix_ave_grid[i]->compute_flag = 0;
+  for (int i = 0; i < nfix_checkpoint; i++)
+    fix_checkpoint[i]->compute_flag = 0;
+
+  // trial relaxations restore the atoms before densities are deposited
+  // candidates are scaled from the input values, not from the values
+  //   tuned by a previous run, so they cannot drift from run to run
+  if (autotune_flag) {
+    if (!tune_saved) {
+      pairdt_in = pairdt;
+      skin_in = neighbor->skin;
+      diffdt_in = diffdt;
+      tune_saved = 1;
+    }
+    pairdt = pairdt_in;
+    diffdt = diffdt_in;
+    if (neighbor->skin != skin_in) neighbor->reset_skin(skin_in);
+    tune_pair();
+  }
 
   // compute density
   fix_density->compute();
+  for (int i = 0; i < nfix_diffusion; i++)
+    fix_diffusion[i]->update_diffusivity();
+
+  if (autotune_flag) {
+    tune_diffusion();
+    char line[256];
+    snprintf(line, 256, "Autotune selected diffdt %g pairdt %g skin %g\n"
+	     "  reuse with: run_style nufeb diffdt %g pairdt %g ... "
+	     "and neighbor %g ...\n", diffdt, pairdt, neighbor->skin,
+	     diffdt, pairdt, neighbor->skin);
+    tune_log(line);
+  }
   
   // run diffusion until it reaches steady state
   if (init_diff_flag) {
@@ -451,6 +729,11 @@ void NufebRun::setup_minimal(int flag)
 
   modify->setup(vflag);
   update->setupflag = 0;
+  if (perf) perf->reset();
+  if (memory_flag) {
+    for (int i = 0; i < 6; i++) mempeak[i] = 0.0;
+    memory_track();
+  }
 }
 
 /* ----------------------------------------------------------------------
@@ -460,19 +743,6 @@ void NufebRun::setup_minimal(int flag)
 void NufebRun::run(int n)
 {
   bigint ntimestep;
-  int nflag,sortflag;
-
-  int n_post_integrate = modify->n_post_integrate;
-  int n_pre_exchange = modify->n_pre_exchange;
-  int n_pre_neighbor = modify->n_pre_neighbor;
-  int n_post_neighbor = modify->n_post_neighbor;
-  int n_pre_force = modify->n_pre_force;
-  int n_pre_reverse = modify->n_pre_reverse;
-  int n_post_force = modify->n_post_force;
-  int n_end_of_step = modify->n_end_of_step;
-
-  if (atom->sortfreq > 0) sortflag = 1;
-  else sortflag = 0;
 
   for (int i = 0; i < n; i++) {
     double step_start = get_time();
@@ -491,7 +761,9 @@ void NufebRun::run(int n)
 
     timer->stamp();
     double t = get_time();
+    if (perf) perf->start();
     growth();
+    if (perf) perf->stop(NufebPerf::GROWTH, 1);
     if (profile)
       fprintf(profile, "%d %e ", update->ntimestep, get_time()-t);
     
@@ -502,115 +774,10 @@ void NufebRun::run(int n)
     timer->stamp(Timer::MODIFY);
 
     t = get_time();
-    npair = 0;
-    double press = 0.0;
-    do {
-      // initial time integration
-
-      timer->stamp();
-      modify->initial_integrate(vflag);
-      if (n_post_integrate) modify->post_integrate();
-      timer->stamp(Timer::MODIFY);
-
-      // regular communication vs neighbor list rebuild
-
-      nflag = neighbor->decide();
-
-      if (nflag == 0) {
-    	timer->stamp();
-    	comm->forward_comm();
-    	timer->stamp(Timer::COMM);
-      } else {
-    	if (n_pre_exchange) {
-    	  timer->stamp();
-    	  modify->pre_exchange();
-    	  timer->stamp(Timer::MODIFY);
-    	}
-    	if (triclinic) domain->x2lamda(atom->nlocal);
-    	domain->pbc();
-    	if (domain->box_change) {
-    	  domain->reset_box();
-    	  comm->setup();
-    	  if (neighbor->style) neighbor->setup_bins();
-    	}
-    	timer->stamp();
-    	comm->exchange();
-    	if (sortflag && ntimestep >= atom->nextsort) atom->sort();
-    	comm->borders();
-    	if (triclinic) domain->lamda2x(atom->nlocal+atom->nghost);
-    	timer->stamp(Timer::COMM);
-    	if (n_pre_neighbor) {
-    	  modify->pre_neighbor();
-    	  timer->stamp(Timer::MODIFY);
-    	}
-    	neighbor->build(1);
-    	timer->stamp(Timer::NEIGH);
-    	if (n_post_neighbor) {
-    	  modify->post_neighbor();
-    	  timer->stamp(Timer::MODIFY);
-    	}
-      }
-
-      // force computations
-      // important for pair to come before bonded contributions
-      // since some bonded potentials tally pairwise energy/virial
-      // and Pair:ev_tally() needs to be called before any tallying
-
-      force_clear();
-
-      timer->stamp();
-
-      if (n_pre_force) {
-    	modify->pre_force(vflag);
-    	timer->stamp(Timer::MODIFY);
-      }
-
-      if (pair_compute_flag) {
-    	force->pair->compute(eflag,vflag);
-    	timer->stamp(Timer::PAIR);
-      }
-    
-      if (atom->molecular) {
-    	if (force->bond) force->bond->compute(eflag,vflag);
-    	if (force->angle) force->angle->compute(eflag,vflag);
-    	if (force->dihedral) force->dihedral->compute(eflag,vflag);
-    	if (force->improper) force->improper->compute(eflag,vflag);
-    	timer->stamp(Timer::BOND);
-      }
-
-      if (kspace_compute_flag) {
-    	force->kspace->compute(eflag,vflag);
-    	timer->stamp(Timer::KSPACE);
-      }
-
-      if (n_pre_reverse) {
-    	modify->pre_reverse(eflag,vflag);
-    	timer->stamp(Timer::MODIFY);
-      }
-
-      // reverse communication of forces
-
-      if (force->newton) {
-    	comm->reverse_comm();
-    	timer->stamp(Timer::COMM);
-      }
-
-      // force modifications, final time integration, diagnostics
-
-      if (n_post_force) modify->post_force(vflag);
-      modify->final_integrate();
-      if (n_end_of_step) modify->end_of_step();
-      timer->stamp(Timer::MODIFY);
-
-      ++npair;
-
-      press = comp_pressure->compute_scalar() * domain->xprd * domain->yprd * domain->zprd;
-      press += comp_ke->compute_scalar();
-      press /= 3.0 * vol;
-
-      timer->stamp(Timer::MODIFY);
-
-    } while(fabs(press) > pairtol && ((pairmax > 0) ? npair < pairmax : true));
+    if (perf) perf->start();
+    double press;
+    npair = relax(vol, press);
+    if (perf) perf->stop(NufebPerf::PAIR, npair);
     if (profile)
       fprintf(profile, "%d %e ", npair, get_time()-t);
     if (info && comm->me == 0) fprintf(screen, "pair interaction: %d steps (pressure %e N/m2)\n", npair, press);
@@ -619,19 +786,36 @@ void NufebRun::run(int n)
 
     timer->stamp();
     t = get_time();
+    if (perf) perf->start();
     fix_density->compute();
+    for (int i = 0; i < nfix_diffusion; i++)
+      fix_diffusion[i]->update_diffusivity();
+    if (perf) perf->stop(NufebPerf::DENSITY, 1);
     if (profile)
       fprintf(profile, "%e ", get_time()-t);
     timer->stamp(Timer::MODIFY);
 
     // run diffusion until it reaches steady state
     t = get_time();
+    if (perf) perf->start();
     ndiff = diffusion();
+    if (perf) perf->stop(NufebPerf::DIFFUSION, ndiff);
     if (profile)
       fprintf(profile, "%d %e\n", ndiff, get_time()-t);
     if (info && comm->me == 0) fprintf(screen, "diffusion: %d steps\n", ndiff);
     
+    if (perf) perf->start();
     reactor();
+    if (perf) perf->stop(NufebPerf::REACTOR, 1);
+
+    // sample the grid fields of this biological step
+    for (int i = 0; i < nfix_ave_grid; i++)
+      fix_ave_grid[i]->compute();
+
+    // checkpoint the relaxed state of this biological step
+    for (int i = 0; i < nfix_checkpoint; i++)
+      if (ntimestep % fix_checkpoint[i]->nevery == 0)
+	fix_checkpoint[i]->checkpoint();
 
     // all output
 
@@ -640,9 +824,148 @@ void NufebRun::run(int n)
       output->write(ntimestep);
       timer->stamp(Timer::OUTPUT);
     }
+
+    if (memory_flag) memory_track();
   }
 }
 
+/* ----------------------------------------------------------------------
+   relax the pair interactions of the grown atoms until the pressure is
+   below pairtol or pairmax iterations are done
+   press is the pressure after the last iteration
+   return the # of iterations
+------------------------------------------------------------------------- */
+
+int NufebRun::relax(double vol, double &press)
+{
+  int nflag,sortflag;
+
+  int n_post_integrate = modify->n_post_integrate;
+  int n_pre_exchange = modify->n_pre_exchange;
+  int n_pre_neighbor = modify->n_pre_neighbor;
+  int n_post_neighbor = modify->n_post_neighbor;
+  int n_pre_force = modify->n_pre_force;
+  int n_pre_reverse = modify->n_pre_reverse;
+  int n_post_force = modify->n_post_force;
+  int n_end_of_step = modify->n_end_of_step;
+
+  if (atom->sortfreq > 0) sortflag = 1;
+  else sortflag = 0;
+
+  int niter = 0;
+  press = 0.0;
+  do {
+    // initial time integration
+
+    timer->stamp();
+    modify->initial_integrate(vflag);
+    if (n_post_integrate) modify->post_integrate();
+    timer->stamp(Timer::MODIFY);
+
+    // regular communication vs neighbor list rebuild
+
+    nflag = neighbor->decide();
+
+    if (nflag == 0) {
+      timer->stamp();
+      comm->forward_comm();
+      timer->stamp(Timer::COMM);
+    } else {
+      if (n_pre_exchange) {
+	timer->stamp();
+	modify->pre_exchange();
+	timer->stamp(Timer::MODIFY);
+      }
+      if (triclinic) domain->x2lamda(atom->nlocal);
+      domain->pbc();
+      if (domain->box_change) {
+	domain->reset_box();
+	comm->setup();
+	if (neighbor->style) neighbor->setup_bins();
+      }
+      timer->stamp();
+      comm->exchange();
+      if (sortflag && update->ntimestep >= atom->nextsort) atom->sort();
+      comm->borders();
+      if (triclinic) domain->lamda2x(atom->nlocal+atom->nghost);
+      timer->stamp(Timer::COMM);
+      if (n_pre_neighbor) {
+	modify->pre_neighbor();
+	timer->stamp(Timer::MODIFY);
+      }
+      neighbor->build(1);
+      timer->stamp(Timer::NEIGH);
+      if (n_post_neighbor) {
+	modify->post_neighbor();
+	timer->stamp(Timer::MODIFY);
+      }
+    }
+
+    // force computations
+    // important for pair to come before bonded contributions
+    // since some bonded potentials tally pairwise energy/virial
+    // and Pair:ev_tally() needs to be called before any tallying
+
+    force_clear();
+
+    timer->stamp();
+
+    if (n_pre_force) {
+      modify->pre_force(vflag);
+      timer->stamp(Timer::MODIFY);
+    }
+
+    if (pair_compute_flag) {
+      force->pair->compute(eflag,vflag);
+      timer->stamp(Timer::PAIR);
+    }
+
+    if (atom->molecular) {
+      if (force->bond) force->bond->compute(eflag,vflag);
+      if (force->angle) force->angle->compute(eflag,vflag);
+      if (force->dihedral) force->dihedral->compute(eflag,vflag);
+      if (force->improper) force->improper->compute(eflag,vflag);
+      timer->stamp(Timer::BOND);
+    }
+
+    if (kspace_compute_flag) {
+      force->kspace->compute(eflag,vflag);
+      timer->stamp(Timer::KSPACE);
+    }
+
+    if (n_pre_reverse) {
+      modify->pre_reverse(eflag,vflag);
+      timer->stamp(Timer::MODIFY);
+    }
+
+    // reverse communication of forces
+
+    if (force->newton) {
+      comm->reverse_comm();
+      timer->stamp(Timer::COMM);
+    }
+
+    // force modifications, final time integration, diagnostics
+
+    if (n_post_force) modify->post_force(vflag);
+    modify->final_integrate();
+    if (n_end_of_step && !tuning) modify->end_of_step();
+    timer->stamp(Timer::MODIFY);
+
+    ++niter;
+
+    press = comp_pressure->compute_scalar() * domain->xprd * domain->yprd * domain->zprd;
+    press += comp_ke->compute_scalar();
+    press /= 3.0 * vol;
+    if (niter == pairmark) pressmark = fabs(press);
+
+    timer->stamp(Timer::MODIFY);
+
+  } while(fabs(press) > pairtol && ((pairmax > 0) ? niter < pairmax : true));
+
+  return niter;
+}
+
 /* ---------------------------------------------------------------------- */
 
 void NufebRun::reset_dt()
@@ -658,6 +981,284 @@ void NufebRun::cleanup()
   modify->post_run();
   domain->box_too_small_check();
   update->update_time();
+
+  // counters are reported just before the loop time and timer breakdown
+  if (perf) perf->print();
+  if (memory_flag) memory_print();
+}
+
+/* ----------------------------------------------------------------------
+   memory usage of reaction split and growth bookkeeping arrays
+------------------------------------------------------------------------- */
+
+bigint NufebRun::memory_usage()
+{
+  bigint bytes = 0;
+  if (last_growth) bytes += modify->nfix * (sizeof(bigint) + sizeof(int));
+  bytes += memory->usage(split_c0, nfix_diffusion, nsplit);
+  bytes += memory->usage(split_r, nfix_diffusion, nsplit);
+  bytes += memory->usage(split_jac, nfix_diffusion * nfix_diffusion, nsplit);
+  bytes += memory->usage(split_done, nsplit);
+  return bytes;
+}
+
+/* ----------------------------------------------------------------------
+   update the high-water mark of each memory category on this proc
+------------------------------------------------------------------------- */
+
+void NufebRun::memory_track()
+{
+  double bytes[6];
+  bytes[0] = atom->memory_usage();
+  bytes[1] = neighbor->memory_usage();
+  bytes[2] = grid->memory_usage();
+  bytes[3] = comm_grid->memory_usage();
+  bytes[4] = modify->memory_usage();
+  bytes[5] = comm->memory_usage() + force->memory_usage() + memory_usage();
+  for (int i = 0; i < 6; i++)
+    if (bytes[i] > mempeak[i]) mempeak[i] = bytes[i];
+}
+
+/* ----------------------------------------------------------------------
+   print min/avg/max over procs of the high-water mark of each category
+------------------------------------------------------------------------- */
+
+void NufebRun::memory_print()
+{
+  const char *names[6] = {"Atoms", "Neighbor", "Grid", "Grid comm",
+			  "Fixes", "Other"};
+  double mb[7], mbmin[7], mbavg[7], mbmax[7];
+  mb[6] = 0.0;
+  for (int i = 0; i < 6; i++) {
+    mb[i] = mempeak[i] / 1024.0 / 1024.0;
+    mb[6] += mb[i];
+  }
+  MPI_Reduce(mb, mbmin, 7, MPI_DOUBLE, MPI_MIN, 0, world);
+  MPI_Reduce(mb, mbavg, 7, MPI_DOUBLE, MPI_SUM, 0, world);
+  MPI_Reduce(mb, mbmax, 7, MPI_DOUBLE, MPI_MAX, 0, world);
+
+  if (comm->me != 0) return;
+
+  FILE *out[2] = {screen, logfile};
+  for (int f = 0; f < 2; f++) {
+    if (!out[f]) continue;
+    fprintf(out[f], "\nPer MPI rank memory high-water marks "
+	    "(min/avg/max Mbytes):\n");
+    for (int i = 0; i < 7; i++)
+      fprintf(out[f], "  %-10s = %.4g | %.4g | %.4g\n",
+	      i < 6 ? names[i] : "Total", mbmin[i], mbavg[i] / comm->nprocs,
+	      mbmax[i]);
+  }
+}
+
+/* ----------------------------------------------------------------------
+   choose pairdt, then the neighbor skin, by trial relaxations of the
+   initial configuration with the candidate values, keeping the one with
+   the lowest time per relaxation extrapolated to pairtol
+   atoms are restored after each trial, a relaxed initial configuration
+   does not tell candidates apart and keeps the input values
+------------------------------------------------------------------------- */
+
+void NufebRun::tune_pair()
+{
+  char line[256];
+  double pairdt0 = pairdt;
+  double skin0 = neighbor->skin;
+  int pairmax0 = pairmax;
+  pairmax = (pairmax > 0) ? MIN(pairmax, TUNEPAIR) : TUNEPAIR;
+  pairmark = pairmax / 2;
+
+  tuning = 1;
+  comp_pressure->addstep(update->ntimestep);
+  ev_set(update->ntimestep);
+  double vol = comp_volume->compute_scalar();
+  save_atoms();
+
+  double best = -1.0;
+  double bestdt = pairdt0;
+  double bestskin = skin0;
+  double est;
+  for (int k = 0; k < NPAIR + NSKIN; k++) {
+    double dt = (k < NPAIR) ? pairdt0 * pair_scale[k] : bestdt;
+    double skin = (k < NPAIR) ? skin0 : skin0 * skin_scale[k-NPAIR];
+    double cost = pair_trial(vol, dt, skin, &est);
+    if (k == 0 && est <= 1.0) {
+      tune_log("Autotune: initial configuration is relaxed, "
+	       "pairdt and skin are not tuned\n");
+      break;
+    }
+    if (cost < 0.0 || (pairmax0 > 0 && est > pairmax0))
+      snprintf(line, 256, "Autotune: pairdt %g skin %g does not relax\n",
+	       dt, skin);
+    else
+      snprintf(line, 256, "Autotune: pairdt %g skin %g relaxes in %.0f "
+	       "iterations, %g secs\n", dt, skin, est, cost);
+    tune_log(line);
+    if (cost < 0.0 || (pairmax0 > 0 && est > pairmax0)) continue;
+    if (best < 0.0 || cost < (1.0 - TUNEGAIN) * best) {
+      best = cost;
+      bestdt = dt;
+      bestskin = skin;
+    }
+  }
+
+  pairdt = bestdt;
+  pairmax = pairmax0;
+  pairmark = 0;
+  if (bestskin != neighbor->skin) neighbor->reset_skin(bestskin);
+  restore_atoms();
+  memory->destroy(snapshot);
+  nsnapshot = 0;
+  tuning = 0;
+}
+
+/* ----------------------------------------------------------------------
+   relax the restored atoms with pairdt dt and neighbor skin
+   return the time extrapolated to pairtol, or -1 if it does not relax
+------------------------------------------------------------------------- */
+
+double NufebRun::pair_trial(double vol, double dt, double skin, double *est)
+{
+  if (skin != neighbor->skin) neighbor->reset_skin(skin);
+  restore_atoms();
+  update->dt = dt;
+  reset_dt();
+
+  double press;
+  double t = MPI_Wtime();
+  int n = relax(vol, press);
+  t = MPI_Wtime() - t;
+  MPI_Allreduce(MPI_IN_PLACE, &t, 1, MPI_DOUBLE, MPI_MAX, world);
+
+  return trial_cost(t, n, pairmark, pressmark, fabs(press), pairtol, est);
+}
+
+/* ----------------------------------------------------------------------
+   choose diffdt by trial solves of the initial concentrations with
+   fractions of the explicit stability limit and the input value, keeping
+   the one with the lowest solve time extrapolated to difftol
+   concentrations are restored after each trial
+------------------------------------------------------------------------- */
+
+void NufebRun::tune_diffusion()
+{
+  char line[256];
+  if (nfix_diffusion == 0) return;
+  if (sor_flag) {
+    tune_log("Autotune: diffsolver sor does not use diffdt, "
+	     "diffdt is not tuned\n");
+    return;
+  }
+
+  double dtmax = 0.0;
+  for (int i = 0; i < nfix_diffusion; i++) {
+    double dt = fix_diffusion[i]->max_dt();
+    if (dt > 0.0 && (dtmax == 0.0 || dt < dtmax)) dtmax = dt;
+  }
+
+  double cand[NDIFF+1];
+  int ncand = 0;
+  cand[ncand++] = diffdt;
+  if (dtmax > 0.0) {
+    for (int k = 0; k < NDIFF; k++)
+      cand[ncand++] = diff_frac[k] * dtmax;
+  }
+
+  double **conc0;
+  memory->create(conc0, grid->nsubs, grid->ncells, "nufeb/run:conc0");
+  for (int s = 0; s < grid->nsubs; s++)
+    memcpy(conc0[s], grid->conc[s], grid->ncells * sizeof(double));
+
+  int diffmax0 = diffmax;
+  int lazy0 = lazy_check;
+  double diffdt0 = diffdt;
+  diffmax = TUNEITER;
+  diffmark = TUNEITER / 2;
+  lazy_check = 0;
+  tuning = 1;
+
+  double best = -1.0;
+  double bestdt = diffdt0;
+  for (int k = 0; k < ncand; k++) {
+    for (int s = 0; s < grid->nsubs; s++)
+      memcpy(grid->conc[s], conc0[s], grid->ncells * sizeof(double));
+    diffdt = cand[k];
+    double t = MPI_Wtime();
+    int n = diffusion();
+    t = MPI_Wtime() - t;
+    MPI_Allreduce(MPI_IN_PLACE, &t, 1, MPI_DOUBLE, MPI_MAX, world);
+
+    double est;
+    double cost = trial_cost(t, n, diffmark, resmark, diffres, difftol, &est);
+    if (cost < 0.0 || (diffmax0 > 0 && est > diffmax0))
+      snprintf(line, 256, "Autotune: diffdt %g does not converge\n", cand[k]);
+    else
+      snprintf(line, 256, "Autotune: diffdt %g converges in %.0f "
+	       "iterations, %g secs\n", cand[k], est, cost);
+    tune_log(line);
+    if (cost < 0.0 || (diffmax0 > 0 && est > diffmax0)) continue;
+    if (best < 0.0 || cost < (1.0 - TUNEGAIN) * best) {
+      best = cost;
+      bestdt = cand[k];
+    }
+  }
+
+  for (int s = 0; s < grid->nsubs; s++)
+    memcpy(grid->conc[s], conc0[s], grid->ncells * sizeof(double));
+  memory->destroy(conc0);
+
+  diffdt = bestdt;
+  diffmax = diffmax0;
+  diffmark = 0;
+  lazy_check = lazy0;
+  tuning = 0;
+}
+
+/* ----------------------------------------------------------------------
+   print a line of the autotune log to screen and logfile
+------------------------------------------------------------------------- */
+
+void NufebRun::tune_log(const char *line)
+{
+  if (comm->me != 0) return;
+  if (screen) fputs(line, screen);
+  if (logfile) fputs(line, logfile);
+}
+
+/* ----------------------------------------------------------------------
+   pack all owned atoms with their per-atom fix data, as done for
+   migration by comm->exchange()
+------------------------------------------------------------------------- */
+
+void NufebRun::save_atoms()
+{
+  int maxatom = comm->maxexchange_atom + comm->maxexchange_fix + BUFEXTRA;
+  int nmax = 0;
+  nsnapshot = 0;
+  for (int i = 0; i < atom->nlocal; i++) {
+    if (nsnapshot + maxatom > nmax) {
+      nmax = nsnapshot + atom->nlocal * maxatom / 4 + maxatom;
+      memory->grow(snapshot, nmax, "nufeb/run:snapshot");
+    }
+    nsnapshot += atom->avec->pack_exchange(i, &snapshot[nsnapshot]);
+  }
+}
+
+/* ----------------------------------------------------------------------
+   replace owned atoms by the saved ones, in their original order, and
+   rebuild ghosts, neighbor lists and forces
+------------------------------------------------------------------------- */
+
+void NufebRun::restore_atoms()
+{
+  if (atom->map_style) atom->map_clear();
+  atom->nlocal = 0;
+  atom->nghost = 0;
+  atom->avec->clear_bonus();
+  int m = 0;
+  while (m < nsnapshot)
+    m += atom->avec->unpack_exchange(&snapshot[m]);
+  setup_minimal(1);
 }
 
 /* ----------------------------------------------------------------------
@@ -728,22 +1329,46 @@ void NufebRun::growth()
     fix_monod[i]->growth_flag = 1;
   }
 
+  // atoms have not moved since the densities of the last step were
+  // deposited, so their CIC stencils can be reused by the growth gather
+
+  if (grid->wstep == update->ntimestep - 1)
+    grid->wstep = update->ntimestep;
+
   // grow atoms
+  // a monod fix with subcycle k only grows every k-th biological step,
+  // integrating its growth rates over the time elapsed since its last update
 
+  if (fix_ph) fix_ph->compute();
   for (int i = 0; i < nfix_monod; i++) {
+    bigint elapsed = update->ntimestep - last_growth[i];
+    growth_active[i] = (elapsed >= fix_monod[i]->growth_every);
+    if (!growth_active[i]) continue;
+    if (elapsed > 1) {
+      update->dt = biodt * elapsed;
+      fix_monod[i]->reset_dt();
+    }
     fix_monod[i]->compute();
+    last_growth[i] = update->ntimestep;
   }
+  update->dt = biodt;
+
+  // eps extraction, division and death of a group
+  // are skipped too while its growth is sub-cycled
 
   for (int i = 0; i < nfix_eps_extract; i++) {
-    fix_eps_extract[i]->compute();
+    if (!growth_skip(fix_eps_extract[i]->igroup))
+      fix_eps_extract[i]->compute();
   }
 
   for (int i = 0; i < nfix_divide; i++) {
-    fix_divide[i]->compute();
+    if (!growth_skip(fix_divide[i]->igroup))
+      fix_divide[i]->compute();
   }
 
   for (int i = 0; i < nfix_death; i++) {
-    fix_death[i]->compute();
+    if (!growth_skip(fix_death[i]->igroup))
+      fix_death[i]->compute();
   }
 
   for (int i = 0; i < nfix_property; i++) {
@@ -751,6 +1376,19 @@ void NufebRun::growth()
   }
 }
 
+/* ----------------------------------------------------------------------
+   return 1 if a monod fix of group igroup does not grow in this step
+------------------------------------------------------------------------- */
+
+int NufebRun::growth_skip(int igroup)
+{
+  for (int i = 0; i < nfix_monod; i++) {
+    if (fix_monod[i]->igroup == igroup && !growth_active[i])
+      return 1;
+  }
+  return 0;
+}
+
 /* ---------------------------------------------------------------------- */
 
 int NufebRun::diffusion()
@@ -765,55 +1403,280 @@ int NufebRun::diffusion()
   update->dt = diffdt;
   reset_dt();
   
+  // coarse substrates are solved on their own grid until prolongation
   for (int i = 0; i < nfix_diffusion; i++) {
     fix_diffusion[i]->closed_system_init();
+    fix_diffusion[i]->restrict_conc();
   }
 
   int niter = 0;
   bool flag;
   bool converge[nfix_diffusion];
+  // convergence check schedule of each substrate
+  int nextcheck[nfix_diffusion];
+  int interval[nfix_diffusion];
+  int lastiter[nfix_diffusion];
+  double lastres[nfix_diffusion];
+  double curres[nfix_diffusion];
   for (int i = 0; i < nfix_diffusion; i++) {
     converge[i] = false;
+    nextcheck[i] = 1;
+    interval[i] = 1;
+    lastiter[i] = 0;
+    lastres[i] = -1.0;
+    curres[i] = 0.0;
   }
   do {
-    timer->stamp();
-    comm_grid->forward_comm();
-    timer->stamp(Timer::COMM);
+    // the residual is only computed in sweeps followed by a check
+    for (int i = 0; i < nfix_diffusion; i++) {
+      fix_diffusion[i]->residual_flag = !lazy_check || niter+1 >= nextcheck[i];
+    }
+
+    if (sor_flag) {
+      // red cells read the black ones updated at the end of the last sweep
+      timer->stamp();
+      if (niter == 0) comm_grid->forward_comm();
+      else comm_grid->forward_comm_color(1);
+      timer->stamp(Timer::COMM);
+    } else {
+      // with k ghost layers, k sweeps are done per forward communication,
+      //   each one updating one halo layer less than the previous
+      int nhalo = grid->ghost - 1 - niter % grid->ghost;
+      if (nhalo == grid->ghost - 1 && !split_flag) {
+	timer->stamp();
+	comm_grid->forward_comm();
+	timer->stamp(Timer::COMM);
+      }
+      for (int i = 0; i < nfix_diffusion; i++) {
+	fix_diffusion[i]->nhalo = nhalo;
+      }
+    }
 
     flag = true;
     for (int i = 0; i < nfix_diffusion; i++) {
       if (!converge[i])
 	fix_diffusion[i]->compute_initial();
     }
-    for (int i = 0; i < nfix_monod; i++) {
-      fix_monod[i]->compute();
+    if (split_flag) {
+      // Strang splitting, half reaction steps around a pure diffusion step
+      // ghost cells are only updated after the first reaction step
+      reaction_step(0.5 * diffdt, converge, true);
+      timer->stamp(Timer::MODIFY);
+      comm_grid->forward_comm();
+      timer->stamp(Timer::COMM);
+    } else {
+      if (fix_ph) fix_ph->compute();
+      for (int i = 0; i < nfix_monod; i++) {
+	fix_monod[i]->compute();
+      }
+      for (int i = 0; i < nfix_gas_liquid; i++) {
+	fix_gas_liquid[i]->compute();
+      }
+    }
+    if (sor_flag) {
+      // red half sweep, the black one follows below
+      for (int i = 0; i < nfix_diffusion; i++) {
+	fix_diffusion[i]->color = 0;
+	if (!converge[i])
+	  fix_diffusion[i]->compute_final();
+	fix_diffusion[i]->color = 1;
+      }
+      timer->stamp(Timer::MODIFY);
+      comm_grid->forward_comm_color(0);
+      timer->stamp(Timer::COMM);
     }
-    for (int i = 0; i < nfix_gas_liquid; i++) {
-      fix_gas_liquid[i]->compute();
+    for (int i = 0; i < nfix_diffusion; i++) {
+      if (!converge[i])
+	fix_diffusion[i]->compute_final();
     }
+    if (split_flag) reaction_step(0.5 * diffdt, converge, false);
     for (int i = 0; i < nfix_diffusion; i++) {
       if (!converge[i]) {
-	fix_diffusion[i]->compute_final();
-	double res = fix_diffusion[i]->compute_scalar();
-	if (res < difftol) converge[i] = true;
+	if (fix_diffusion[i]->residual_flag) {
+	  double res = fix_diffusion[i]->compute_scalar();
+	  curres[i] = res;
+	  if (res < difftol) converge[i] = true;
+	  else if (lazy_check) {
+	    // double the interval, but do not skip beyond the iteration
+	    //   where the observed residual decay predicts convergence
+	    int it = niter + 1;
+	    int next = MIN(2 * interval[i], MAXCHECK);
+	    if (lastres[i] > 0.0 && res < lastres[i]) {
+	      double rate = log(res / lastres[i]) / (it - lastiter[i]);
+	      double est = ceil(log(difftol / res) / rate);
+	      if (est < next) next = MAX(1, static_cast<int>(est));
+	    }
+	    interval[i] = next;
+	    lastiter[i] = it;
+	    lastres[i] = res;
+	    nextcheck[i] = it + next;
+	  }
+	}
 	if (!converge[i]) flag = false;
       }
     }
     timer->stamp(Timer::MODIFY);
     ++niter;
 
+    if (niter == diffmark) {
+      resmark = 0.0;
+      for (int i = 0; i < nfix_diffusion; i++)
+	resmark = MAX(resmark, curres[i]);
+    }
+
     if (diffmax > 0 && niter >= diffmax)
       flag = true;
 
   } while (!flag);
 
+  diffres = 0.0;
+  for (int i = 0; i < nfix_diffusion; i++)
+    diffres = MAX(diffres, curres[i]);
+
   for (int i = 0; i < nfix_diffusion; i++) {
+    fix_diffusion[i]->residual_flag = 0;
     fix_diffusion[i]->closed_system_scaleup(biodt);
+    fix_diffusion[i]->prolong_conc();
   }
 
   return niter;
 }
 
+/* ----------------------------------------------------------------------
+   implicit Euler step of length h of the reactions of each cell, solved
+   by Newton iterations over the substrates of the unconverged diffusion
+   fixes, the others are kept fixed
+   the jacobian is only re-evaluated if refresh is set
+------------------------------------------------------------------------- */
+
+void NufebRun::reaction_step(double h, bool *converge, bool refresh)
+{
+  int nsub = 0;
+  int sub[nfix_diffusion];
+  for (int i = 0; i < nfix_diffusion; i++) {
+    if (!converge[i]) sub[nsub++] = fix_diffusion[i]->isub;
+  }
+  if (!nsub) return;
+
+  int ncells = grid->ncells;
+  if (ncells > nsplit) {
+    refresh = true;
+    nsplit = ncells;
+    memory->destroy(split_c0);
+    memory->destroy(split_r);
+    memory->destroy(split_jac);
+    memory->destroy(split_done);
+    memory->create(split_c0, nfix_diffusion, nsplit, "nufeb/run:split_c0");
+    memory->create(split_r, nfix_diffusion, nsplit, "nufeb/run:split_r");
+    memory->create(split_jac, nfix_diffusion * nfix_diffusion, nsplit, "nufeb/run:split_jac");
+    memory->create(split_done, nsplit, "nufeb/run:split_done");
+  }
+
+  double **conc = grid->conc;
+  double **reac = grid->reac;
+  int *mask = grid->mask;
+
+  // lower bound of the concentration scale of each substrate
+  double scale[nsub];
+  for (int k = 0; k < nsub; k++) {
+    scale[k] = 0.0;
+    for (int i = 0; i < ncells; i++) {
+      split_c0[k][i] = conc[sub[k]][i];
+      scale[k] = MAX(scale[k], fabs(conc[sub[k]][i]));
+    }
+  }
+  MPI_Allreduce(MPI_IN_PLACE, scale, nsub, MPI_DOUBLE, MPI_MAX, world);
+  for (int k = 0; k < nsub; k++)
+    scale[k] = scale[k] > 0.0 ? 1e-3 * scale[k] : 1e-3;
+  for (int i = 0; i < ncells; i++)
+    split_done[i] = mask[i] & GHOST_MASK;
+
+  // jacobian by forward differences at the initial state, reused by the
+  //   following (chord) iterations
+  // reactions only couple the substrates of a cell, so one substrate
+  //   is perturbed in all cells at once
+
+  reaction_rates();
+  for (int k = 0; k < nsub; k++)
+    for (int i = 0; i < ncells; i++)
+      split_r[k][i] = reac[sub[k]][i];
+
+  for (int j = 0; j < nsub && refresh; j++) {
+    for (int i = 0; i < ncells; i++)
+      conc[sub[j]][i] += NEWTONEPS * MAX(fabs(split_c0[j][i]), scale[j]);
+    reaction_rates();
+    for (int i = 0; i < ncells; i++)
+      conc[sub[j]][i] = split_c0[j][i];
+    for (int k = 0; k < nsub; k++) {
+      double *jac = split_jac[k*nsub+j];
+      for (int i = 0; i < ncells; i++)
+	jac[i] = (reac[sub[k]][i] - split_r[k][i]) /
+	  (NEWTONEPS * MAX(fabs(split_c0[j][i]), scale[j]));
+    }
+  }
+
+  for (int iter = 0; iter < MAXNEWTON; iter++) {
+    if (iter > 0) {
+      reaction_rates();
+      for (int k = 0; k < nsub; k++)
+	for (int i = 0; i < ncells; i++)
+	  split_r[k][i] = reac[sub[k]][i];
+    }
+
+    // solve (I - h J) dc = -(c - c0 - h r) in each owned cell,
+    //   cells stop iterating on their own so that results do not
+    //   depend on the decomposition
+    int ndone = 0;
+    double a[nsub*nsub];
+    double b[nsub];
+    for (int i = 0; i < ncells; i++) {
+      if (split_done[i]) {
+	ndone++;
+	continue;
+      }
+      for (int k = 0; k < nsub; k++) {
+	b[k] = split_c0[k][i] - conc[sub[k]][i] + h * split_r[k][i];
+	for (int j = 0; j < nsub; j++)
+	  a[k*nsub+j] = (k == j ? 1.0 : 0.0) - h * split_jac[k*nsub+j][i];
+      }
+      solve_linear(nsub, a, b);
+      double change = 0.0;
+      for (int k = 0; k < nsub; k++) {
+	double c = conc[sub[k]][i];
+	double cnew = MAX(0.0, c + b[k]);
+	if (cnew != c)
+	  change = MAX(change, fabs(cnew - c) / MAX(cnew, scale[k]));
+	conc[sub[k]][i] = cnew;
+      }
+      if (change < NEWTONTOL) split_done[i] = 1;
+    }
+    if (ndone == ncells) break;
+  }
+
+  // reactions are accounted for, the diffusion step must not add them again
+  for (int k = 0; k < grid->nsubs; k++)
+    for (int i = 0; i < ncells; i++)
+      reac[k][i] = 0.0;
+}
+
+/* ----------------------------------------------------------------------
+   reaction rates of all substrates at the current concentrations
+------------------------------------------------------------------------- */
+
+void NufebRun::reaction_rates()
+{
+  for (int k = 0; k < grid->nsubs; k++)
+    for (int i = 0; i < grid->ncells; i++)
+      grid->reac[k][i] = 0.0;
+  if (fix_ph) fix_ph->compute();
+  for (int i = 0; i < nfix_monod; i++) {
+    fix_monod[i]->compute();
+  }
+  for (int i = 0; i < nfix_gas_liquid; i++) {
+    fix_gas_liquid[i]->compute();
+  }
+}
+
 /* ---------------------------------------------------------------------- */
 
 void NufebRun::reactor()
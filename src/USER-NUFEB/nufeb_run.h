@@ -37,6 +37,7 @@ class NufebRun : public Integrate {
   virtual void run(int);
   virtual void reset_dt();
   virtual void cleanup();
+  virtual bigint memory_usage();
 
  protected:
   bool init_diff_flag;
@@ -49,6 +50,10 @@ class NufebRun : public Integrate {
   double diffdt;
   double difftol;
   int diffmax;
+  int lazy_check;                   // 1 to adapt the convergence check interval
+  int sor_flag;                     // 1 for red-black SOR instead of dt stepping
+  double sor_omega;                 // SOR relaxation factor, <= 0 for automatic
+  int split_flag;                   // 1 for Strang split implicit reactions
   double pairdt;
   double pairtol;
   int pairmax;
@@ -62,6 +67,8 @@ class NufebRun : public Integrate {
   int nfix_gas_liquid;
   int nfix_reactor;
   int nfix_property;
+  int nfix_ave_grid;
+  int nfix_checkpoint;
   
   class FixDensity *fix_density;
   class FixMonod **fix_monod;
@@ -75,13 +82,53 @@ class NufebRun : public Integrate {
   class FixGasLiquid **fix_gas_liquid;
   class FixReactor **fix_reactor;
   class FixProperty **fix_property;
+  class FixPH *fix_ph;
+  class FixAveGrid **fix_ave_grid;
+  class FixCheckpoint **fix_checkpoint;
+
+  bigint *last_growth;              // last bio step each monod fix has grown
+  int *growth_active;               // 1 if monod fix grows in current step
+
+  int nsplit;                       // # of cells of the split work arrays
+  double **split_c0;                // concentrations before the reaction step
+  double **split_r;                 // reaction rates of the Newton iterate
+  double **split_jac;               // reaction jacobian of each cell
+  int *split_done;                  // 1 if the Newton iterations of a cell converged
 
   FILE *profile;
+  class NufebPerf *perf;            // hardware counters of each phase, or NULL
+  int memory_flag;                  // 1 to track memory high-water marks
+  double mempeak[6];                // peak bytes of each memory category
+
+  int autotune_flag;                // 1 to tune diffdt, pairdt and skin at setup
+  int tuning;                       // 1 while trial solves are run
+  int tune_saved;                   // 1 once the input values are saved
+  double pairdt_in, skin_in;        // input values every tuning starts from
+  double diffdt_in;
+  int diffmark;                     // iteration whose residual is kept, 0 if none
+  double resmark;                   // max residual at iteration diffmark
+  double diffres;                   // max residual at the last iteration
+  int pairmark;                     // relaxation iteration whose pressure is kept
+  double pressmark;                 // pressure at iteration pairmark
+  double *snapshot;                 // packed owned atoms before trial relaxations
+  int nsnapshot;                    // # of datums in snapshot
   
   virtual void growth();
   virtual void reactor();
+  int growth_skip(int);
   virtual int diffusion();
+  virtual int relax(double, double &);
+  virtual void reaction_step(double, bool *, bool);
+  void reaction_rates();
   double get_time();
+  void memory_track();
+  void memory_print();
+  void tune_pair();
+  double pair_trial(double, double, double, double *);
+  void tune_diffusion();
+  void tune_log(const char *);
+  void save_atoms();
+  void restore_atoms();
 };
 
 }
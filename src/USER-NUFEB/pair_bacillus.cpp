@@ -72,115 +72,126 @@ PairBacillus::~PairBacillus()
 
 void PairBacillus::compute(int eflag, int vflag)
 {
-  int i,j,ii,jj,inum,jnum,itype,jtype;
+  ev_init(eflag,vflag);
+
+  // loop over neighbors of my atoms
+
+  for (int ii = 0; ii < list->inum; ii++)
+    compute_atom(ii, atom->f, atom->torque);
+
+  if (vflag_fdotr) virial_fdotr_compute();
+}
+
+/* ----------------------------------------------------------------------
+   interactions of the ii-th atom in the neighbor list with its neighbors,
+   forces and torques are accumulated into f and torque
+------------------------------------------------------------------------- */
+
+void PairBacillus::compute_atom(int ii, double **f, double **torque)
+{
+  int i,j,jj,jnum,itype,jtype;
   double rsq, leni, lenj, radi, radj;
   int ishape, jshape;
   double xtmp,ytmp,ztmp,delx,dely,delz, evdwl, facc[3];
-  int *ilist,*jlist,*numneigh,**firstneigh;
-
-  evdwl = 0.0;
-  ev_init(eflag,vflag);
+  int *jlist;
 
   double **x = atom->x;
   double **v = atom->v;
-  double **f = atom->f;
-  double **torque = atom->torque;
   double **angmom = atom->angmom;
   int *bacillus = atom->bacillus;
   int *type = atom->type;
   int nlocal = atom->nlocal;
-  int nall = nlocal + atom->nghost;
   int newton_pair = force->newton_pair;
 
   AtomVecBacillus::Bonus *ibonus;
   AtomVecBacillus::Bonus *jbonus;
 
-  inum = list->inum;
-  ilist = list->ilist;
-  numneigh = list->numneigh;
-  firstneigh = list->firstneigh;
-
-  // loop over neighbors of my atoms
-
-  for (ii = 0; ii < inum; ii++) {
-    i = ilist[ii];
-    xtmp = x[i][0];
-    ytmp = x[i][1];
-    ztmp = x[i][2];
-    itype = type[i];
-    jlist = firstneigh[i];
-    jnum = numneigh[i];
-
-    if (bacillus[i] >= 0) {
-      int index = atom->bacillus[i];
-      ibonus = &avec->bonus[index];
-      leni = ibonus->length/2;
-      radi = ibonus->diameter/2;
-      leni == 0 ? ishape = SPHERE:ishape = ROD;
-    }
-
-    for (jj = 0; jj < jnum; jj++) {
-      j = jlist[jj];
-      j &= NEIGHMASK;
+  i = list->ilist[ii];
+  xtmp = x[i][0];
+  ytmp = x[i][1];
+  ztmp = x[i][2];
+  itype = type[i];
+  jlist = list->firstneigh[i];
+  jnum = list->numneigh[i];
+
+  if (bacillus[i] >= 0) {
+    int index = atom->bacillus[i];
+    ibonus = &avec->bonus[index];
+    leni = ibonus->length/2;
+    radi = ibonus->diameter/2;
+    leni == 0 ? ishape = SPHERE:ishape = ROD;
+  }
 
-      delx = xtmp - x[j][0];
-      dely = ytmp - x[j][1];
-      delz = ztmp - x[j][2];
-      rsq = delx*delx + dely*dely + delz*delz;
-      jtype = type[j];
+  for (jj = 0; jj < jnum; jj++) {
+    j = jlist[jj];
+    j &= NEIGHMASK;
 
-      evdwl = 0.0;
-      facc[0] = facc[1] = facc[2] = 0;
+    delx = xtmp - x[j][0];
+    dely = ytmp - x[j][1];
+    delz = ztmp - x[j][2];
+    rsq = delx*delx + dely*dely + delz*delz;
+    jtype = type[j];
 
-      if (bacillus[i] < 0 || bacillus[j] < 0) continue;
+    evdwl = 0.0;
+    facc[0] = facc[1] = facc[2] = 0;
 
-      int index = atom->bacillus[j];
-      jbonus = &avec->bonus[index];
-      lenj = jbonus->length/2;
-      radj = jbonus->diameter/2;
-      lenj == 0 ? jshape = SPHERE:jshape = ROD;
+    if (bacillus[i] < 0 || bacillus[j] < 0) continue;
 
-      // no interaction
-      double r = sqrt(rsq);
-      if (r > radi+radj+leni+lenj+cutoff) continue;
+    int index = atom->bacillus[j];
+    jbonus = &avec->bonus[index];
+    lenj = jbonus->length/2;
+    radj = jbonus->diameter/2;
+    lenj == 0 ? jshape = SPHERE:jshape = ROD;
 
-      // sphere-sphere interaction
+    // no interaction
+    double r = sqrt(rsq);
+    if (r > radi+radj+leni+lenj+cutoff) continue;
 
-      if (ishape == SPHERE && jshape == SPHERE) {
-        sphere_against_sphere(i, j, itype, jtype, delx, dely, delz,
-                              rsq, v, f, radi, radj, evflag);
-        continue;
-      }
+    // sphere-sphere interaction
 
-      // one of the two bacillus is a sphere
-      if (jshape == SPHERE) {
-        sphere_against_rod(i, j, itype, jtype, x, v, f, torque,
-                            angmom, ibonus, evflag);
-        continue;
-      } else if (ishape == SPHERE) {
-        sphere_against_rod(j, i, jtype, itype, x, v, f, torque,
-                            angmom, jbonus, evflag);
-        continue;
-      }
+    if (ishape == SPHERE && jshape == SPHERE) {
+      sphere_against_sphere(i, j, itype, jtype, delx, dely, delz,
+                            rsq, v, f, radi, radj, evflag);
+      continue;
+    }
 
-      int contact = 0;
-      Contact contact_list;
+    // one of the two bacillus is a sphere
+    if (jshape == SPHERE) {
+      sphere_against_rod(i, j, itype, jtype, x, v, f, torque,
+                          angmom, ibonus, evflag);
+      continue;
+    } else if (ishape == SPHERE) {
+      sphere_against_rod(j, i, jtype, itype, x, v, f, torque,
+                          angmom, jbonus, evflag);
+      continue;
+    }
 
-      // rod-rod interaction
-      rod_against_rod(i, j, itype, jtype, x, v, f, torque, angmom, ibonus,
-		      jbonus, contact, contact_list, evdwl, facc);
+    int contact = 0;
+    Contact contact_list;
 
-      if (contact > 0) {
-        rescale_cohesive_forces(x, f, torque, contact_list, contact,
-                                itype, jtype, facc);
-      }
+    // rod-rod interaction
+    rod_against_rod(i, j, itype, jtype, x, v, f, torque, angmom, ibonus,
+                    jbonus, contact, contact_list, evdwl, facc);
 
-      if (evflag) ev_tally_xyz(i,j,nlocal,newton_pair,evdwl,0.0,
-                               facc[0],facc[1],facc[2],delx,dely,delz);
+    if (contact > 0) {
+      rescale_cohesive_forces(x, f, torque, contact_list, contact,
+                              itype, jtype, facc);
     }
+
+    if (evflag) tally_xyz(i,j,nlocal,newton_pair,evdwl,
+                          facc[0],facc[1],facc[2],delx,dely,delz);
   }
+}
 
-  if (vflag_fdotr) virial_fdotr_compute();
+/* ----------------------------------------------------------------------
+   tally energy and virial of one pair
+------------------------------------------------------------------------- */
+
+void PairBacillus::tally_xyz(int i, int j, int nlocal, int newton_pair,
+                             double evdwl, double fx, double fy, double fz,
+                             double delx, double dely, double delz)
+{
+  ev_tally_xyz(i,j,nlocal,newton_pair,evdwl,0.0,fx,fy,fz,delx,dely,delz);
 }
 
 /* ----------------------------------------------------------------------
@@ -421,8 +432,8 @@ void PairBacillus::sphere_against_sphere(int i, int j,
     f[j][2] -= fz;
   }
 
-  if (evflag) ev_tally_xyz(i,j,nlocal,newton_pair,
-                           energy,0.0,fx,fy,fz,delx,dely,delz);
+  if (evflag) tally_xyz(i,j,nlocal,newton_pair,
+                        energy,fx,fy,fz,delx,dely,delz);
 }
 
 /* ----------------------------------------------------------------------
@@ -527,8 +538,8 @@ void PairBacillus::sphere_against_rod(int i, int j,
     f[j][2] -= fz;
   }
 
-  if (evflag) ev_tally_xyz(i,j,nlocal,newton_pair,
-                         energy,0.0,fx,fy,fz,delx,dely,delz);
+  if (evflag) tally_xyz(i,j,nlocal,newton_pair,
+                        energy,fx,fy,fz,delx,dely,delz);
 }
 
 /* ----------------------------------------------------------------------
@@ -62,6 +62,14 @@ class PairBacillus : public Pair {
 
   void allocate();
 
+  // interactions of one atom with its neighbors
+  void compute_atom(int ii, double **f, double **torque);
+
+  // energy and virial of one pair
+  virtual void tally_xyz(int i, int j, int nlocal, int newton_pair,
+                         double evdwl, double fx, double fy, double fz,
+                         double delx, double dely, double delz);
+
   // sphere-sphere interaction
   void sphere_against_sphere(int ibody, int jbody, int itype, int jtype,
                              double delx, double dely, double delz, double rsq,
@@ -0,0 +1,87 @@
+/* ----------------------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   http://lammps.sandia.gov, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   This software is distributed under the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#include "pair_bacillus_omp.h"
+#include "atom.h"
+#include "comm.h"
+#include "neigh_list.h"
+
+#include "suffix.h"
+using namespace LAMMPS_NS;
+
+/* ---------------------------------------------------------------------- */
+
+PairBacillusOMP::PairBacillusOMP(LAMMPS *lmp) :
+  PairBacillus(lmp), ThrOMP(lmp, THR_PAIR)
+{
+  suffix_flag |= Suffix::OMP;
+  respa_enable = 0;
+}
+
+/* ---------------------------------------------------------------------- */
+
+void PairBacillusOMP::compute(int eflag, int vflag)
+{
+  ev_init(eflag,vflag);
+
+  const int nall = atom->nlocal + atom->nghost;
+  const int nthreads = comm->nthreads;
+  const int inum = list->inum;
+
+  // each thread accumulates forces and torques of its share of the
+  //   neighbor list into private arrays which are reduced at the end,
+  //   the rod contact helpers only write through the arrays passed in
+
+#if defined(_OPENMP)
+#pragma omp parallel default(none) shared(eflag,vflag)
+#endif
+  {
+    int ifrom, ito, tid;
+
+    loop_setup_thr(ifrom, ito, tid, inum, nthreads);
+    ThrData *thr = fix->get_thr(tid);
+    thr->timer(Timer::START);
+    ev_setup_thr(eflag, vflag, nall, eatom, vatom, thr);
+
+    double **f = thr->get_f();
+    double **torque = thr->get_torque();
+    for (int ii = ifrom; ii < ito; ++ii)
+      compute_atom(ii, f, torque);
+
+    thr->timer(Timer::PAIR);
+    reduce_thr(this, eflag, vflag, thr);
+  } // end of omp parallel region
+}
+
+/* ----------------------------------------------------------------------
+   tally into the accumulators of the calling thread
+------------------------------------------------------------------------- */
+
+void PairBacillusOMP::tally_xyz(int i, int j, int nlocal, int newton_pair,
+                                double evdwl, double fx, double fy, double fz,
+                                double delx, double dely, double delz)
+{
+  int tid = 0;
+#if defined(_OPENMP)
+  tid = omp_get_thread_num();
+#endif
+  ev_tally_xyz_thr(this,i,j,nlocal,newton_pair,evdwl,0.0,
+                   fx,fy,fz,delx,dely,delz,fix->get_thr(tid));
+}
+
+/* ---------------------------------------------------------------------- */
+
+double PairBacillusOMP::memory_usage()
+{
+  double bytes = memory_usage_thr();
+  bytes += PairBacillus::memory_usage();
+
+  return bytes;
+}
@@ -0,0 +1,44 @@
+/* -*- c++ -*- ----------------------------------------------------------
+   LAMMPS - Large-scale Atomic/Molecular Massively Parallel Simulator
+   http://lammps.sandia.gov, Sandia National Laboratories
+   Steve Plimpton, sjplimp@sandia.gov
+
+   Copyright (2003) Sandia Corporation.  Under the terms of Contract
+   DE-AC04-94AL85000 with Sandia Corporation, the U.S. Government retains
+   certain rights in this software.  This software is distributed under
+   the GNU General Public License.
+
+   See the README file in the top-level LAMMPS directory.
+------------------------------------------------------------------------- */
+
+#ifdef PAIR_CLASS
+
+PairStyle(bacillus/omp,PairBacillusOMP)
+
+#else
+
+#ifndef LMP_PAIR_BACILLUS_OMP_H
+#define LMP_PAIR_BACILLUS_OMP_H
+
+#include "pair_bacillus.h"
+#include "thr_omp.h"
+
+namespace LAMMPS_NS {
+
+class PairBacillusOMP : public PairBacillus, public ThrOMP {
+
+ public:
+  PairBacillusOMP(class LAMMPS *);
+
+  virtual void compute(int, int);
+  virtual double memory_usage();
+
+ protected:
+  virtual void tally_xyz(int, int, int, int, double, double, double,
+                         double, double, double, double);
+};
+
+}
+
+#endif
+#endif
@@ -21,6 +21,7 @@
 #include "grid_masks.h"
 #include "domain.h"
 #include "group.h"
+#include "fix.h"
 
 #include <vtkCellData.h>
 #include <vtkDataArray.h>
@@ -35,6 +36,7 @@ using namespace LAMMPS_NS;
 DumpGridVTK::DumpGridVTK(LAMMPS *lmp, int narg, char **arg) : Dump(lmp, narg, arg)
 {
   filewriter = 0;
+  fix_ave = NULL;
   parse_fields(narg, arg);
 }
 
@@ -55,17 +57,28 @@ void DumpGridVTK::init_style() {
       packs.push_back(std::bind(&DumpGridVTK::pack_density, this, _1));
     } else if (*it == "gro") {
       packs.push_back(std::bind(&DumpGridVTK::pack_growth, this, _1));
+    } else if (*it == "ave") {
+      int ifix = modify->find_fix(ave_id.c_str());
+      if (ifix < 0)
+	error->all(FLERR, "Could not find dump grid/vtk fix ID");
+      if (strcmp(modify->fix[ifix]->style, "nufeb/ave/grid") != 0)
+	error->all(FLERR, "Dump grid/vtk ave requires fix nufeb/ave/grid");
+      fix_ave = modify->fix[ifix];
+      packs.push_back(std::bind(&DumpGridVTK::pack_average, this, _1));
     }
   }
 }
 
 void DumpGridVTK::write() {
   vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
-  image->SetDimensions(grid->subbox[0] - 1, grid->subbox[1] - 1, grid->subbox[2] - 1);
+  int nghost = grid->ghost;
+  image->SetDimensions(grid->subbox[0] - 2 * nghost + 1,
+		       grid->subbox[1] - 2 * nghost + 1,
+		       grid->subbox[2] - 2 * nghost + 1);
   image->SetSpacing(grid->cell_size, grid->cell_size, grid->cell_size);
   double origin[3];
   for (int i = 0; i < 3; i++)
-    origin[i] = grid->cell_size * (grid->sublo[i] + 1) - domain->boxlo[i];
+    origin[i] = grid->cell_size * (grid->sublo[i] + nghost) - domain->boxlo[i];
   image->SetOrigin(origin[0], origin[1], origin[2]);
 
   for (auto it = packs.begin(); it != packs.end(); ++it) {
@@ -104,6 +117,11 @@ int DumpGridVTK::parse_fields(int narg, char **arg) {
       fields.push_back(arg[iarg]);
     } else if (strcmp(arg[iarg], "gro") == 0) {
       fields.push_back(arg[iarg]);
+    } else if (strcmp(arg[iarg], "ave") == 0) {
+      if (iarg+1 >= narg)
+	error->all(FLERR, "Illegal dump grid/vtk command");
+      fields.push_back(arg[iarg]);
+      ave_id = arg[++iarg];
     }
   }
   return i;
@@ -125,6 +143,34 @@ void DumpGridVTK::pack_growth(vtkSmartPointer<vtkImageData> image) {
   pack_tuple<2>(image, "growth", grid->growth, group->names, group->ngroup);
 }
 
+void DumpGridVTK::pack_average(vtkSmartPointer<vtkImageData> image) {
+  int dim;
+  int ncomp = *(int *)fix_ave->extract("ncomp", dim);
+  int nsample = *(int *)fix_ave->extract("nsample", dim);
+  char **cname = (char **)fix_ave->extract("cname", dim);
+  double **mean = (double **)fix_ave->extract("mean", dim);
+  double **m2 = (double **)fix_ave->extract("m2", dim);
+  double **vmin = (double **)fix_ave->extract("min", dim);
+  double **vmax = (double **)fix_ave->extract("max", dim);
+
+  for (int k = 0; k < ncomp; k++) {
+    std::string name(cname[k]);
+    pack_tuple1(image, (name + " mean").c_str(), mean[k]);
+    if (m2) {
+      vtkSmartPointer<vtkDoubleArray> array = vtkSmartPointer<vtkDoubleArray>::New();
+      array->SetName((name + " variance").c_str());
+      array->SetNumberOfComponents(1);
+      for (int i = 0; i < grid->ncells; i++) {
+	if (!(grid->mask[i] & GHOST_MASK))
+	  array->InsertNextTuple1(nsample ? m2[k][i] / nsample : 0.0);
+      }
+      image->GetCellData()->AddArray(array);
+    }
+    if (vmin) pack_tuple1(image, (name + " min").c_str(), vmin[k]);
+    if (vmax) pack_tuple1(image, (name + " max").c_str(), vmax[k]);
+  }
+}
+
 void DumpGridVTK::pack_tuple1(vtkSmartPointer<vtkImageData> image, const char *name, double *data) {
   vtkSmartPointer<vtkDoubleArray> array = vtkSmartPointer<vtkDoubleArray>::New();
   array->SetName(name);
@@ -45,12 +45,15 @@ class DumpGridVTK : public Dump {
   void pack_reaction(vtkSmartPointer<vtkImageData>);
   void pack_density(vtkSmartPointer<vtkImageData>);
   void pack_growth(vtkSmartPointer<vtkImageData>);
+  void pack_average(vtkSmartPointer<vtkImageData>);
   void pack_tuple1(vtkSmartPointer<vtkImageData>, const char *, double *);
   void pack_tuple1(vtkSmartPointer<vtkImageData>, const char *, double **, char **, int);
   template <int>
   void pack_tuple(vtkSmartPointer<vtkImageData>, const char *, double ***, char **, int);
 
   std::vector<std::string> fields;
+  std::string ave_id;                   // id of fix nufeb/ave/grid
+  class Fix *fix_ave;
   std::vector<std::function<void(vtkSmartPointer<vtkImageData>)> > packs;
 };
 }
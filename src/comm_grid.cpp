@@ -12,6 +12,7 @@
 ------------------------------------------------------------------------- */
 
 #include <cstring>
+#include <cstdlib>
 #include "comm_grid.h"
 #include "grid.h"
 #include "grid_vec.h"
@@ -41,6 +42,8 @@ CommGrid::CommGrid(LAMMPS *lmp) : Pointers(lmp)
   recv_end = NULL;
   send_begin = NULL;
   send_end = NULL;
+  recv_mid = NULL;
+  send_mid = NULL;
   recv_cells = NULL;
   send_cells = NULL;
   buf_recv = NULL;
@@ -50,9 +53,25 @@ CommGrid::CommGrid(LAMMPS *lmp) : Pointers(lmp)
   nsend_self = 0;
   recv_cells_self = NULL;
   send_cells_self = NULL;
+  nself_mid = 0;
   buf_self = NULL;
   
   requests = NULL;
+
+  node = MPI_COMM_NULL;
+  node_rank = NULL;
+  win = MPI_WIN_NULL;
+  buf_shm = NULL;
+  shm_half = 0;
+  nshm = 0;
+  send_shm = NULL;
+  recv_shm = NULL;
+  send_shm_begin = NULL;
+  send_shm_mid = NULL;
+  recv_shm_begin = NULL;
+  recv_shm_mid = NULL;
+  recv_shm_size = NULL;
+  recv_shm_buf = NULL;
 }
 
 /* ---------------------------------------------------------------------- */
@@ -65,6 +84,8 @@ CommGrid::~CommGrid()
   memory->destroy(recv_end);
   memory->destroy(send_begin);
   memory->destroy(send_end);
+  memory->destroy(recv_mid);
+  memory->destroy(send_mid);
   memory->destroy(recv_cells);
   memory->destroy(send_cells);
   memory->destroy(buf_recv);
@@ -74,6 +95,18 @@ CommGrid::~CommGrid()
   memory->destroy(buf_self);
   
   delete [] requests;
+
+  free_shared();
+  memory->destroy(node_rank);
+  memory->destroy(send_shm);
+  memory->destroy(recv_shm);
+  memory->destroy(send_shm_begin);
+  memory->destroy(send_shm_mid);
+  memory->destroy(recv_shm_begin);
+  memory->destroy(recv_shm_mid);
+  memory->destroy(recv_shm_size);
+  delete [] recv_shm_buf;
+  if (node != MPI_COMM_NULL) MPI_Comm_free(&node);
 }
 
 /* ---------------------------------------------------------------------- */
@@ -90,6 +123,34 @@ void CommGrid::init()
   recv_end = memory->create(recv_end, comm->nprocs, "comm_grid:recv_end");
   send_begin = memory->create(send_begin, comm->nprocs, "comm_grid:send_begin");
   send_end = memory->create(send_end, comm->nprocs, "comm_grid:send_end");
+  recv_mid = memory->create(recv_mid, comm->nprocs, "comm_grid:recv_mid");
+  send_mid = memory->create(send_mid, comm->nprocs, "comm_grid:send_mid");
+
+  // rank of every proc in my shared memory node, split only once
+  if (grid->shared_comm && node == MPI_COMM_NULL) {
+    MPI_Comm_split_type(world, MPI_COMM_TYPE_SHARED, comm->me,
+			MPI_INFO_NULL, &node);
+    MPI_Group world_group, node_group;
+    MPI_Comm_group(world, &world_group);
+    MPI_Comm_group(node, &node_group);
+    int *ranks = memory->create(ranks, comm->nprocs, "comm_grid:ranks");
+    for (int p = 0; p < comm->nprocs; p++) ranks[p] = p;
+    node_rank = memory->create(node_rank, comm->nprocs, "comm_grid:node_rank");
+    MPI_Group_translate_ranks(world_group, comm->nprocs, ranks,
+			      node_group, node_rank);
+    MPI_Group_free(&world_group);
+    MPI_Group_free(&node_group);
+    memory->destroy(ranks);
+
+    send_shm = memory->create(send_shm, comm->nprocs, "comm_grid:send_shm");
+    recv_shm = memory->create(recv_shm, comm->nprocs, "comm_grid:recv_shm");
+    send_shm_begin = memory->create(send_shm_begin, comm->nprocs, "comm_grid:send_shm_begin");
+    send_shm_mid = memory->create(send_shm_mid, comm->nprocs, "comm_grid:send_shm_mid");
+    recv_shm_begin = memory->create(recv_shm_begin, comm->nprocs, "comm_grid:recv_shm_begin");
+    recv_shm_mid = memory->create(recv_shm_mid, comm->nprocs, "comm_grid:recv_shm_mid");
+    recv_shm_size = memory->create(recv_shm_size, comm->nprocs, "comm_grid:recv_shm_size");
+    recv_shm_buf = new double*[comm->nprocs];
+  }
 }
 
 /* ---------------------------------------------------------------------- */
@@ -115,234 +176,53 @@ void CommGrid::setup()
   int lo[3];
   int hi[3];
   for (int p = 0; p < comm->nprocs; p++) {
-    if (comm->me != p) {
-      int n = intersect(grid->sublo, grid->subhi, &boxlo[3*p], &boxhi[3*p],
-			0, -1, 0, 0, 0, lo, hi, false);
-      if (n > 0) {
-	recvproc[nrecvproc] = p;
-	recv_begin[nrecvproc] = nrecv;
-	nrecv += n;
-	recv_end[nrecvproc++] = nrecv;
-	recvlist.add(p, lo, hi, n);
-      }
-      n = intersect(grid->sublo, grid->subhi, &boxlo[3*p], &boxhi[3*p],
-		    -1, 0, 0, 0, 0, lo, hi, false);
-      if (n > 0) {
-	sendproc[nsendproc] = p;
-	send_begin[nsendproc] = nsend;
-	nsend += n;
-	send_end[nsendproc++] = nsend;
-	sendlist.add(p, lo, hi, n);
-      }
-    }
-    if (grid->periodic[0]) {
-      int n = intersect(grid->sublo, grid->subhi, &boxlo[3*p], &boxhi[3*p],
-			0, -1, -grid->box[0], 0, 0, lo, hi, false);
-      if (n > 0) {
-	if (comm->me != p) {
-	  if (nrecvproc > 0 && recvproc[nrecvproc-1] == p) {
-	    recv_end[nrecvproc-1] += n;
-	  } else {
-	    recvproc[nrecvproc] = p;
-	    recv_begin[nrecvproc] = nrecv;
-	    recv_end[nrecvproc++] = nrecv + n;
-	  }
-	  nrecv += n;
-	} else {
-	  nrecv_self += n;
-	}
-	recvlist.add(p, lo, hi, n);
-      }
-      n = intersect(grid->sublo, grid->subhi, &boxlo[3*p], &boxhi[3*p],
-		    -1, 0, grid->box[0], 0, 0, lo, hi, false);
-      if (n > 0) {
-	if (comm->me != p) {
-	  if (nsendproc > 0 && sendproc[nsendproc-1] == p) {
-	    send_end[nsendproc-1] += n;
-	  } else {
-	    sendproc[nsendproc] = p;
-	    send_begin[nsendproc] = nsend;
-	    send_end[nsendproc++] = nsend + n;
-	  }
-	  nsend += n;
-	} else {
-	  nsend_self += n;
-	}
-	sendlist.add(p, lo, hi, n);
-      }
-      n = intersect(grid->sublo, grid->subhi, &boxlo[3*p], &boxhi[3*p],
-		    0, -1, grid->box[0], 0, 0, lo, hi, false);
-      if (n > 0) {
-	if (comm->me != p) {
-	  if (nrecvproc > 0 && recvproc[nrecvproc-1] == p) {
-	    recv_end[nrecvproc-1] += n;
-	  } else {
-	    recvproc[nrecvproc] = p;
-	    recv_begin[nrecvproc] = nrecv;
-	    recv_end[nrecvproc++] = nrecv + n;
-	  }
-	  nrecv += n;
-	} else {
-	  nrecv_self += n;
-	}
-	recvlist.add(p, lo, hi, n);
-      }
-      n = intersect(grid->sublo, grid->subhi, &boxlo[3*p], &boxhi[3*p],
-		    -1, 0, -grid->box[0], 0, 0, lo, hi, false);
-      if (n > 0) {
-	if (comm->me != p) {
-	  if (nsendproc > 0 && sendproc[nsendproc-1] == p) {
-	    send_end[nsendproc-1] += n;
-	  } else {
-	    sendproc[nsendproc] = p;
-	    send_begin[nsendproc] = nsend;
-	    send_end[nsendproc++] = nsend + n;
-	  }
-	  nsend += n;
-	} else {
-	  nsend_self += n;
-	}
-	sendlist.add(p, lo, hi, n);
-      }
-    }
-    if (grid->periodic[1]) {
-      int n = intersect(grid->sublo, grid->subhi, &boxlo[3*p], &boxhi[3*p],
-			0, -1, 0, -grid->box[1], 0, lo, hi, false);
-      if (n > 0) {
-	if (comm->me != p) {
-	  if (nrecvproc > 0 && recvproc[nrecvproc-1] == p) {
-	    recv_end[nrecvproc-1] += n;
-	  } else {
-	    recvproc[nrecvproc] = p;
-	    recv_begin[nrecvproc] = nrecv;
-	    recv_end[nrecvproc++] = nrecv + n;
-	  }
-	  nrecv += n;
-	} else {
-	  nrecv_self += n;
-	}
-	recvlist.add(p, lo, hi, n);
-      }
-      n = intersect(grid->sublo, grid->subhi, &boxlo[3*p], &boxhi[3*p],
-		    -1, 0, 0, grid->box[1], 0, lo, hi, false);
-      if (n > 0) {
-	if (comm->me != p) {
-	  if (nsendproc > 0 && sendproc[nsendproc-1] == p) {
-	    send_end[nsendproc-1] += n;
-	  } else {
-	    sendproc[nsendproc] = p;
-	    send_begin[nsendproc] = nsend;
-	    send_end[nsendproc++] = nsend + n;
-	  }
-	  nsend += n;
-	} else {
-	  nsend_self += n;
-	}
-	sendlist.add(p, lo, hi, n);
-      }
-      n = intersect(grid->sublo, grid->subhi, &boxlo[3*p], &boxhi[3*p],
-		    0, -1, 0, grid->box[1], 0, lo, hi, false);
-      if (n > 0) {
-	if (comm->me != p) {
-	  if (nrecvproc > 0 && recvproc[nrecvproc-1] == p) {
-	    recv_end[nrecvproc-1] += n;
-	  } else {
-	    recvproc[nrecvproc] = p;
-	    recv_begin[nrecvproc] = nrecv;
-	    recv_end[nrecvproc++] = nrecv + n;
-	  }
-	  nrecv += n;
-	} else {
-	  nrecv_self += n;
-	}
-	recvlist.add(p, lo, hi, n);
-      }
-      n = intersect(grid->sublo, grid->subhi, &boxlo[3*p], &boxhi[3*p],
-		    -1, 0, 0, -grid->box[1], 0, lo, hi, false);
-      if (n > 0) {
-	if (comm->me != p) {
-	  if (nsendproc > 0 && sendproc[nsendproc-1] == p) {
-	    send_end[nsendproc-1] += n;
-	  } else {
-	    sendproc[nsendproc] = p;
-	    send_begin[nsendproc] = nsend;
-	    send_end[nsendproc++] = nsend + n;
-	  }
-	  nsend += n;
-	} else {
-	  nsend_self += n;
-	}
-	sendlist.add(p, lo, hi, n);
-      }
-    }
-    if (grid->periodic[2]) {
-      int n = intersect(grid->sublo, grid->subhi, &boxlo[3*p], &boxhi[3*p],
-			0, -1, 0, 0, -grid->box[2], lo, hi, false);
-      if (n > 0) {
-	if (comm->me != p) {
-	  if (nrecvproc > 0 && recvproc[nrecvproc-1] == p) {
-	    recv_end[nrecvproc-1] += n;
-	  } else {
-	    recvproc[nrecvproc] = p;
-	    recv_begin[nrecvproc] = nrecv;
-	    recv_end[nrecvproc++] = nrecv + n;
-	  }
-	  nrecv += n;
-	} else {
-	  nrecv_self += n;
-	}
-	recvlist.add(p, lo, hi, n);
-      }
-      n = intersect(grid->sublo, grid->subhi, &boxlo[3*p], &boxhi[3*p],
-		    -1, 0, 0, 0, grid->box[2], lo, hi, false);
-      if (n > 0) {
-	if (comm->me != p) {
-	  if (nsendproc > 0 && sendproc[nsendproc-1] == p) {
-	    send_end[nsendproc-1] += n;
-	  } else {
-	    sendproc[nsendproc] = p;
-	    send_begin[nsendproc] = nsend;
-	    send_end[nsendproc++] = nsend + n;
+    // loop over proc p and its periodic images
+    // the diagonal images only fill edge and corner ghost cells, which are
+    //   only read by halo cells when there are several ghost layers
+    for (int sz = -grid->periodic[2]; sz <= grid->periodic[2]; sz++) {
+      for (int sy = -grid->periodic[1]; sy <= grid->periodic[1]; sy++) {
+	for (int sx = -grid->periodic[0]; sx <= grid->periodic[0]; sx++) {
+	  int nshift = abs(sx) + abs(sy) + abs(sz);
+	  if (nshift == 0 && comm->me == p) continue;
+	  if (nshift > 1 && grid->ghost == 1) continue;
+	  int xshift = sx * grid->box[0];
+	  int yshift = sy * grid->box[1];
+	  int zshift = sz * grid->box[2];
+	  int n = intersect(grid->sublo, grid->subhi, &boxlo[3*p], &boxhi[3*p],
+			    0, -grid->ghost, xshift, yshift, zshift, lo, hi, false);
+	  if (n > 0) {
+	    if (comm->me != p) {
+	      if (nrecvproc > 0 && recvproc[nrecvproc-1] == p) {
+		recv_end[nrecvproc-1] += n;
+	      } else {
+		recvproc[nrecvproc] = p;
+		recv_begin[nrecvproc] = nrecv;
+		recv_end[nrecvproc++] = nrecv + n;
+	      }
+	      nrecv += n;
+	    } else {
+	      nrecv_self += n;
+	    }
+	    recvlist.add(p, lo, hi, n);
 	  }
-	  nsend += n;
-	} else {
-	  nsend_self += n;
-	}
-	sendlist.add(p, lo, hi, n);
-      }
-      n = intersect(grid->sublo, grid->subhi, &boxlo[3*p], &boxhi[3*p],
-		    0, -1, 0, 0, grid->box[2], lo, hi, false);
-      if (n > 0) {
-	if (comm->me != p) {
-	  if (nrecvproc > 0 && recvproc[nrecvproc-1] == p) {
-	    recv_end[nrecvproc-1] += n;
-	  } else {
-	    recvproc[nrecvproc] = p;
-	    recv_begin[nrecvproc] = nrecv;
-	    recv_end[nrecvproc++] = nrecv + n;
+	  n = intersect(grid->sublo, grid->subhi, &boxlo[3*p], &boxhi[3*p],
+			-grid->ghost, 0, -xshift, -yshift, -zshift, lo, hi, false);
+	  if (n > 0) {
+	    if (comm->me != p) {
+	      if (nsendproc > 0 && sendproc[nsendproc-1] == p) {
+		send_end[nsendproc-1] += n;
+	      } else {
+		sendproc[nsendproc] = p;
+		send_begin[nsendproc] = nsend;
+		send_end[nsendproc++] = nsend + n;
+	      }
+	      nsend += n;
+	    } else {
+	      nsend_self += n;
+	    }
+	    sendlist.add(p, lo, hi, n);
 	  }
-	  nrecv += n;
-	} else {
-	  nrecv_self += n;
 	}
-	recvlist.add(p, lo, hi, n);
-      }
-      n = intersect(grid->sublo, grid->subhi, &boxlo[3*p], &boxhi[3*p],
-		    -1, 0, 0, 0, -grid->box[2], lo, hi, false);
-      if (n > 0) {
-	if (comm->me != p) {
-	  if (nsendproc > 0 && sendproc[nsendproc-1] == p) {
-	    send_end[nsendproc-1] += n;
-	  } else {
-	    sendproc[nsendproc] = p;
-	    send_begin[nsendproc] = nsend;
-	    send_end[nsendproc++] = nsend + n;
-	  }
-	  nsend += n;
-	} else {
-	  nsend_self += n;
-	}
-	sendlist.add(p, lo, hi, n);
       }
     }
   }
@@ -393,28 +273,143 @@ void CommGrid::setup()
       }
     }
   }
+
+  // order the cells of each proc by red-black colour, a stable partition
+  //   keeps send and recv lists matching
+  for (int p = 0; p < nrecvproc; p++)
+    recv_mid[p] = recv_begin[p] +
+      sort_color(recv_end[p] - recv_begin[p], &recv_cells[recv_begin[p]]);
+  for (int p = 0; p < nsendproc; p++)
+    send_mid[p] = send_begin[p] +
+      sort_color(send_end[p] - send_begin[p], &send_cells[send_begin[p]]);
+  nself_mid = sort_color(nrecv_self, recv_cells_self);
+  sort_color(nsend_self, send_cells_self);
   
   if (requests) delete [] requests;
   requests = new MPI_Request[nrecvproc];
+
+  if (grid->shared_comm) setup_shared();
+}
+
+/* ----------------------------------------------------------------------
+   allocate the shared memory window of the on-node sends and find the
+   cells sent to me in the windows of my on-node recv procs
+   the window is double buffered so that one node barrier per forward
+   comm is enough, a proc can only write the half its neighbours read
+   in the previous comm after they passed the barrier of the current one
+------------------------------------------------------------------------- */
+
+void CommGrid::setup_shared()
+{
+  free_shared();
+
+  nshm = 0;
+  for (int p = 0; p < nsendproc; p++) {
+    send_shm[p] = node_rank[sendproc[p]] != MPI_UNDEFINED;
+    if (!send_shm[p]) continue;
+    send_shm_begin[p] = nshm;
+    send_shm_mid[p] = nshm + send_mid[p] - send_begin[p];
+    nshm += send_end[p] - send_begin[p];
+  }
+
+  // receivers get the offsets of their cells in the sender's window
+  int *offsets = memory->create(offsets, 2*MAX(nrecvproc, 1), "comm_grid:offsets");
+  for (int p = 0; p < nrecvproc; p++) {
+    recv_shm[p] = node_rank[recvproc[p]] != MPI_UNDEFINED;
+    if (recv_shm[p])
+      MPI_Irecv(&offsets[2*p], 2, MPI_INT, recvproc[p], 0, world, &requests[p]);
+    else requests[p] = MPI_REQUEST_NULL;
+  }
+  for (int p = 0; p < nsendproc; p++) {
+    if (!send_shm[p]) continue;
+    int offset[2] = {send_shm_begin[p], send_shm_mid[p]};
+    MPI_Send(offset, 2, MPI_INT, sendproc[p], 0, world);
+  }
+  MPI_Waitall(nrecvproc, requests, MPI_STATUS_IGNORE);
+  for (int p = 0; p < nrecvproc; p++) {
+    recv_shm_begin[p] = offsets[2*p];
+    recv_shm_mid[p] = offsets[2*p+1];
+  }
+  memory->destroy(offsets);
+
+  MPI_Aint bytes = (MPI_Aint) 2 * nshm * max_size * sizeof(double);
+  MPI_Win_allocate_shared(bytes, sizeof(double), MPI_INFO_NULL, node,
+			  &buf_shm, &win);
+  for (int p = 0; p < nrecvproc; p++) {
+    if (!recv_shm[p]) continue;
+    MPI_Aint size;
+    int disp;
+    MPI_Win_shared_query(win, node_rank[recvproc[p]], &size, &disp,
+			 &recv_shm_buf[p]);
+    recv_shm_size[p] = size / (2 * sizeof(double));
+  }
+  MPI_Win_lock_all(MPI_MODE_NOCHECK, win);
+  shm_half = 0;
+}
+
+/* ---------------------------------------------------------------------- */
+
+void CommGrid::free_shared()
+{
+  if (win == MPI_WIN_NULL) return;
+  MPI_Win_unlock_all(win);
+  MPI_Win_free(&win);
+  buf_shm = NULL;
+}
+
+/* ----------------------------------------------------------------------
+   make the halos packed in my window visible to my on-node neighbours
+   and theirs to me
+------------------------------------------------------------------------- */
+
+void CommGrid::sync_shared()
+{
+  MPI_Win_sync(win);
+  MPI_Barrier(node);
+  MPI_Win_sync(win);
 }
 
 /* ---------------------------------------------------------------------- */
 
 void CommGrid::forward_comm()
 {
+  int shared = grid->shared_comm;
   for (int p = 0; p < nrecvproc; p++) {
+    if (shared && recv_shm[p]) {
+      requests[p] = MPI_REQUEST_NULL;
+      continue;
+    }
     MPI_Irecv(&buf_recv[recv_begin[p] * size_forward],
 	      (recv_end[p] - recv_begin[p]) * size_forward,
 	      MPI_DOUBLE, recvproc[p], 0, world, &requests[p]);
   }
   for (int p = 0; p < nsendproc; p++) {
+    if (shared && send_shm[p]) {
+      grid->gvec->pack_comm(send_end[p] - send_begin[p],
+			    &send_cells[send_begin[p]],
+			    &buf_shm[shm_half * nshm * max_size +
+				     send_shm_begin[p] * size_forward]);
+      continue;
+    }
     int n = grid->gvec->pack_comm(send_end[p] - send_begin[p],
 				  &send_cells[send_begin[p]],
 				  buf_send);
     MPI_Send(buf_send, n, MPI_DOUBLE, sendproc[p], 0, world);
   }
+  if (shared) {
+    sync_shared();
+    for (int p = 0; p < nrecvproc; p++) {
+      if (!recv_shm[p]) continue;
+      grid->gvec->unpack_comm(recv_end[p] - recv_begin[p],
+			      &recv_cells[recv_begin[p]],
+			      &recv_shm_buf[p][shm_half * recv_shm_size[p] +
+					       recv_shm_begin[p] * size_forward]);
+    }
+    shm_half = 1 - shm_half;
+  }
   MPI_Waitall(nrecvproc, requests, MPI_STATUS_IGNORE);
   for (int p = 0; p < nrecvproc; p++) {
+    if (shared && recv_shm[p]) continue;
     grid->gvec->unpack_comm(recv_end[p] - recv_begin[p],
 			    &recv_cells[recv_begin[p]],
 			    &buf_recv[recv_begin[p] * size_forward]);
@@ -423,6 +418,126 @@ void CommGrid::forward_comm()
   grid->gvec->unpack_comm(nrecv_self, recv_cells_self, buf_self);
 }
 
+/* ----------------------------------------------------------------------
+   forward comm of nsize per-cell arrays stored as array[nsize][ncells]
+   uses the same pattern and buffers as forward_comm()
+------------------------------------------------------------------------- */
+
+void CommGrid::forward_comm_array(int nsize, double **array)
+{
+  if (nsize > max_size)
+    error->all(FLERR, "Too many per-cell arrays in grid forward comm");
+
+  int shared = grid->shared_comm;
+  for (int p = 0; p < nrecvproc; p++) {
+    if (shared && recv_shm[p]) {
+      requests[p] = MPI_REQUEST_NULL;
+      continue;
+    }
+    MPI_Irecv(&buf_recv[recv_begin[p] * nsize],
+	      (recv_end[p] - recv_begin[p]) * nsize,
+	      MPI_DOUBLE, recvproc[p], 0, world, &requests[p]);
+  }
+  for (int p = 0; p < nsendproc; p++) {
+    double *buf = buf_send;
+    if (shared && send_shm[p])
+      buf = &buf_shm[shm_half * nshm * max_size + send_shm_begin[p] * nsize];
+    int m = 0;
+    for (int c = send_begin[p]; c < send_end[p]; c++)
+      for (int k = 0; k < nsize; k++)
+	buf[m++] = array[k][send_cells[c]];
+    if (buf == buf_send)
+      MPI_Send(buf_send, m, MPI_DOUBLE, sendproc[p], 0, world);
+  }
+  if (shared) {
+    sync_shared();
+    for (int p = 0; p < nrecvproc; p++) {
+      if (!recv_shm[p]) continue;
+      double *buf = &recv_shm_buf[p][shm_half * recv_shm_size[p] +
+				     recv_shm_begin[p] * nsize];
+      int m = 0;
+      for (int c = recv_begin[p]; c < recv_end[p]; c++)
+	for (int k = 0; k < nsize; k++)
+	  array[k][recv_cells[c]] = buf[m++];
+    }
+    shm_half = 1 - shm_half;
+  }
+  MPI_Waitall(nrecvproc, requests, MPI_STATUS_IGNORE);
+  for (int p = 0; p < nrecvproc; p++) {
+    if (shared && recv_shm[p]) continue;
+    int m = recv_begin[p] * nsize;
+    for (int c = recv_begin[p]; c < recv_end[p]; c++)
+      for (int k = 0; k < nsize; k++)
+	array[k][recv_cells[c]] = buf_recv[m++];
+  }
+  int m = 0;
+  for (int c = 0; c < nsend_self; c++)
+    for (int k = 0; k < nsize; k++)
+      buf_self[m++] = array[k][send_cells_self[c]];
+  m = 0;
+  for (int c = 0; c < nrecv_self; c++)
+    for (int k = 0; k < nsize; k++)
+      array[k][recv_cells_self[c]] = buf_self[m++];
+}
+
+/* ----------------------------------------------------------------------
+   forward comm of the cells of one red-black colour
+   sends half the data of forward_comm() for in-place colour sweeps
+------------------------------------------------------------------------- */
+
+void CommGrid::forward_comm_color(int color)
+{
+  int shared = grid->shared_comm;
+  for (int p = 0; p < nrecvproc; p++) {
+    if (shared && recv_shm[p]) {
+      requests[p] = MPI_REQUEST_NULL;
+      continue;
+    }
+    int begin = color ? recv_mid[p] : recv_begin[p];
+    int end = color ? recv_end[p] : recv_mid[p];
+    MPI_Irecv(&buf_recv[begin * size_forward], (end - begin) * size_forward,
+	      MPI_DOUBLE, recvproc[p], 0, world, &requests[p]);
+  }
+  for (int p = 0; p < nsendproc; p++) {
+    int begin = color ? send_mid[p] : send_begin[p];
+    int end = color ? send_end[p] : send_mid[p];
+    if (shared && send_shm[p]) {
+      int offset = color ? send_shm_mid[p] : send_shm_begin[p];
+      grid->gvec->pack_comm(end - begin, &send_cells[begin],
+			    &buf_shm[shm_half * nshm * max_size +
+				     offset * size_forward]);
+      continue;
+    }
+    int n = grid->gvec->pack_comm(end - begin, &send_cells[begin], buf_send);
+    MPI_Send(buf_send, n, MPI_DOUBLE, sendproc[p], 0, world);
+  }
+  if (shared) {
+    sync_shared();
+    for (int p = 0; p < nrecvproc; p++) {
+      if (!recv_shm[p]) continue;
+      int begin = color ? recv_mid[p] : recv_begin[p];
+      int end = color ? recv_end[p] : recv_mid[p];
+      int offset = color ? recv_shm_mid[p] : recv_shm_begin[p];
+      grid->gvec->unpack_comm(end - begin, &recv_cells[begin],
+			      &recv_shm_buf[p][shm_half * recv_shm_size[p] +
+					       offset * size_forward]);
+    }
+    shm_half = 1 - shm_half;
+  }
+  MPI_Waitall(nrecvproc, requests, MPI_STATUS_IGNORE);
+  for (int p = 0; p < nrecvproc; p++) {
+    if (shared && recv_shm[p]) continue;
+    int begin = color ? recv_mid[p] : recv_begin[p];
+    int end = color ? recv_end[p] : recv_mid[p];
+    grid->gvec->unpack_comm(end - begin, &recv_cells[begin],
+			    &buf_recv[begin * size_forward]);
+  }
+  int begin = color ? nself_mid : 0;
+  int end = color ? nrecv_self : nself_mid;
+  grid->gvec->pack_comm(end - begin, &send_cells_self[begin], buf_self);
+  grid->gvec->unpack_comm(end - begin, &recv_cells_self[begin], buf_self);
+}
+
 /* ---------------------------------------------------------------------- */
 
 void CommGrid::migrate()
@@ -439,9 +554,9 @@ void CommGrid::migrate()
   const double small = 1e-12;
   for (int i = 0; i < 3; i++) {
     newsublo[i] = static_cast<int>((domain->sublo[i] - domain->boxlo[i]) /
-				   grid->cell_size + small) - 1;
+				   grid->cell_size + small) - grid->ghost;
     newsubhi[i] = static_cast<int>((domain->subhi[i] - domain->boxlo[i]) /
-				   grid->cell_size + small) + 1;
+				   grid->cell_size + small) + grid->ghost;
     newsubbox[i] = newsubhi[i] - newsublo[i];
   }
 
@@ -470,7 +585,7 @@ void CommGrid::migrate()
   for (int p = 0; p < comm->nprocs; p++) {
     // receiving from other procs and self
     int n = intersect(newsublo, newsubhi, &boxlo[3*p], &boxhi[3*p],
-		      -1, -1, 0, 0, 0, lo, hi, true);
+		      -grid->ghost, -grid->ghost, 0, 0, 0, lo, hi, true);
     if (n > 0) {
       recvlist.add(p, lo, hi, n);
       recv_begin_[nrecvproc_] = nrecv_;
@@ -480,7 +595,7 @@ void CommGrid::migrate()
     }
     // sending to other procs and self
     n = intersect(grid->sublo, grid->subhi, &newboxlo[3*p], &newboxhi[3*p],
-		  -1, -1, 0, 0, 0, lo, hi, true);
+		  -grid->ghost, -grid->ghost, 0, 0, 0, lo, hi, true);
     if (n > 0) {
       sendlist.add(p, lo, hi, n);
       send_begin_[nsendproc_] = nsend_;
@@ -615,6 +730,49 @@ void CommGrid::grow_self(int n)
   buf_self = memory->create(buf_self, n * max_size, "comm_grid:buf_self");
 }
 
+/* ----------------------------------------------------------------------
+   return # of bytes of comm lists and buffers, including my part of the
+   shared memory window
+------------------------------------------------------------------------- */
+
+bigint CommGrid::memory_usage()
+{
+  bigint bytes = 0;
+  bytes += 8 * memory->usage(recvproc,comm->nprocs);
+  bytes += memory->usage(recv_cells,nrecv);
+  bytes += memory->usage(send_cells,nsend);
+  bytes += memory->usage(buf_recv,nrecv*max_size);
+  bytes += memory->usage(buf_send,nsend*max_size);
+  bytes += memory->usage(recv_cells_self,nrecv_self);
+  bytes += memory->usage(send_cells_self,nsend_self);
+  bytes += memory->usage(buf_self,nrecv_self*max_size);
+  if (node_rank) {
+    bytes += 8 * memory->usage(node_rank,comm->nprocs);
+    bytes += (bigint) comm->nprocs * sizeof(double *);
+    bytes += (bigint) 2 * nshm * max_size * sizeof(double);
+  }
+  return bytes;
+}
+
+/* ----------------------------------------------------------------------
+   stable partition of n cells into colour 0 followed by colour 1
+   return # of cells of colour 0
+------------------------------------------------------------------------- */
+
+int CommGrid::sort_color(int n, int *cells)
+{
+  int *tmp = memory->create(tmp, MAX(n, 1), "comm_grid:tmp");
+  int m = 0;
+  for (int i = 0; i < n; i++)
+    if (!grid->color(cells[i])) tmp[m++] = cells[i];
+  int nmid = m;
+  for (int i = 0; i < n; i++)
+    if (grid->color(cells[i])) tmp[m++] = cells[i];
+  memcpy(cells, tmp, n * sizeof(int));
+  memory->destroy(tmp);
+  return nmid;
+}
+
 /* ---------------------------------------------------------------------- */
 
 int CommGrid::intersect(int *lo1, int *hi1,
@@ -26,7 +26,10 @@ class CommGrid : protected Pointers {
   virtual void init();
   virtual void setup();                 // setup 3d comm pattern
   virtual void forward_comm();          // forward comm of grid data
+  void forward_comm_array(int, double **); // forward comm of per-cell arrays
+  void forward_comm_color(int);         // forward comm of one red-black colour
   virtual void migrate();               // move cells to new procs
+  virtual bigint memory_usage();
   
  protected:
   int size_forward;                     // # of data in forward comm
@@ -42,6 +45,7 @@ class CommGrid : protected Pointers {
   int *sendproc;
   int *recv_begin, *recv_end;
   int *send_begin, *send_end;
+  int *recv_mid, *send_mid;             // first cell of colour 1 of each proc
   int *recv_cells;
   int *send_cells;
   double *buf_recv;
@@ -51,13 +55,35 @@ class CommGrid : protected Pointers {
   int nsend_self;
   int *recv_cells_self;
   int *send_cells_self;
+  int nself_mid;                        // # of self cells of colour 0
   double *buf_self;
   
   MPI_Request *requests;
+
+  // grid_modify comm shared, halos of procs on the same node are packed
+  //   into a shared memory window and unpacked directly by the receiver
+  MPI_Comm node;                        // procs sharing memory with me
+  int *node_rank;                       // rank in node of each proc, or
+                                        // MPI_UNDEFINED if off-node
+  MPI_Win win;
+  double *buf_shm;                      // my part of the window
+  int shm_half;                         // half of the window in use
+  int nshm;                             // # of cells sent through buf_shm
+  int *send_shm, *recv_shm;             // 1 if a send/recv proc is on-node
+  int *send_shm_begin, *send_shm_mid;   // first cell of each on-node send
+                                        // proc and of its colour 1 in buf_shm
+  int *recv_shm_begin, *recv_shm_mid;   // same offsets in the sender's window
+  int *recv_shm_size;                   // size of a half of each such window
+  double **recv_shm_buf;                // window of each on-node recv proc
+
+  void setup_shared();
+  void free_shared();
+  void sync_shared();
   
   virtual void grow_recv(int);
   virtual void grow_send(int);
   virtual void grow_self(int);
+  int sort_color(int, int *);
   int intersect(int *, int *, int *, int *, int, int, int, int, int,
 		int *, int *, bool);
 };
@@ -12,15 +12,20 @@
 ------------------------------------------------------------------------- */
 
 #include <cstring>
+#include <cmath>
 #include "grid.h"
 #include "style_grid.h"
 #include "grid_vec.h"
 #include "comm.h"
 #include "comm_grid.h"
 #include "domain.h"
+#include "atom.h"
+#include "neighbor.h"
+#include "update.h"
 #include "math_const.h"
 #include "memory.h"
 #include "error.h"
+#include "force.h"
 
 using namespace LAMMPS_NS;
 using namespace MathConst;
@@ -46,10 +51,15 @@ Grid::Grid(LAMMPS *lmp) : Pointers(lmp)
   nmax = 0;
   nsubs = 0;
   sub_names = NULL;
+  level = NULL;
   cell_size = 1.0;
   box[0] = box[1] = box[2] = 0;
   ncells = 0;
+  ntotal = 0;
   periodic[0] = periodic[1] = periodic[2] = 0;
+  ghost = 1;
+  interp = NEAREST;
+  shared_comm = 0;
   
   mask = NULL;
   conc = NULL;
@@ -58,6 +68,12 @@ Grid::Grid(LAMMPS *lmp) : Pointers(lmp)
   growth = NULL;
   bulk = NULL;
 
+  nweight = 0;
+  wmax = 0;
+  wcell = NULL;
+  weight = NULL;
+  wstep = wlastcall = -1;
+
   monod_flag = reactor_flag = 0;
 }
 
@@ -69,12 +85,15 @@ Grid::~Grid()
   delete gvec;
   delete gvec_map;
 
+  memory->destroy(level);
   memory->destroy(mask);
   memory->destroy(dens);
   memory->destroy(conc);
   memory->destroy(reac);
   memory->destroy(growth);
   memory->destroy(bulk);
+  memory->destroy(wcell);
+  memory->destroy(weight);
 }
 
 /* ---------------------------------------------------------------------- */
@@ -85,7 +104,35 @@ void Grid::modify_params(int narg, char **arg)
     lmp->init();
     grid->setup();
     gvec->set(narg, arg);
-  }
+  } else if (strcmp(arg[0], "ghost") == 0) {
+    if (narg < 2) error->all(FLERR,"Illegal grid_modify command");
+    ghost = force->inumeric(FLERR,arg[1]);
+    if (ghost < 1) error->all(FLERR,"Illegal grid_modify command");
+    if (ghost > 1 && lmp->kokkos)
+      error->all(FLERR,"Grid ghost depth > 1 is not supported with KOKKOS");
+  } else if (strcmp(arg[0], "level") == 0) {
+    if (narg < 3) error->all(FLERR,"Illegal grid_modify command");
+    int isub = find(arg[1]);
+    if (isub < 0) error->all(FLERR,"Can't find substrate for grid_modify level");
+    level[isub] = force->inumeric(FLERR,arg[2]);
+    if (level[isub] < 1) error->all(FLERR,"Illegal grid_modify command");
+    if (level[isub] > 1 && lmp->kokkos)
+      error->all(FLERR,"Grid levels are not supported with KOKKOS");
+  } else if (strcmp(arg[0], "interp") == 0) {
+    if (narg < 2) error->all(FLERR,"Illegal grid_modify command");
+    if (strcmp(arg[1], "nearest") == 0) interp = NEAREST;
+    else if (strcmp(arg[1], "cic") == 0) interp = CIC;
+    else error->all(FLERR,"Illegal grid_modify command");
+    if (interp == CIC && lmp->kokkos)
+      error->all(FLERR,"Grid interp cic is not supported with KOKKOS");
+  } else if (strcmp(arg[0], "comm") == 0) {
+    if (narg < 2) error->all(FLERR,"Illegal grid_modify command");
+    if (strcmp(arg[1], "mpi") == 0) shared_comm = 0;
+    else if (strcmp(arg[1], "shared") == 0) shared_comm = 1;
+    else error->all(FLERR,"Illegal grid_modify command");
+    if (shared_comm && lmp->kokkos)
+      error->all(FLERR,"Grid comm shared is not supported with KOKKOS");
+  } else error->all(FLERR,"Illegal grid_modify command");
 }
 
 /* ----------------------------------------------------------------------
@@ -109,6 +156,11 @@ void Grid::create_gvec(const char *style, int narg, char **arg, int trysuffix)
   gvec->process_args(narg,arg);
   gvec->grow(1);
 
+  // all substrates are solved on the base grid unless coarsened
+  memory->destroy(level);
+  memory->create(level,nsubs,"grid:level");
+  for (int i = 0; i < nsubs; i++) level[i] = 1;
+
   if (sflag) {
     char estyle[256];
     if (sflag == 1) sprintf(estyle,"%s/%s",style,lmp->suffix);
@@ -211,3 +263,107 @@ int Grid::cell(double *x)
   return c[0] + c[1] * grid->subbox[0] +
     c[2] * grid->subbox[0] * grid->subbox[1];
 }
+
+/* ----------------------------------------------------------------------
+   red-black colour of local cell i, ghost cells take the colour of
+   their periodic image
+------------------------------------------------------------------------- */
+
+int Grid::color(int i)
+{
+  int c[3];
+  c[0] = i % subbox[0];
+  c[1] = (i / subbox[0]) % subbox[1];
+  c[2] = i / (subbox[0] * subbox[1]);
+  int sum = 0;
+  for (int d = 0; d < 3; d++)
+    sum += ((c[d] + sublo[d]) % box[d] + box[d]) % box[d];
+  return sum & 1;
+}
+
+/* ----------------------------------------------------------------------
+   cloud-in-cell stencil of a point: the 8 cells whose centers surround
+   it and their trilinear weights, stencils are clamped at non-periodic
+   boundaries so that no weight falls outside the box
+------------------------------------------------------------------------- */
+
+void Grid::cic(double *x, int *cells, double *w)
+{
+  int lo[3], hi[3];
+  double f[3];
+  for (int d = 0; d < 3; d++) {
+    double s = (x[d] - domain->boxlo[d]) / cell_size - 0.5;
+    int i = static_cast<int>(floor(s));
+    f[d] = s - i;
+    lo[d] = i;
+    hi[d] = i + 1;
+    if (!periodic[d]) {
+      lo[d] = MAX(0, MIN(lo[d], box[d] - 1));
+      hi[d] = MAX(0, MIN(hi[d], box[d] - 1));
+    }
+    // off-grid cells are marked by -1 below
+    lo[d] -= sublo[d];
+    hi[d] -= sublo[d];
+    if (lo[d] < 0 || lo[d] >= subbox[d]) lo[d] = -1;
+    if (hi[d] < 0 || hi[d] >= subbox[d]) hi[d] = -1;
+  }
+
+  for (int k = 0; k < 8; k++) {
+    int c0 = (k & 1) ? hi[0] : lo[0];
+    int c1 = (k & 2) ? hi[1] : lo[1];
+    int c2 = (k & 4) ? hi[2] : lo[2];
+    w[k] = ((k & 1) ? f[0] : 1.0 - f[0]) *
+      ((k & 2) ? f[1] : 1.0 - f[1]) *
+      ((k & 4) ? f[2] : 1.0 - f[2]);
+    if (c0 < 0 || c1 < 0 || c2 < 0) cells[k] = -1;
+    else cells[k] = c0 + c1 * subbox[0] + c2 * subbox[0] * subbox[1];
+  }
+}
+
+/* ----------------------------------------------------------------------
+   compute and cache the CIC stencils of the first n atoms
+------------------------------------------------------------------------- */
+
+void Grid::compute_weights(int n)
+{
+  if (n > wmax) {
+    wmax = n;
+    memory->destroy(wcell);
+    memory->destroy(weight);
+    memory->create(wcell, wmax, 8, "grid:wcell");
+    memory->create(weight, wmax, 8, "grid:weight");
+  }
+
+  double **x = atom->x;
+  for (int i = 0; i < n; i++)
+    cic(x[i], wcell[i], weight[i]);
+
+  nweight = n;
+  wstep = update->ntimestep;
+  wlastcall = neighbor->lastcall;
+}
+
+/* ----------------------------------------------------------------------
+   1 if the cached stencils of the first n atoms are still valid, atoms
+   keep their indices until the next reneighboring
+------------------------------------------------------------------------- */
+
+int Grid::weights_current(int n)
+{
+  return (n <= nweight && wstep == update->ntimestep &&
+	  wlastcall == neighbor->lastcall);
+}
+
+/* ----------------------------------------------------------------------
+   return # of bytes of allocated grid fields and stencils
+------------------------------------------------------------------------- */
+
+bigint Grid::memory_usage()
+{
+  bigint bytes = 0;
+  if (gvec) bytes += gvec->memory_usage();
+  bytes += memory->usage(level,nsubs);
+  bytes += memory->usage(wcell,wmax,8);
+  bytes += memory->usage(weight,wmax,8);
+  return bytes;
+}
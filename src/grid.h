@@ -32,13 +32,20 @@ class Grid : protected Pointers {
   int nmax;
   int nsubs;                  // # of substrates
   char **sub_names;           // substrate names
+  int *level;                 // coarsening factor of each substrate field
   double cell_size;
   int box[3];                 // # of global cells in each dimension
   int extbox[3];              // # of extended cells in each dimension
   int sublo[3], subhi[3];     // sub-box bounds in grid coordinates
   int subbox[3];              // # of cells on this proc in each dimension
-  int ncells;                 // total # of cells
+  int ncells;                 // total # of cells on this proc
+  bigint ntotal;              // total # of global cells
   int periodic[3];            // flag if x, y and z boundaries are periodic
+  int ghost;                  // # of ghost cell layers
+  int interp;                 // NEAREST or CIC particle-grid interpolation
+  int shared_comm;            // 1 if on-node halos use shared memory windows
+
+  enum {NEAREST, CIC};
   
   Grid(class LAMMPS *);
   virtual ~Grid();
@@ -49,6 +56,11 @@ class Grid : protected Pointers {
   void setup();
   int find(const char *);
   int cell(double *);
+  int color(int);
+  void cic(double *, int *, double *);
+  void compute_weights(int);
+  int weights_current(int);
+  bigint memory_usage();
   
   int *mask;
 
@@ -63,7 +75,16 @@ class Grid : protected Pointers {
   int reactor_flag;
   double *bulk;    // bulk concentration
 
+  // CIC stencils of atoms, shared by density deposition and growth gather
+  int nweight;      // # of atoms with cached stencils
+  int **wcell;      // 8 local cells of each stencil, -1 if off the grid
+  double **weight;  // trilinear weights of the stencil cells
+  bigint wstep;     // timestep the stencils were computed at
+
 private:
+  int wmax;
+  bigint wlastcall;
+
   template <typename T> static GridVec *gvec_creator(LAMMPS *);
 };
 
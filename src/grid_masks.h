@@ -26,6 +26,7 @@
 #define Z_PB_MASK      0x00000020 // Z positive boundary
 #define CORNER_MASK    0x00000100
 #define GHOST_MASK     0x00000200
+#define HALO_MASK      0x00000400 // ghost cell updated redundantly
 
 #define GMASK_MASK     0x00001000
 
@@ -73,6 +73,10 @@ void GridVec::init()
     error->all(FLERR,"KOKKOS package requires a kokkos enabled grid_style");
 
   const double small = 1e-12;
+  for (int i = 0; i < 3; i++) {
+    if (domain->prd[i] / grid->cell_size + small > MAXSMALLINT)
+      error->all(FLERR,"Too many grid cells in one dimension");
+  }
   grid->box[0] = static_cast<int>(domain->prd[0] / grid->cell_size + small);
   grid->box[1] = static_cast<int>(domain->prd[1] / grid->cell_size + small);
   grid->box[2] = static_cast<int>(domain->prd[2] / grid->cell_size + small);
@@ -88,18 +92,19 @@ void GridVec::init()
   // extend global grid size
   for (int i = 0; i < 3; i++)
     grid->extbox[i] = grid->box[i] + 2;
+  grid->ntotal = (bigint) grid->box[0] * grid->box[1] * grid->box[2];
 
   // Fitting initial domain decomposition to the grid
   for (int i = 0; i < comm->procgrid[0]; i++) {
-    int n = grid->box[0] * i * 1.0 / comm->procgrid[0];
+    int n = 1.0 * grid->box[0] * i / comm->procgrid[0];
     comm->xsplit[i] = (double) n / grid->box[0];
   }
   for (int i = 0; i < comm->procgrid[1]; i++) {
-    int n = grid->box[1] * i * 1.0 / comm->procgrid[1];
+    int n = 1.0 * grid->box[1] * i / comm->procgrid[1];
     comm->ysplit[i] = (double) n / grid->box[1];
   }
   for (int i = 0; i < comm->procgrid[2]; i++) {
-    int n = grid->box[2] * i * 1.0 / comm->procgrid[2];
+    int n = 1.0 * grid->box[2] * i / comm->procgrid[2];
     comm->zsplit[i] = (double) n / grid->box[2];
   }
   domain->set_local_box();
@@ -110,67 +115,71 @@ void GridVec::init()
 void GridVec::setup()
 {
   const double small = 1e-12;
+  const int nghost = grid->ghost;
   for (int i = 0; i < 3; i++) {
+    // ghost cells are filled from the nearest periodic image only
+    if (grid->periodic[i] && nghost > grid->box[i])
+      error->all(FLERR,"Grid ghost depth exceeds periodic grid size");
     grid->sublo[i] = static_cast<int>((domain->sublo[i] - domain->boxlo[i]) /
-				      grid->cell_size + small) - 1;
+				      grid->cell_size + small) - nghost;
     grid->subhi[i] = static_cast<int>((domain->subhi[i] - domain->boxlo[i]) /
-				      grid->cell_size + small) + 1;
+				      grid->cell_size + small) + nghost;
     grid->subbox[i] = grid->subhi[i] - grid->sublo[i];
   }
-  grid->ncells = grid->subbox[0] * grid->subbox[1] * grid->subbox[2];
+  bigint nlocal = (bigint) grid->subbox[0] * grid->subbox[1] * grid->subbox[2];
+  if (nlocal > MAXSMALLINT)
+    error->one(FLERR,"Per-processor grid is too big");
+  grid->ncells = nlocal;
 
   if (grid->ncells > grid->nmax) {
     grow(grid->ncells);
   }
 
   // setup mask
+  // the boundary layer is the first layer of cells outside the domain,
+  //   cells where it meets another boundary layer are corners
+  // with more than one ghost layer, cells beyond the boundary layer are
+  //   flagged as corners too, and ghost cells in all but the outermost
+  //   layer that lie inside the (periodic) domain are halo cells
   int *mask = grid->mask;
   for (int z = 0; z < grid->subbox[2]; z++) {
     for (int y = 0; y < grid->subbox[1]; y++) {
       for (int x = 0; x < grid->subbox[0]; x++) {
+	int l[3] = {x, y, z};
+	int depth = 0;
+	int nout = 0;
+	int far = 0;
+	int inside = 1;
+	for (int d = 0; d < 3; d++) {
+	  int c = grid->sublo[d] + l[d];
+	  depth = MAX(depth, nghost - l[d]);
+	  depth = MAX(depth, l[d] - (grid->subbox[d] - nghost - 1));
+	  if (c < 0 || c >= grid->box[d]) {
+	    // periodic images are regular cells for halo updates
+	    if (nghost == 1 || !grid->periodic[d]) nout++;
+	    if (!grid->periodic[d]) inside = 0;
+	  }
+	  if ((c < -1 || c > grid->box[d]) && !grid->periodic[d]) far = 1;
+	}
 	int m = 0;
-	if (x == 0 || y == 0 || z == 0 ||
-	    x == grid->subbox[0] - 1 ||
-	    y == grid->subbox[1] - 1 ||
-	    z == grid->subbox[2] - 1)
+	if (depth > 0)
 	  m |= GHOST_MASK;
-	if ((x == 0 && y == 0 &&
-	     grid->sublo[0] < 0 && grid->sublo[1] < 0) ||
-	    (x == 0 && z == 0 &&
-	     grid->sublo[0] < 0 && grid->sublo[2] < 0) ||
-	    (x == 0 && y == grid->subbox[1] - 1 &&
-	     grid->sublo[0] < 0 && grid->subhi[1] > grid->box[1]) ||
-	    (x == 0 && z == grid->subbox[2] - 1 &&
-	     grid->sublo[0] < 0 && grid->subhi[2] > grid->box[2]) ||
-	    (x == grid->subbox[0] - 1 && y == 0 &&
-	     grid->subhi[0] > grid->box[0] && grid->sublo[1] < 0) ||
-	    (x == grid->subbox[0] - 1 && z == 0 &&
-	     grid->subhi[0] > grid->box[0] && grid->sublo[2] < 0) ||
-	    (x == grid->subbox[0] - 1 && y == grid->subbox[1] - 1 &&
-	     grid->subhi[0] > grid->box[0] && grid->subhi[1] > grid->box[1]) ||
-	    (x == grid->subbox[0] - 1 && z == grid->subbox[2] - 1 &&
-	     grid->subhi[0] > grid->box[0] && grid->subhi[2] > grid->box[2]) ||
-	    (y == 0 && z == 0 &&
-	     grid->sublo[1] < 0 && grid->sublo[2] < 0) ||
-	    (y == 0 && z == grid->subbox[2] - 1 &&
-	     grid->sublo[1] < 0 && grid->subhi[2] > grid->box[2]) ||
-	    (y == grid->subbox[1] - 1 && z == 0 &&
-	     grid->subhi[1] > grid->box[1] && grid->sublo[2] < 0) ||
-	    (y == grid->subbox[1] - 1 && z == grid->subbox[2] - 1 &&
-	     grid->subhi[1] > grid->box[1] && grid->subhi[2] > grid->box[2]))
+	if (depth > 0 && depth < nghost && inside)
+	  m |= HALO_MASK;
+	if (nout > 1 || far)
 	  m |= CORNER_MASK;
 	else {
-	  if (grid->sublo[0] < 0 && x == 0)
+	  if (grid->sublo[0] + x == -1)
 	    m |= X_NB_MASK;
-	  if (grid->subhi[0] > grid->box[0] && x == grid->subbox[0] - 1)
+	  if (grid->sublo[0] + x == grid->box[0])
 	    m |= X_PB_MASK;
-	  if (grid->sublo[1] < 0 && y == 0)
+	  if (grid->sublo[1] + y == -1)
 	    m |= Y_NB_MASK;
-	  if (grid->subhi[1] > grid->box[1] && y == grid->subbox[1] - 1)
+	  if (grid->sublo[1] + y == grid->box[1])
 	    m |= Y_PB_MASK;
-	  if (grid->sublo[2] < 0 && z == 0)
+	  if (grid->sublo[2] + z == -1)
 	    m |= Z_NB_MASK;
-	  if (grid->subhi[2] > grid->box[2] && z == grid->subbox[2] - 1)
+	  if (grid->sublo[2] + z == grid->box[2])
 	    m |= Z_PB_MASK;
 	}
 	mask[x + y * grid->subbox[0] + z * grid->subbox[0] * grid->subbox[1]] = m;
@@ -44,6 +44,8 @@ class GridVec : protected Pointers {
   
   virtual void set(int, char **) = 0;
 
+  virtual bigint memory_usage() {return 0;}
+
  protected:
   int nmax;              // local copy of grid->nmax
 };
@@ -35,6 +35,8 @@
 #include "group.h"
 #include "input.h"
 #include "modify.h"
+#include "grid.h"
+#include "comm_grid.h"
 #include "neighbor.h"
 #include "output.h"
 #include "region.h"
@@ -324,6 +326,8 @@ void Info::command(int narg, char **arg)
     bytes += update->memory_usage();
     bytes += force->memory_usage();
     bytes += modify->memory_usage();
+    bytes += grid->memory_usage();
+    bytes += comm_grid->memory_usage();
     for (int i = 0; i < output->ndump; i++)
       bytes += output->dump[i]->memory_usage();
     double mbytes = bytes/1024.0/1024.0;
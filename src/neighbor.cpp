@@ -2189,6 +2189,51 @@ void Neighbor::set(int narg, char **arg)
   if (style == Neighbor::MULTI && lmp->citeme) lmp->citeme->add(cite_neigh_multi);
 }
 
+/* ----------------------------------------------------------------------
+   change the skin distance between two builds of a run
+   cutoffs are recomputed as in init() and copied to the Bin, Stencil and
+     Pair classes, caller must setup bins and rebuild all lists afterwards
+------------------------------------------------------------------------- */
+
+void Neighbor::reset_skin(double newskin)
+{
+  skin = newskin;
+  triggersq = 0.25*skin*skin;
+
+  int n = atom->ntypes;
+  double cutoff,delta,cut;
+  cutneighmin = BIG;
+  cutneighmax = 0.0;
+
+  for (int i = 1; i <= n; i++) {
+    cuttype[i] = cuttypesq[i] = 0.0;
+    for (int j = 1; j <= n; j++) {
+      if (force->pair) cutoff = sqrt(force->pair->cutsq[i][j]);
+      else cutoff = 0.0;
+      if (cutoff > 0.0) delta = skin;
+      else delta = 0.0;
+      cut = cutoff + delta;
+
+      cutneighsq[i][j] = cut*cut;
+      cuttype[i] = MAX(cuttype[i],cut);
+      cuttypesq[i] = MAX(cuttypesq[i],cut*cut);
+      cutneighmin = MIN(cutneighmin,cut);
+      cutneighmax = MAX(cutneighmax,cut);
+
+      if (force->pair && force->pair->ghostneigh) {
+        cut = force->pair->cutghost[i][j] + skin;
+        cutneighghostsq[i][j] = cut*cut;
+      } else cutneighghostsq[i][j] = cut*cut;
+    }
+  }
+  cutneighmaxsq = cutneighmax * cutneighmax;
+
+  for (int i = 0; i < nbin; i++) neigh_bin[i]->copy_neighbor_info();
+  for (int i = 0; i < nstencil; i++) neigh_stencil[i]->copy_neighbor_info();
+  for (int i = 0; i < nlist; i++)
+    if (neigh_pair[i]) neigh_pair[i]->copy_neighbor_info();
+}
+
 /* ----------------------------------------------------------------------
    reset timestamps in all NeignBin, NStencil, NPair classes
    so that neighbor lists will rebuild properly with timestep change
@@ -117,6 +117,7 @@ class Neighbor : protected Pointers {
   void build_one(class NeighList *list, int preflag=0);
                                     // create a one-time pairwise neigh list
   void set(int, char **);           // set neighbor style and skin distance
+  void reset_skin(double);          // change skin distance within a run
   void reset_timestep(bigint);      // reset of timestep counter
   void modify_params(int, char**);  // modify params that control builds
 
@@ -26,6 +26,8 @@
 #include "domain.h"
 #include "thermo.h"
 #include "modify.h"
+#include "grid.h"
+#include "comm_grid.h"
 #include "compute.h"
 #include "force.h"
 #include "dump.h"
@@ -842,6 +844,8 @@ void Output::memory_usage()
   bytes += update->memory_usage();
   bytes += force->memory_usage();
   bytes += modify->memory_usage();
+  bytes += grid->memory_usage();
+  bytes += comm_grid->memory_usage();
   for (int i = 0; i < ndump; i++) bytes += dump[i]->memory_usage();
 
   double mbytes = bytes/1024.0/1024.0;
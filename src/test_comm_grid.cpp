@@ -128,9 +128,9 @@ void TestCommGrid::run(int)
   for (int i = 0; i < grid->ncells; i++)
     conc[0][i] = 0;
 
-  for (int z = grid->sublo[2] + 1; z < grid->subhi[2] - 1; z++) {
-    for (int y = grid->sublo[1] + 1; y < grid->subhi[1] - 1; y++) {
-      for (int x = grid->sublo[0] + 1; x < grid->subhi[0] - 1; x++) {
+  for (int z = grid->sublo[2] + grid->ghost; z < grid->subhi[2] - grid->ghost; z++) {
+    for (int y = grid->sublo[1] + grid->ghost; y < grid->subhi[1] - grid->ghost; y++) {
+      for (int x = grid->sublo[0] + grid->ghost; x < grid->subhi[0] - grid->ghost; x++) {
   	int i = (x - grid->sublo[0]) + (y - grid->sublo[1]) * grid->subbox[0] +
   	  (z - grid->sublo[2]) * grid->subbox[0] * grid->subbox[1];
   	conc[0][i] = (x + 1) + (y + 1) * grid->extbox[0] +
@@ -219,53 +219,30 @@ bool TestCommGrid::check()
 	int i = (x - grid->sublo[0]) +
 	  (y - grid->sublo[1]) * grid->subbox[0] +
 	  (z - grid->sublo[2]) * grid->subbox[0] * grid->subbox[1];
-	int j = (x + 1) + (y + 1) * grid->extbox[0] +
-	  (z + 1) * grid->extbox[0] * grid->extbox[1];
-	if (mask[i] & CORNER_MASK) {
-	  continue;
-	} else if ((mask[i] & X_NB_MASK) && domain->xperiodic) {
-	  if (fabs(conc[0][i] - (j + grid->box[0])) > small) {
-	    result = true;
-	    fprintf(screen, "[%d] Wrong value at cell %d (-x periodic boundary): expected %d got %e\n",
-		    comm->me, i, j + grid->box[0], conc[0][i]);
-	  }
-	} else if ((mask[i] & X_PB_MASK) && domain->xperiodic) {
-	  if (fabs(conc[0][i] - (j - grid->box[0])) > small) {
-	    result = true;
-	    fprintf(screen, "[%d] Wrong value at cell %d (+x periodic boundary): expected %d got %e\n",
-		    comm->me, i, j - grid->box[0], conc[0][i]);
-	  }
-	} else if ((mask[i] & Y_NB_MASK) && domain->yperiodic) {
-	  if (fabs(conc[0][i] - (j + grid->extbox[0] * grid->box[1])) > small) {
-	    result = true;
-	    fprintf(screen, "[%d] Wrong value at cell %d (-y periodic boundary): expected %d got %e\n",
-		    comm->me, i, j + grid->extbox[0] * grid->box[1], conc[0][i]);
-	  }
-	} else if ((mask[i] & Y_PB_MASK) && domain->yperiodic) {
-	  if (fabs(conc[0][i] - (j - grid->extbox[0] * grid->box[1])) > small) {
-	    result = true;
-	    fprintf(screen, "[%d] Wrong value at cell %d (+y periodic boundary): expected %d got %e\n",
-		    comm->me, i, j - grid->extbox[0] * grid->box[1], conc[0][i]);
-	  }
-	} else if ((mask[i] & Z_NB_MASK) && domain->zperiodic) {
-	  if (fabs(conc[0][i] - (j + grid->extbox[0] * grid->extbox[1] * grid->box[2])) > small) {
-	    result = true;
-	    fprintf(screen, "[%d] Wrong value at cell %d (-z periodic boundary): expected %d got %e\n",
-		    comm->me, i, j + grid->extbox[0] * grid->extbox[1] * grid->box[2], conc[0][i]);
-	  }
-	} else if ((mask[i] & Z_PB_MASK) && domain->zperiodic) {
-	  if (fabs(conc[0][i] - (j - grid->extbox[0] * grid->extbox[1] * grid->box[2])) > small) {
-	    result = true;
-	    fprintf(screen, "[%d] Wrong value at cell %d (+z periodic boundary): expected %d got %e\n",
-		    comm->me, i, j - grid->extbox[0] * grid->extbox[1] * grid->box[2], conc[0][i]);
-	  }
-	} else if (!(mask[i] & GHOST_MASK)) {
-	  if (fabs(conc[0][i] - j) > small) {
-	    result = true;
-	    fprintf(screen, "[%d] Wrong value at cell %d (local domain): expected %d got %e\n",
-		    comm->me, i, j, conc[0][i]);
+	if (mask[i] & CORNER_MASK) continue;
+	// map the cell to its periodic image inside the domain,
+	//   cells outside non-periodic boundaries are not communicated
+	int c[3] = {x, y, z};
+	bool image = false;
+	bool outside = false;
+	for (int d = 0; d < 3; d++) {
+	  if (c[d] < 0 || c[d] >= grid->box[d]) {
+	    if (domain->periodicity[d]) {
+	      c[d] = (c[d] + grid->box[d]) % grid->box[d];
+	      image = true;
+	    } else outside = true;
 	  }
 	}
+	if (outside) continue;
+	int j = (c[0] + 1) + (c[1] + 1) * grid->extbox[0] +
+	  (c[2] + 1) * grid->extbox[0] * grid->extbox[1];
+	if (fabs(conc[0][i] - j) > small) {
+	  result = true;
+	  fprintf(screen, "[%d] Wrong value at cell %d (%s): expected %d got %e\n",
+		  comm->me, i, image ? "periodic boundary" :
+		  (mask[i] & GHOST_MASK) ? "ghost cell" : "local domain",
+		  j, conc[0][i]);
+	}
       }
     }
   }